@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <SPI.h>
+#include "Apa102Hd.h"
+#ifdef COLOR_LUT
+#include <ColorLut.h>
+#endif
+
+// Driver current for a pixel whose brightest channel has this high byte:
+// the smallest current with ( hi + 1 ) * 31 / current <= 256
+static const uint8_t currentForHigh[256] PROGMEM = {
+   1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,
+   3,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4,  4,  4,
+   4,  5,  5,  5,  5,  5,  5,  5,  5,  6,  6,  6,  6,  6,  6,  6,
+   6,  7,  7,  7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8,  8,
+   8,  8,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10, 10, 10, 10, 10,
+  10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12,
+  12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14,
+  14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 16, 16, 16,
+  16, 16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18,
+  18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20, 20, 20,
+  20, 20, 20, 20, 20, 21, 21, 21, 21, 21, 21, 21, 21, 22, 22, 22,
+  22, 22, 22, 22, 22, 23, 23, 23, 23, 23, 23, 23, 23, 24, 24, 24,
+  24, 24, 24, 24, 24, 24, 25, 25, 25, 25, 25, 25, 25, 25, 26, 26,
+  26, 26, 26, 26, 26, 26, 27, 27, 27, 27, 27, 27, 27, 27, 28, 28,
+  28, 28, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 29, 29, 30,
+  30, 30, 30, 30, 30, 30, 30, 31, 31, 31, 31, 31, 31, 31, 31, 31
+} ;
+
+// 31 * 256 / current, so pwm = ( value16 * currentScale ) >> 16 = value16 * 31 / ( current * 256 )
+static const uint16_t currentScale[32] PROGMEM = {
+     0, 7936, 3968, 2645, 1984, 1587, 1322, 1133,
+   992,  881,  793,  721,  661,  610,  566,  529,
+   496,  466,  440,  417,  396,  377,  360,  345,
+   330,  317,  305,  293,  283,  273,  264,  256
+} ;
+
+
+void Apa102Hd::begin( uint8_t numLeds, uint32_t spiHz ) {
+  _numLeds = numLeds ;
+  _spiHz = spiHz ;
+  SPI.begin() ;
+}
+
+
+uint8_t Apa102Hd::split( uint16_t r, uint16_t g, uint16_t b, uint8_t* pwm ) {
+  uint16_t brightest = max( r, max( g, b ) ) ;
+  uint8_t current = pgm_read_byte( currentForHigh + ( brightest >> 8 ) ) ;
+  uint32_t k = pgm_read_word( currentScale + current ) ;
+
+  pwm[0] = ( r * k ) >> 16 ;
+  pwm[1] = ( g * k ) >> 16 ;
+  pwm[2] = ( b * k ) >> 16 ;
+  return current ;
+}
+
+
+void Apa102Hd::show( const CRGB* leds, uint8_t brightness ) {
+  uint16_t bri = brightness ? brightness + 1 : 0 ;
+#ifndef COLOR_LUT
+  // Correction and brightness in one 0-65535 factor per channel
+  const CRGB correction = CRGB( APA102_HD_CORRECTION ) ;
+  uint16_t scale[3] = {
+    (uint16_t) min( 65535UL, (uint32_t) ( correction.r + 1 ) * bri ),
+    (uint16_t) min( 65535UL, (uint32_t) ( correction.g + 1 ) * bri ),
+    (uint16_t) min( 65535UL, (uint32_t) ( correction.b + 1 ) * bri )
+  } ;
+#endif
+
+  uint8_t* p = _buf ;
+  *p++ = 0 ; *p++ = 0 ; *p++ = 0 ; *p++ = 0 ;   // start frame
+
+  for ( uint8_t i = 0 ; i < _numLeds ; i++ ) {
+    uint8_t pwm[3] ;
+#ifdef COLOR_LUT
+    // The LUT already did gamma and white balance, in 16 bits
+    uint8_t current = split( ( (uint32_t) ColorLut::value16( 0, leds[i].r ) * bri ) >> 8,
+                             ( (uint32_t) ColorLut::value16( 1, leds[i].g ) * bri ) >> 8,
+                             ( (uint32_t) ColorLut::value16( 2, leds[i].b ) * bri ) >> 8, pwm ) ;
+#else
+    uint8_t current = split( ( (uint32_t) leds[i].r * scale[0] ) >> 8,
+                             ( (uint32_t) leds[i].g * scale[1] ) >> 8,
+                             ( (uint32_t) leds[i].b * scale[2] ) >> 8, pwm ) ;
+#endif
+    *p++ = 0xE0 | current ;
+    *p++ = pwm[2] ;   // APA102 wants BGR
+    *p++ = pwm[1] ;
+    *p++ = pwm[0] ;
+  }
+
+  // End frame: zeros, enough to clock the data through every LED
+  uint16_t tail = ( _numLeds + 15 ) / 16 ;
+  memset( p, 0, tail ) ;
+  p += tail ;
+
+  SPI.beginTransaction( SPISettings( _spiHz, MSBFIRST, SPI_MODE0 ) ) ;
+  SPI.transfer( _buf, p - _buf ) ;
+  SPI.endTransaction() ;
+}
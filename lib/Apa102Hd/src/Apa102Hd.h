@@ -0,0 +1,59 @@
+#ifndef Apa102Hd_H
+#define Apa102Hd_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   APA102 output that uses the 5-bit per-pixel driver current ("global
+   brightness") field, which FastLED always sends at 31.
+
+   Each pixel's colour is scaled to 16 bits (value * correction * brightness),
+   then split: the 5-bit current is the smallest one that still fits the
+   brightest channel into 8 bits of PWM, and each channel's PWM is scaled up
+   to match. At low brightness that keeps close to 8 bits of PWM per channel
+   where a plain brightness scale would leave a handful of steps, and unlike
+   dithering it costs nothing between frames.
+
+   The split comes from two tables in flash: current by the high byte of the
+   brightest channel, and a reciprocal per current so the PWM is a multiply
+   and shift (no divide on the Cortex-M0+).
+
+   Frames are packed straight from leds[] into the SPI buffer in that same
+   pass and sent over hardware SPI, so there's no FastLED controller for the
+   strip: MY_DATA_PIN/MY_CLOCK_PIN must be the SPI MOSI/SCK pins.
+
+   RAM: 4 * NUM_LEDS + 4 + NUM_LEDS / 16 bytes.
+*/
+
+#ifndef APA102_HD_SPI_HZ
+#define APA102_HD_SPI_HZ 12000000
+#endif
+
+// Same correction the FastLED path uses, applied here since FastLED doesn't see these LEDs.
+// Not used with COLOR_LUT, which has its own white balance.
+#ifndef APA102_HD_CORRECTION
+#define APA102_HD_CORRECTION TypicalLEDStrip
+#endif
+
+// start frame + 4 bytes per LED + end frame of at least NUM_LEDS/2 clock edges
+#define APA102_HD_BUFFER ( 4 + 4 * NUM_LEDS + ( NUM_LEDS + 15 ) / 16 )
+
+class Apa102Hd
+{
+  public:
+    void begin( uint8_t numLeds, uint32_t spiHz = APA102_HD_SPI_HZ ) ;
+
+    // Pack and send a frame; brightness is applied through the per-pixel current
+    void show( const CRGB* leds, uint8_t brightness ) ;
+
+    // Split one pixel's 16-bit channels into a current (returned) and 8-bit PWM per channel
+    static uint8_t split( uint16_t r, uint16_t g, uint16_t b, uint8_t* pwm ) ;
+
+  private:
+    uint8_t _numLeds = 0 ;
+    uint32_t _spiHz = APA102_HD_SPI_HZ ;
+    uint8_t _buf[APA102_HD_BUFFER] ;
+};
+
+#endif
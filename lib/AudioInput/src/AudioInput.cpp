@@ -0,0 +1,144 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "AudioInput.h"
+
+#ifdef AUDIO_PIN
+
+#ifndef CORE_TEENSY
+#error "Error: AUDIO_PIN samples from an IntervalTimer, which only Teensy has"
+#endif
+
+uint8_t AudioInput::_pin = 0 ;
+volatile int16_t AudioInput::_blocks[2][AUDIO_BLOCK] ;
+volatile uint8_t AudioInput::_fill = 0 ;
+volatile uint8_t AudioInput::_writing = 0 ;
+volatile bool AudioInput::_ready = false ;
+volatile uint32_t AudioInput::_dropped = 0 ;
+
+static IntervalTimer audioTimer ;
+
+// Last FFT bin of each band; bin n is n * AUDIO_SAMPLE_HZ / AUDIO_BLOCK (125 Hz at 8 kHz)
+static const uint8_t bandEnd[AUDIO_BANDS] = { 1, 2, 4, 6, 9, 14, 21, 31 } ;
+
+
+void AudioInput::begin( uint8_t pin ) {
+  _pin = pin ;
+  for ( uint8_t k = 0 ; k < AUDIO_BLOCK / 2 ; k++ ) {
+    uint16_t angle = k * ( 65536 / AUDIO_BLOCK ) ;
+    _cos[k] = cos16( angle ) ;
+    _sin[k] = sin16( angle ) ;
+  }
+  audioTimer.begin( sample, 1000000 / AUDIO_SAMPLE_HZ ) ;
+}
+
+
+void AudioInput::sample() {
+  _blocks[_writing][_fill] = analogRead( _pin ) ;
+  if ( ++_fill < AUDIO_BLOCK ) return ;
+  _fill = 0 ;
+  if ( _ready ) {
+    _dropped++ ;         // the other one is still waiting: go round this one again
+  } else {
+    _writing ^= 1 ;
+    _ready = true ;
+  }
+}
+
+
+bool AudioInput::poll() {
+  if ( ! _ready ) return false ;
+  uint32_t start = micros() ;
+  analyse( _blocks[_writing ^ 1] ) ;
+  _lastMicros = micros() - start ;
+  return true ;
+}
+
+
+void AudioInput::analyse( volatile const int16_t* block ) {
+  // Copy out first, so the interrupt can have the block back
+  int32_t sum = 0 ;
+  for ( uint8_t i = 0 ; i < AUDIO_BLOCK ; i++ ) {
+    _re[i] = block[i] ;
+    sum += _re[i] ;
+  }
+  _ready = false ;
+
+  // DC off, 10-bit samples up to Q15, Hann window: ( 1 - cos ) / 2
+  int16_t dc = sum / AUDIO_BLOCK ;
+  for ( uint8_t i = 0 ; i < AUDIO_BLOCK ; i++ ) {
+    int16_t c = i < AUDIO_BLOCK / 2 ? _cos[i] : -_cos[i - AUDIO_BLOCK / 2] ;
+    int32_t window = ( 32767 - c ) >> 1 ;
+    _re[i] = ( (int32_t) ( _re[i] - dc ) * 32 * window ) >> 15 ;
+    _im[i] = 0 ;
+  }
+
+  fft() ;
+
+  uint8_t bin = 1 ;
+  uint32_t total = 0 ;
+  uint8_t over = 0 ;
+  for ( uint8_t b = 0 ; b < AUDIO_BANDS ; b++ ) {
+    uint32_t energy = 0 ;
+    for ( ; bin <= bandEnd[b] ; bin++ ) {
+      // |z| ~ max + min / 2, close enough for levels
+      uint16_t re = abs( _re[bin] ) ;
+      uint16_t im = abs( _im[bin] ) ;
+      energy += re > im ? re + ( im >> 1 ) : im + ( re >> 1 ) ;
+    }
+    if ( energy > 0xFFFF ) energy = 0xFFFF ;
+    total += energy ;
+
+    // Automatic gain: jump up to a louder band, sink back slowly (a few seconds)
+    if ( energy > _gain ) _gain = energy ;
+    uint16_t level = energy * 255 / _gain ;
+    _level[b] = level ;
+    _peak[b] = max( (int) level, _peak[b] - AUDIO_PEAK_DECAY ) ;
+
+    // Onset: half as loud again as this band has been lately, first block of it only
+    if ( energy > AUDIO_FLOOR && energy > _average[b] + ( _average[b] >> 1 ) ) {
+      over |= 1 << b ;
+      if ( ! ( _rising & ( 1 << b ) ) ) _onsets |= 1 << b ;
+    }
+    _average[b] += ( (int32_t) energy - _average[b] ) >> 3 ;
+  }
+  _rising = over ;
+  if ( total > _volumeGain ) _volumeGain = total ;
+  _volume = total * 255 / _volumeGain ;
+
+  if ( _gain > AUDIO_FLOOR ) _gain -= ( _gain >> 9 ) + 1 ;
+  if ( _volumeGain > AUDIO_FLOOR ) _volumeGain -= ( _volumeGain >> 9 ) + 1 ;
+}
+
+
+// In place, radix 2, decimation in time. Every stage halves its outputs, so
+// a full-scale input can't overflow; the result is the spectrum / AUDIO_BLOCK.
+void AudioInput::fft() {
+  for ( uint8_t i = 1, j = 0 ; i < AUDIO_BLOCK ; i++ ) {
+    uint8_t bit = AUDIO_BLOCK >> 1 ;
+    for ( ; j & bit ; bit >>= 1 ) j ^= bit ;
+    j ^= bit ;
+    if ( i < j ) {
+      int16_t t = _re[i] ; _re[i] = _re[j] ; _re[j] = t ;   // _im is all 0 still
+    }
+  }
+
+  for ( uint8_t len = 2 ; len <= AUDIO_BLOCK ; len <<= 1 ) {
+    uint8_t half = len >> 1 ;
+    uint8_t step = AUDIO_BLOCK / len ;
+    for ( uint8_t k = 0 ; k < half ; k++ ) {
+      int32_t wr = _cos[k * step] ;
+      int32_t wi = -_sin[k * step] ;
+      for ( uint8_t a = k ; a < AUDIO_BLOCK ; a += len ) {
+        uint8_t b = a + half ;
+        int16_t tr = ( wr * _re[b] - wi * _im[b] ) >> 15 ;
+        int16_t ti = ( wr * _im[b] + wi * _re[b] ) >> 15 ;
+        _re[b] = ( _re[a] - tr ) >> 1 ;
+        _im[b] = ( _im[a] - ti ) >> 1 ;
+        _re[a] = ( _re[a] + tr ) >> 1 ;
+        _im[a] = ( _im[a] + ti ) >> 1 ;
+      }
+    }
+  }
+}
+
+#endif
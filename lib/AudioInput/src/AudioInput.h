@@ -0,0 +1,91 @@
+#ifndef AudioInput_H
+#define AudioInput_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   A microphone (electret with an amp, biased at half supply) on an analog
+   pin, turned into a few numbers per band that routines read at frame rate.
+
+   A timer interrupt takes AUDIO_SAMPLE_HZ samples a second into one of two
+   blocks of AUDIO_BLOCK; when a block is full it swaps to the other one and
+   poll(), from loop(), picks the full one up. If poll() falls behind, the
+   interrupt keeps overwriting the block it's on rather than the one being
+   worked on, so a late block is dropped whole instead of torn.
+
+   Each block: DC removed, Hann window, 64-point fixed-point FFT (Q15, each
+   stage halved so nothing overflows), then the 31 bins above DC summed into
+   AUDIO_BANDS bands from 125 Hz to 4 kHz, wider towards the top. Per band:
+
+   - level(): energy against a slowly falling maximum (automatic gain), 0 - 255
+   - peak(): the highest level lately, falling by AUDIO_PEAK_DECAY per block
+   - onsets(): a bit per band that rose well above its own recent average,
+     kept until read, so a routine drawing every 20 ms still sees an 8 ms beat
+
+   All integer maths with 16-bit samples, sized for the Cortex-M0+ of the
+   Teensy LC (no FPU, no 32x32 multiply-accumulate); lastMicros() is how long
+   the last block took. The sample timer is an IntervalTimer, so Teensy only.
+
+   analogRead() runs in the interrupt, so nothing else can use the ADC: no
+   POWER_BATTERY_PIN with AUDIO_PIN.
+*/
+
+#ifndef AUDIO_SAMPLE_HZ
+#define AUDIO_SAMPLE_HZ 8000
+#endif
+#define AUDIO_BLOCK 64          // FFT size; the band edges below assume 64
+#define AUDIO_BANDS 8
+#ifndef AUDIO_FLOOR
+#define AUDIO_FLOOR 400         // band energy below this is noise, whatever the gain
+#endif
+#ifndef AUDIO_PEAK_DECAY
+#define AUDIO_PEAK_DECAY 4
+#endif
+
+class AudioInput
+{
+  public:
+    void begin( uint8_t pin ) ;
+
+    // Analyse the block that filled up since the last call, if any; from loop()
+    bool poll() ;
+
+    uint8_t level( uint8_t band ) { return _level[band] ; }
+    uint8_t peak( uint8_t band ) { return _peak[band] ; }
+    uint8_t volume() { return _volume ; }     // all bands together, with its own gain
+    // Bands with an onset since the last call (bit 0 = lowest), and clear them
+    uint8_t onsets() { uint8_t o = _onsets ; _onsets = 0 ; return o ; }
+
+    uint32_t lastMicros() { return _lastMicros ; }
+    uint32_t droppedBlocks() { return _dropped ; }
+
+  private:
+    static void sample() ;
+    void analyse( volatile const int16_t* block ) ;
+    void fft() ;
+
+    static uint8_t _pin ;
+    static volatile int16_t _blocks[2][AUDIO_BLOCK] ;
+    static volatile uint8_t _fill ;       // next sample in _blocks[_writing]
+    static volatile uint8_t _writing ;
+    static volatile bool _ready ;         // _blocks[!_writing] is full and not analysed yet
+    static volatile uint32_t _dropped ;
+
+    int16_t _cos[AUDIO_BLOCK / 2] ;       // twiddles, Q15
+    int16_t _sin[AUDIO_BLOCK / 2] ;
+    int16_t _re[AUDIO_BLOCK] ;
+    int16_t _im[AUDIO_BLOCK] ;
+
+    uint16_t _gain = AUDIO_FLOOR ;        // energy that counts as full level
+    uint32_t _volumeGain = AUDIO_FLOOR ;  // the same for all bands together
+    uint16_t _average[AUDIO_BANDS] ;      // recent energy per band, for onsets
+    uint8_t _level[AUDIO_BANDS] ;
+    uint8_t _peak[AUDIO_BANDS] ;
+    uint8_t _volume = 0 ;
+    uint8_t _onsets = 0 ;
+    uint8_t _rising = 0 ;                 // bands that were over their average last block
+    uint32_t _lastMicros = 0 ;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <Arduino.h>
+#include "ButtonInput.h"
+
+uint8_t ButtonInput::_modePin = 0 ;
+int8_t ButtonInput::_bpmPin = -1 ;
+ButtonInput::Edge ButtonInput::_edges[BUTTON_QUEUE_SIZE] ;
+volatile uint8_t ButtonInput::_head = 0 ;
+volatile uint8_t ButtonInput::_tail = 0 ;
+
+
+// Whether the pin can have a pin-change interrupt at all. The Teensy LC core
+// says yes for every pin, but ports B and E (pins 0, 1, 16 - 19, 24 - 26)
+// have no pin interrupts and attachInterrupt() quietly does nothing.
+static bool hasInterrupt( uint8_t pin ) {
+#if defined(__MKL26Z64__)
+  return ( pin >= 2 && pin <= 15 ) || ( pin >= 20 && pin <= 23 ) ;
+#else
+  return digitalPinToInterrupt( pin ) != NOT_AN_INTERRUPT ;
+#endif
+}
+
+
+void ButtonInput::begin( uint8_t modePin, int8_t bpmPin, ButtonHandler handler ) {
+  _modePin = modePin ;
+  _bpmPin = bpmPin ;
+  _handler = handler ;
+
+  pinMode( modePin, INPUT_PULLUP ) ;
+  _buttons[MODE].down = digitalRead( modePin ) == LOW ;
+  if ( hasInterrupt( modePin ) ) attachInterrupt( digitalPinToInterrupt( modePin ), onModeEdge, CHANGE ) ;
+
+  if ( bpmPin >= 0 ) {
+    pinMode( bpmPin, INPUT_PULLUP ) ;
+    _buttons[BPM].down = digitalRead( bpmPin ) == LOW ;
+    if ( hasInterrupt( bpmPin ) ) attachInterrupt( digitalPinToInterrupt( bpmPin ), onBpmEdge, CHANGE ) ;
+  }
+}
+
+
+BUTTON_ISR void ButtonInput::onModeEdge() {
+  queue( MODE, _modePin ) ;
+}
+
+
+BUTTON_ISR void ButtonInput::onBpmEdge() {
+  queue( BPM, _bpmPin ) ;
+}
+
+
+BUTTON_ISR void ButtonInput::queue( uint8_t source, uint8_t pin ) {
+  uint8_t next = ( _head + 1 ) & ( BUTTON_QUEUE_SIZE - 1 ) ;
+  if ( next == _tail ) return ;   // full
+  Edge& edge = _edges[_head] ;
+  edge.us = micros() ;
+  edge.source = source ;
+  edge.down = digitalRead( pin ) == LOW ;
+  _head = next ;   // publish only once the edge is complete
+}
+
+
+void ButtonInput::poll() {
+  while ( _tail != _head ) {
+    handleEdge( _edges[_tail] ) ;
+    _tail = ( _tail + 1 ) & ( BUTTON_QUEUE_SIZE - 1 ) ;
+  }
+
+  // Decisions that wait for time to pass rather than for an edge
+  uint32_t now = micros() ;
+
+  // Once a button has been quiet for the debounce time, its pin level is the
+  // truth: this catches a last edge that fell inside the debounce window, and
+  // is the only way pins without an interrupt are read at all
+  sample( MODE, _modePin, now ) ;
+  if ( _bpmPin >= 0 ) sample( BPM, _bpmPin, now ) ;
+
+  if ( _buttons[MODE].down && ! _longSent && now - _pressedAt >= BUTTON_LONG_MS * 1000UL ) {
+    _longSent = true ;
+    _shortPending = false ;
+    _handler( BUTTON_LONG, now ) ;
+  }
+  if ( _shortPending && ! _buttons[MODE].down && now - _releasedAt >= BUTTON_DOUBLE_MS * 1000UL ) {
+    _shortPending = false ;
+    _handler( BUTTON_SHORT, _releasedAt ) ;
+  }
+}
+
+
+void ButtonInput::sample( uint8_t source, uint8_t pin, uint32_t now ) {
+  if ( now - _buttons[source].lastEdge < BUTTON_DEBOUNCE_US ) return ;
+  Edge edge = { now, source, digitalRead( pin ) == LOW } ;
+  handleEdge( edge ) ;
+}
+
+
+void ButtonInput::handleEdge( const Edge& edge ) {
+  Button& button = _buttons[edge.source] ;
+  if ( edge.down == button.down || edge.us - button.lastEdge < BUTTON_DEBOUNCE_US ) return ;
+  button.down = edge.down ;
+  button.lastEdge = edge.us ;
+
+  if ( edge.source == BPM ) {
+    if ( edge.down ) _handler( BUTTON_TAP, edge.us ) ;
+    return ;
+  }
+
+  if ( edge.down ) {
+    _pressedAt = edge.us ;
+    _longSent = false ;
+    _secondPress = _shortPending ;
+    return ;
+  }
+
+  // Released
+  if ( _longSent ) return ;
+  if ( _secondPress ) {
+    _shortPending = false ;
+    _secondPress = false ;
+    _handler( BUTTON_DOUBLE, edge.us ) ;
+  } else {
+    _shortPending = true ;
+    _releasedAt = edge.us ;
+  }
+}
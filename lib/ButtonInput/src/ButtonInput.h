@@ -0,0 +1,105 @@
+#ifndef ButtonInput_H
+#define ButtonInput_H
+
+#include <Arduino.h>
+
+/*
+   Mode and BPM buttons on pin-change interrupts instead of a polling task.
+
+   The interrupt only stores the edge: micros() and the pin level, in a small
+   ring buffer. The ISR is the only writer of the head index and poll() the
+   only writer of the tail, so no interrupts have to be turned off to read it.
+   poll() runs from loop() and does everything else:
+
+   - debounce: edges within BUTTON_DEBOUNCE_US of the last accepted edge on
+     the same button, or that don't change its level, are dropped
+   - mode button: a press held for BUTTON_LONG_MS is BUTTON_LONG (reported
+     while still held); two short presses within BUTTON_DOUBLE_MS are
+     BUTTON_DOUBLE; otherwise a short press is BUTTON_SHORT, reported once
+     the double-press window has passed
+   - BPM button: every press is BUTTON_TAP, with the time of the edge, so
+     tap timing isn't rounded to a polling interval
+
+   If the queue overflows the newest edges are lost; at BUTTON_QUEUE_SIZE
+   edges per poll() that only happens to a very noisy contact.
+
+   Every poll() also reads the pins of buttons that have had no accepted edge
+   for BUTTON_DEBOUNCE_US. If an edge was dropped as bounce and it was the
+   last one, the button would otherwise stay in the wrong state. Pins that
+   can't interrupt (on the Teensy LC: 0, 1, 16 - 19, 24 - 26) get no edges
+   queued at all and are read this way only, at the rate loop() runs.
+*/
+
+#ifndef BUTTON_DEBOUNCE_US
+#define BUTTON_DEBOUNCE_US 15000
+#endif
+#ifndef BUTTON_LONG_MS
+#define BUTTON_LONG_MS 600
+#endif
+#ifndef BUTTON_DOUBLE_MS
+#define BUTTON_DOUBLE_MS 300
+#endif
+#ifndef BUTTON_QUEUE_SIZE
+#define BUTTON_QUEUE_SIZE 16    // power of two
+#endif
+
+// ESP8266 interrupt handlers have to be in IRAM
+#ifdef ESP8266
+#define BUTTON_ISR ICACHE_RAM_ATTR
+#else
+#define BUTTON_ISR
+#endif
+
+enum ButtonEvent { BUTTON_SHORT, BUTTON_LONG, BUTTON_DOUBLE, BUTTON_TAP } ;
+
+// 'atMicros' is the micros() of the edge that decided the event
+typedef void (*ButtonHandler)( ButtonEvent event, uint32_t atMicros ) ;
+
+class ButtonInput
+{
+  public:
+    // Pins are INPUT_PULLUP, pressed = LOW. bpmPin < 0: no BPM button
+    void begin( uint8_t modePin, int8_t bpmPin, ButtonHandler handler ) ;
+
+    // Handle the edges queued since the last call; from loop()
+    void poll() ;
+
+  private:
+    enum Source { MODE, BPM } ;
+
+    struct Edge
+    {
+      uint32_t us ;
+      uint8_t source ;
+      bool down ;
+    };
+
+    struct Button
+    {
+      bool down ;
+      uint32_t lastEdge ;   // micros() of the last accepted edge
+    };
+
+    static void onModeEdge() ;
+    static void onBpmEdge() ;
+    static void queue( uint8_t source, uint8_t pin ) ;
+
+    void sample( uint8_t source, uint8_t pin, uint32_t now ) ;
+    void handleEdge( const Edge& edge ) ;
+
+    static uint8_t _modePin ;
+    static int8_t _bpmPin ;
+    static Edge _edges[BUTTON_QUEUE_SIZE] ;
+    static volatile uint8_t _head ;   // written by the ISR
+    static volatile uint8_t _tail ;   // written by poll()
+
+    ButtonHandler _handler = NULL ;
+    Button _buttons[2] ;
+    uint32_t _pressedAt = 0 ;     // mode button: micros() of the press
+    uint32_t _releasedAt = 0 ;    // mode button: micros() of a short press waiting for a second one
+    bool _longSent = false ;
+    bool _shortPending = false ;
+    bool _secondPress = false ;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "ColorLut.h"
+
+// Compile-time pow() for the tables: pow( x, g ) = exp( g * ln( x ) ).
+// C++11 constexpr, so one return statement each and recursion for loops.
+
+#define COLOR_LUT_LN2 0.6931471805599453
+
+// ln( x ) = 2 * atanh( y ), y = ( x - 1 ) / ( x + 1 ); |y| <= 1/3 for x in [0.5, 1]
+constexpr double lutAtanh( double y2, double term, int k ) {
+  return k > 12 ? 0 : term / ( 2 * k + 1 ) + lutAtanh( y2, term * y2, k + 1 ) ;
+}
+
+constexpr double lutLn( double x ) {
+  return x < 0.5 ? lutLn( x * 2 ) - COLOR_LUT_LN2
+                 : 2 * lutAtanh( ( ( x - 1 ) / ( x + 1 ) ) * ( ( x - 1 ) / ( x + 1 ) ), ( x - 1 ) / ( x + 1 ), 0 ) ;
+}
+
+// exp( z ) for z <= 0: halve until small, Taylor series, square back up
+constexpr double lutExpTaylor( double z, double term, int k ) {
+  return k > 12 ? 0 : term + lutExpTaylor( z, term * z / ( k + 1 ), k + 1 ) ;
+}
+
+constexpr double lutSquare( double v ) {
+  return v * v ;
+}
+
+constexpr double lutExp( double z ) {
+  return z < -0.5 ? lutSquare( lutExp( z / 2 ) ) : lutExpTaylor( z, 1.0, 0 ) ;
+}
+
+constexpr uint16_t lutEntry( int i, double gamma, int whiteBalance ) {
+  return i == 0 ? 0 : (uint16_t) ( 65535.0 * lutExp( gamma * lutLn( i / 255.0 ) ) * whiteBalance / 255.0 + 0.5 ) ;
+}
+
+#define COLOR_LUT_4(E, i)    E(i), E(i + 1), E(i + 2), E(i + 3)
+#define COLOR_LUT_16(E, i)   COLOR_LUT_4(E, i), COLOR_LUT_4(E, i + 4), COLOR_LUT_4(E, i + 8), COLOR_LUT_4(E, i + 12)
+#define COLOR_LUT_64(E, i)   COLOR_LUT_16(E, i), COLOR_LUT_16(E, i + 16), COLOR_LUT_16(E, i + 32), COLOR_LUT_16(E, i + 48)
+#define COLOR_LUT_256(E)     COLOR_LUT_64(E, 0), COLOR_LUT_64(E, 64), COLOR_LUT_64(E, 128), COLOR_LUT_64(E, 192)
+
+#define COLOR_LUT_R(i) lutEntry( i, COLOR_LUT_GAMMA_R, COLOR_LUT_WB_R )
+#define COLOR_LUT_G(i) lutEntry( i, COLOR_LUT_GAMMA_G, COLOR_LUT_WB_G )
+#define COLOR_LUT_B(i) lutEntry( i, COLOR_LUT_GAMMA_B, COLOR_LUT_WB_B )
+
+// constexpr: evaluated by the compiler, so this is plain data in flash
+constexpr uint16_t colorLutTable[3][256] PROGMEM = {
+  { COLOR_LUT_256(COLOR_LUT_R) },
+  { COLOR_LUT_256(COLOR_LUT_G) },
+  { COLOR_LUT_256(COLOR_LUT_B) }
+} ;
+
+static_assert( lutEntry( 255, 2.2, 255 ) == 65535, "ColorLut: full scale must stay full scale" ) ;
+static_assert( lutEntry( 128, 2.0, 255 ) > 16500 && lutEntry( 128, 2.0, 255 ) < 16600, "ColorLut: pow() is off" ) ;
+
+
+uint16_t ColorLut::value16( uint8_t channel, uint8_t value ) {
+  return pgm_read_word( &colorLutTable[channel][value] ) ;
+}
+
+
+void ColorLut::begin( CLEDController* controller, const CRGB* leds, uint8_t numLeds ) {
+  _leds = leds ;
+  _numLeds = numLeds ;
+  // Mirrored strips (STRIPS_MIRROR) are registered after ours and show the same buffer
+  for ( CLEDController* c = controller ; c ; c = c->next() ) {
+    c->setLeds( _out, numLeds ) ;
+  }
+}
+
+
+#ifdef COLOR_LUT_FUSED
+void ColorLut::rebuild( uint8_t brightness ) {
+  uint32_t scale = brightness ? brightness + 1 : 0 ;
+  for ( uint8_t c = 0 ; c < 3 ; c++ ) {
+    for ( uint16_t v = 0 ; v < 256 ; v++ ) {
+      // Truncated like the plain path's >> 8 and scale8(): rounded, full scale at 255 would be 256
+      _fused[c][v] = ( value16( c, v ) * scale ) >> 16 ;
+    }
+  }
+  _fusedBrightness = brightness ;
+}
+#endif
+
+
+void ColorLut::show( uint8_t brightness ) {
+  const uint8_t* in = (const uint8_t*) _leds ;
+  uint8_t* out = (uint8_t*) _out ;
+
+#ifdef COLOR_LUT_FUSED
+  if ( brightness != _fusedBrightness ) rebuild( brightness ) ;
+  for ( uint8_t i = 0 ; i < _numLeds ; i++ ) {
+    *out++ = _fused[0][*in++] ;
+    *out++ = _fused[1][*in++] ;
+    *out++ = _fused[2][*in++] ;
+  }
+  FastLED.show( 255 ) ;
+#else
+  for ( uint8_t i = 0 ; i < _numLeds ; i++ ) {
+    *out++ = value16( 0, *in++ ) >> 8 ;
+    *out++ = value16( 1, *in++ ) >> 8 ;
+    *out++ = value16( 2, *in++ ) >> 8 ;
+  }
+  FastLED.show( brightness ) ;
+#endif
+}
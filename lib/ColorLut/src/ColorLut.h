@@ -0,0 +1,74 @@
+#ifndef ColorLut_H
+#define ColorLut_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Gamma and white balance, applied once on the way out instead of in every
+   routine. Routines keep working in perceptual values (CHSV, palettes,
+   HeatColor all assume that); the LEDs get linear PWM.
+
+   The tables are built by the compiler from COLOR_LUT_GAMMA(_R/_G/_B) and
+   COLOR_LUT_WB_R/G/B (white balance, 255 = full) and live in flash: one
+   16-bit entry per channel value, 1.5KB. Changing the curve is a rebuild.
+
+   Output stages:
+   - plain FastLED: show() maps leds[] into its own buffer, one table load
+     per byte, and the controller sends that. With COLOR_LUT_FUSED the
+     brightness is folded into a RAM copy of the tables (768 bytes), rebuilt
+     only when the brightness changes, and FastLED sends at 255.
+   - TEMPORAL_DITHER and APA102_HD read value16() directly and keep all
+     16 bits for their own brightness handling.
+
+   White balance replaces setCorrection( TypicalLEDStrip ); the default
+   numbers are the same.
+*/
+
+#ifndef COLOR_LUT_GAMMA
+#define COLOR_LUT_GAMMA 2.2
+#endif
+#ifndef COLOR_LUT_GAMMA_R
+#define COLOR_LUT_GAMMA_R COLOR_LUT_GAMMA
+#endif
+#ifndef COLOR_LUT_GAMMA_G
+#define COLOR_LUT_GAMMA_G COLOR_LUT_GAMMA
+#endif
+#ifndef COLOR_LUT_GAMMA_B
+#define COLOR_LUT_GAMMA_B COLOR_LUT_GAMMA
+#endif
+
+// TypicalLEDStrip
+#ifndef COLOR_LUT_WB_R
+#define COLOR_LUT_WB_R 255
+#endif
+#ifndef COLOR_LUT_WB_G
+#define COLOR_LUT_WB_G 176
+#endif
+#ifndef COLOR_LUT_WB_B
+#define COLOR_LUT_WB_B 240
+#endif
+
+class ColorLut
+{
+  public:
+    // Corrected value of channel 0-2 (r, g, b), 0-65535
+    static uint16_t value16( uint8_t channel, uint8_t value ) ;
+
+    // Plain output stage: point the controller at our buffer
+    void begin( CLEDController* controller, const CRGB* leds, uint8_t numLeds ) ;
+    void show( uint8_t brightness ) ;
+
+  private:
+    const CRGB* _leds = NULL ;
+    uint8_t _numLeds = 0 ;
+    CRGB _out[NUM_LEDS] ;
+
+#ifdef COLOR_LUT_FUSED
+    void rebuild( uint8_t brightness ) ;
+    uint8_t _fused[3][256] ;
+    int16_t _fusedBrightness = -1 ;
+#endif
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "DitherOutput.h"
+#ifdef COLOR_LUT
+#include <ColorLut.h>
+#endif
+
+void DitherOutput::begin( CLEDController* controller, const CRGB* leds, uint8_t numLeds ) {
+  _controller = controller ;
+  _leds = leds ;
+  _numLeds = numLeds ;
+  memset( _err, 0, sizeof(_err) ) ;
+
+  // Mirrored strips (STRIPS_MIRROR) are registered after ours and show the same buffer
+  for ( CLEDController* c = _controller ; c ; c = c->next() ) {
+    c->setLeds( _out, _numLeds ) ;
+  }
+  FastLED.setDither( DISABLE_DITHER ) ;
+}
+
+
+void DitherOutput::show( uint8_t brightness ) {
+  // 255 -> 256 so full brightness passes values straight through; 0 stays black
+  _scale = brightness ? brightness + 1 : 0 ;
+  refresh() ;
+}
+
+
+void DitherOutput::refresh() {
+  uint32_t start = micros() ;
+  render() ;
+  _lastMicros = micros() - start ;
+
+  // Brightness is already in _out
+  FastLED.show( 255 ) ;
+}
+
+
+void DitherOutput::render() {
+  const uint8_t* in = (const uint8_t*) _leds ;
+  uint8_t* out = (uint8_t*) _out ;
+  uint8_t* err = (uint8_t*) _err ;
+
+#ifdef COLOR_LUT
+  // Gamma-corrected 16-bit values: the dither gets to keep all of the curve's low end
+  for ( uint16_t i = 0 ; i < _numLeds * 3 ; i += 3 ) {
+    for ( uint8_t c = 0 ; c < 3 ; c++ ) {
+      uint32_t v = ( ( (uint32_t) ColorLut::value16( c, in[i + c] ) * _scale ) >> 8 ) + err[i + c] ;
+      if ( v > 0xFFFF ) v = 0xFFFF ;
+      out[i + c] = v >> 8 ;
+      err[i + c] = v & 0xFF ;
+    }
+  }
+#else
+  for ( uint16_t i = 0 ; i < _numLeds * 3 ; i++ ) {
+    uint16_t v = in[i] * _scale + err[i] ;
+    out[i] = v >> 8 ;
+    err[i] = v & 0xFF ;
+  }
+#endif
+}
@@ -0,0 +1,59 @@
+#ifndef DitherOutput_H
+#define DitherOutput_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Temporal dithering for props that run at low brightness. At brightness 10
+   an 8-bit channel only has ~10 steps left after scaling, and slow fades
+   (colorGlow, heartbeat) visibly stair-step.
+
+   Each channel is scaled to 16 bits (value * brightness) and sent as its top
+   8 bits; the low 8 bits are carried over to the next refresh per channel
+   (error diffusion in time). Refreshing the same frame every DITHER_REFRESH_US
+   makes the LEDs average out to the full 16-bit value.
+
+   FastLED's own dithering only varies the brightness scale between calls to
+   FastLED.show(), which happen once per routine frame here (10-50ms), so it
+   never gets to average; it's switched off while this is in use.
+
+   The controller is pointed at our output buffer, so everything has to go
+   through LEDRoutines::show() (which calls show() here) rather than FastLED.show().
+   Best with APA102: a WS2812 refresh blocks interrupts for 30us per LED, so
+   raise DITHER_REFRESH_US on NEO_PIXEL builds.
+
+   RAM: NUM_LEDS * 6 bytes.
+*/
+
+#ifndef DITHER_REFRESH_US
+#define DITHER_REFRESH_US 2500
+#endif
+
+class DitherOutput
+{
+  public:
+    void begin( CLEDController* controller, const CRGB* leds, uint8_t numLeds ) ;
+
+    // leds[] has a new frame: send it at this brightness, and keep refreshing it
+    void show( uint8_t brightness ) ;
+    // Send the current frame again with the next step of dithering
+    void refresh() ;
+
+    // Time the last render took, for tuning DITHER_REFRESH_US
+    uint16_t lastMicros() { return _lastMicros ; }
+
+  private:
+    void render() ;
+
+    CLEDController* _controller = NULL ;
+    const CRGB* _leds = NULL ;
+    uint8_t _numLeds = 0 ;
+    uint16_t _scale = 0 ;
+    uint16_t _lastMicros = 0 ;
+
+    CRGB _out[NUM_LEDS] ;
+    uint8_t _err[NUM_LEDS][3] ;
+};
+
+#endif
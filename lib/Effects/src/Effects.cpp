@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "Effects.h"
+
+void LedSpan::fill( const CRGB& color ) {
+  for ( uint8_t i = 0 ; i < length ; i++ ) {
+    (*this)[i] = color ;
+  }
+}
+
+
+void LedSpan::fade( uint8_t amount ) {
+  for ( uint8_t i = 0 ; i < length ; i++ ) {
+    (*this)[i].fadeToBlackBy( amount ) ;
+  }
+}
+
+
+uint16_t PaletteEffect::draw( LedSpan& span ) {
+  _start += _flow ;
+  uint8_t colorIndex = _start ;
+  for ( uint8_t i = 0 ; i < span.length ; i++ ) {
+    span[i] = ColorFromPalette( _palette, colorIndex, 255, LINEARBLEND ) ;
+    colorIndex += _steps ;
+  }
+  return _interval ;
+}
+
+
+uint16_t GlitterEffect::draw( LedSpan& span ) {
+  if ( _fade ) {
+    span.fade( _fade ) ;
+  } else {
+    span.fill( CRGB::Black ) ;
+  }
+  if ( random8() < _chance ) {
+    span[ random8( span.length ) ] += CRGB::White ;
+  }
+  return _interval ;
+}
+
+
+uint16_t FireBase::draw( LedSpan& span ) {
+  uint8_t n = min( _cells, span.length ) ;
+  if ( ! n ) return 10 ;
+
+  // Step 1.  Cool down every cell a little
+  for ( uint8_t i = 0 ; i < n ; i++ ) {
+    _heat[i] = qsub8( _heat[i], random8( 0, ( ( _cooling * 10 ) / n ) + 2 ) ) ;
+  }
+
+  // Step 2.  Heat from each cell drifts 'up' and diffuses a little
+  for ( uint8_t k = n - 1 ; k >= 2 ; k-- ) {
+    _heat[k] = ( _heat[k - 1] + _heat[k - 2] + _heat[k - 2] ) / 3 ;
+  }
+
+  // Step 3.  Randomly ignite new 'sparks' of heat near the bottom (the first
+  // 7 cells on a long strip, the bottom quarter of a short one)
+  if ( random8() < _sparking ) {
+    uint8_t y = random8( min( 7, ( n + 3 ) / 4 ) ) ;
+    _heat[y] = qadd8( _heat[y], random8( 160, 255 ) ) ;
+  }
+
+  // Step 4.  Map from heat cells to LED colors
+  for ( uint8_t j = 0 ; j < n ; j++ ) {
+    span[j] = HeatColor( _heat[j] ) ;
+  }
+  return 10 ;
+}
+
+
+void ZoneRunner::begin( Zone* zones, uint8_t count ) {
+  _zones = zones ;
+  _count = count ;
+}
+
+
+bool ZoneRunner::draw( uint32_t nowMs ) {
+  bool drawn = false ;
+  for ( uint8_t i = 0 ; i < _count ; i++ ) {
+    Zone& zone = _zones[i] ;
+    if ( (int32_t) ( nowMs - zone.due ) < 0 ) continue ;
+    zone.due = nowMs + zone.effect->draw( zone.span ) ;
+    drawn = true ;
+  }
+  return drawn ;
+}
+
+
+void ZoneRunner::restart( uint32_t nowMs ) {
+  for ( uint8_t i = 0 ; i < _count ; i++ ) _zones[i].due = nowMs ;
+}
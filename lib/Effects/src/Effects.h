@@ -0,0 +1,124 @@
+#ifndef Effects_H
+#define Effects_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Effects that can run several times at once, on different parts of the strip.
+
+   The LEDRoutines routines keep their state in function statics and draw over
+   all of leds[], so only one of each can run. An Effect object keeps its own
+   state and draws into a LedSpan: a run of LEDs anywhere in the frame, walked
+   with a stride (1 = next to each other, 8 = every 8th LED, -1 = backwards).
+   Two FireEffects on two ribs burn independently, and however many zones use
+   an effect its code is in flash once.
+
+   ZoneRunner draws every zone whose frame is due, so a single task (the "zones"
+   routine in the sketch) runs them all and sends the frame once. Zones are
+   listed in the board header, see ZONES in JellyfishUmbrella.h.
+*/
+
+struct LedSpan
+{
+  CRGB* first ;
+  uint8_t length ;
+  int8_t stride ;
+
+  CRGB& operator[]( uint8_t i ) { return first[ (int16_t) i * stride ] ; }
+  void fill( const CRGB& color ) ;
+  void fade( uint8_t amount ) ;
+};
+
+class Effect
+{
+  public:
+    // Draw the next frame into 'span'; returns the time until the one after, in ms
+    virtual uint16_t draw( LedSpan& span ) = 0 ;
+};
+
+
+// Scrolling palette, as the p_* routines
+class PaletteEffect : public Effect
+{
+  public:
+    PaletteEffect( const TProgmemRGBPalette16& palette, uint8_t steps = 1, int8_t flow = 1, uint16_t interval = 20 )
+      : _palette( palette ), _steps( steps ), _flow( flow ), _interval( interval ) {}
+    uint16_t draw( LedSpan& span ) ;
+
+  private:
+    const TProgmemRGBPalette16& _palette ;
+    uint8_t _steps ;    // palette index step between LEDs: 1 = gradient, higher = stripes
+    int8_t _flow ;
+    uint16_t _interval ;
+    uint8_t _start = 0 ;
+};
+
+
+// White sparkles; fade 0 clears the span every frame (dglitter), otherwise they fade out by that much (fglitter)
+class GlitterEffect : public Effect
+{
+  public:
+    GlitterEffect( fract8 chance, uint8_t fade, uint16_t interval = 10 )
+      : _chance( chance ), _fade( fade ), _interval( interval ) {}
+    uint16_t draw( LedSpan& span ) ;
+
+  private:
+    fract8 _chance ;
+    uint8_t _fade ;
+    uint16_t _interval ;
+};
+
+
+// Fire2012 by Mark Kriegsman, burning from span[0] upwards. The heat cells
+// live in FireEffect<N>; the simulation itself is shared by every size.
+class FireBase : public Effect
+{
+  public:
+    uint16_t draw( LedSpan& span ) ;
+
+  protected:
+    FireBase( uint8_t* heat, uint8_t cells, uint8_t cooling, uint8_t sparking )
+      : _heat( heat ), _cells( cells ), _cooling( cooling ), _sparking( sparking ) {}
+
+  private:
+    uint8_t* _heat ;
+    uint8_t _cells ;
+    uint8_t _cooling ;    // less cooling = taller flames; 20-100
+    uint8_t _sparking ;   // chance out of 255 of a new spark; 50-200
+};
+
+template<uint8_t N>
+class FireEffect : public FireBase
+{
+  public:
+    FireEffect( uint8_t cooling = 75, uint8_t sparking = 70 )
+      : FireBase( _cellHeat, N, cooling, sparking ) {}
+
+  private:
+    uint8_t _cellHeat[N] = { 0 } ;
+};
+
+
+struct Zone
+{
+  LedSpan span ;
+  Effect* effect ;
+  uint32_t due ;    // time of the next frame, on the clock draw() is given
+};
+
+class ZoneRunner
+{
+  public:
+    void begin( Zone* zones, uint8_t count ) ;
+    // Draw every zone whose frame is due at 'nowMs'; true if any of them changed
+    bool draw( uint32_t nowMs ) ;
+    // Every zone due at 'nowMs', e.g. when the clock has been switched
+    void restart( uint32_t nowMs ) ;
+
+  private:
+    Zone* _zones = NULL ;
+    uint8_t _count = 0 ;
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "FrameCheck.h"
+
+#define FNV_OFFSET 2166136261UL
+#define FNV_PRIME  16777619UL
+
+bool FrameCheck::_running = false ;
+uint32_t FrameCheck::_now = 0 ;
+
+
+void FrameCheck::begin() {
+  random16_set_seed( FRAME_CHECK_SEED ) ;
+  _now = 0 ;
+  _hash = FNV_OFFSET ;
+  _running = true ;
+}
+
+
+void FrameCheck::end() {
+  _running = false ;
+}
+
+
+void FrameCheck::frame( const CRGB* leds, uint16_t numLeds, uint8_t brightness, uint32_t intervalMs ) {
+  _frameHash = fnv1a( FNV_OFFSET, (const uint8_t*) leds, numLeds * 3 ) ;
+  _frameHash = fnv1a( _frameHash, &brightness, 1 ) ;
+  _hash = fnv1a( _hash, (const uint8_t*) &_frameHash, sizeof(_frameHash) ) ;
+
+  // TASK_IMMEDIATE routines still get a clock that moves
+  _now += intervalMs ? intervalMs : 1 ;
+}
+
+
+uint32_t FrameCheck::fnv1a( uint32_t hash, const uint8_t* data, uint16_t len ) {
+  for ( uint16_t i = 0 ; i < len ; i++ ) {
+    hash = ( hash ^ data[i] ) * FNV_PRIME ;
+  }
+  return hash ;
+}
@@ -0,0 +1,58 @@
+#ifndef FrameCheck_H
+#define FrameCheck_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Reproducible frames, so a change to a routine can be checked against what
+   it drew before (see the "check" serial command and tools/framecheck.py).
+
+   While running, the random8()/random16() generator starts from a fixed seed
+   and FastLED's clock (get_millisecond_timer(), so beat8(), beatsin8() etc.,
+   and LEDRoutines::now() which the sketch points at it) is a virtual one: it
+   stands still while a frame is drawn and then moves on by the routine's own
+   frame interval. Runs don't wait for real time, so hours of show time can be
+   pushed through a routine to look for counters that overflow or wrap.
+
+   Each frame is hashed (FNV-1a over leds[] and the brightness the routine
+   set), and the frame hashes are folded into one hash for the whole run.
+
+   Only what goes through these clocks and FastLED's generator is
+   reproducible. Routines that read the tap tempo's beatProgress(), or the
+   MPU, draw differently every run. Routines also keep state in function
+   statics, so compare runs made in the same order after a reset.
+
+   Needs USE_GET_MILLISECOND_TIMER.
+*/
+
+#ifndef FRAME_CHECK_SEED
+#define FRAME_CHECK_SEED 1337
+#endif
+
+class FrameCheck
+{
+  public:
+    void begin() ;
+    void end() ;
+
+    // Hash the frame that was just drawn, and move the clock on by 'intervalMs'
+    void frame( const CRGB* leds, uint16_t numLeds, uint8_t brightness, uint32_t intervalMs ) ;
+
+    uint32_t frameHash() { return _frameHash ; }
+    uint32_t hash() { return _hash ; }
+
+    static bool running() { return _running ; }
+    static uint32_t now() { return _now ; }
+
+  private:
+    static uint32_t fnv1a( uint32_t hash, const uint8_t* data, uint16_t len ) ;
+
+    uint32_t _frameHash = 0 ;
+    uint32_t _hash = 0 ;
+
+    static bool _running ;
+    static uint32_t _now ;
+};
+
+#endif
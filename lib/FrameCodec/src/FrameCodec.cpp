@@ -0,0 +1,208 @@
+#include "FrameCodec.h"
+
+// Append a byte if there is room, but keep counting: with out == NULL this just measures
+static inline void put( uint8_t* out, uint16_t outSize, uint16_t& pos, uint8_t c ) {
+  if ( out && pos < outSize ) out[pos] = c ;
+  pos++ ;
+}
+
+static inline uint16_t finish( uint8_t* out, uint16_t outSize, uint16_t pos ) {
+  return ( out && pos > outSize ) ? 0 : pos ;
+}
+
+
+bool FrameCodec::decode( const uint8_t* packet, uint16_t len, uint8_t* frame, uint16_t numLeds ) {
+  // First pass only checks, second one writes: a bad packet never half-applies
+  return apply( packet, len, frame, numLeds, false ) && apply( packet, len, frame, numLeds, true ) ;
+}
+
+
+bool FrameCodec::apply( const uint8_t* packet, uint16_t len, uint8_t* frame, uint16_t numLeds, bool write ) {
+  if ( len < 1 ) return false ;
+
+  uint32_t p = 1 ;
+  uint16_t led = 0 ;
+
+  switch ( packet[0] ) {
+    case FC_RAW:
+      if ( len != 1 + 3 * (uint32_t) numLeds ) return false ;
+      if ( write ) memcpy( frame, packet + 1, 3 * numLeds ) ;
+      return true ;
+
+    case FC_RLE:
+      while ( p < len ) {
+        uint8_t c = packet[p++] ;
+        uint16_t count = ( c & 0x7F ) + 1 ;
+        if ( led + count > numLeds ) return false ;
+        if ( c & 0x80 ) {
+          if ( p + 3 > len ) return false ;
+          if ( write ) {
+            for ( uint16_t i = 0 ; i < count ; i++ ) memcpy( frame + 3 * ( led + i ), packet + p, 3 ) ;
+          }
+          p += 3 ;
+        } else {
+          if ( p + 3 * count > len ) return false ;
+          if ( write ) memcpy( frame + 3 * led, packet + p, 3 * count ) ;
+          p += 3 * count ;
+        }
+        led += count ;
+      }
+      return led == numLeds ;
+
+    case FC_DELTA:
+      while ( p < len ) {
+        uint8_t c = packet[p++] ;
+        uint16_t count = ( c & 0x7F ) + 1 ;
+        if ( led + count > numLeds ) return false ;
+        if ( ! ( c & 0x80 ) ) {
+          if ( p + 3 * count > len ) return false ;
+          if ( write ) {
+            for ( uint16_t i = 0 ; i < 3 * count ; i++ ) frame[3 * led + i] ^= packet[p + i] ;
+          }
+          p += 3 * count ;
+        } // else: skip, those pixels stay as they are
+        led += count ;
+      }
+      return led == numLeds ;
+
+    case FC_PALETTE: {
+      if ( len < 2 ) return false ;
+      uint8_t k = packet[1] ;
+      if ( k < 1 || k > FC_MAX_PALETTE ) return false ;
+      const uint8_t* palette = packet + 2 ;
+      const uint8_t* index = palette + 3 * k ;
+      if ( len != 2 + 3 * k + ( numLeds + 1 ) / 2 ) return false ;
+      for ( led = 0 ; led < numLeds ; led++ ) {
+        uint8_t idx = ( led & 1 ) ? index[led / 2] >> 4 : index[led / 2] & 0x0F ;
+        if ( idx >= k ) return false ;
+        if ( write ) memcpy( frame + 3 * led, palette + 3 * idx, 3 ) ;
+      }
+      return true ;
+    }
+  }
+  return false ;
+}
+
+
+uint16_t FrameCodec::encode( const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) {
+  uint8_t best = FC_RAW ;
+  uint16_t bestSize = 1 + 3 * numLeds ;
+
+  const uint8_t types[] = { FC_RLE, FC_DELTA, FC_PALETTE } ;
+  for ( uint8_t t = 0 ; t < sizeof(types) ; t++ ) {
+    uint16_t size = encodeAs( types[t], frame, prev, numLeds, NULL, 0 ) ;
+    if ( size && size < bestSize ) {
+      best = types[t] ;
+      bestSize = size ;
+    }
+  }
+  return encodeAs( best, frame, prev, numLeds, out, outSize ) ;
+}
+
+
+uint16_t FrameCodec::encodeAs( uint8_t type, const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) {
+  switch ( type ) {
+    case FC_RAW: {
+      uint16_t pos = 0 ;
+      put( out, outSize, pos, FC_RAW ) ;
+      for ( uint16_t i = 0 ; i < 3 * numLeds ; i++ ) put( out, outSize, pos, frame[i] ) ;
+      return finish( out, outSize, pos ) ;
+    }
+    case FC_RLE:
+      return encodeRle( frame, numLeds, out, outSize ) ;
+    case FC_DELTA:
+      return prev ? encodeDelta( frame, prev, numLeds, out, outSize ) : 0 ;
+    case FC_PALETTE:
+      return encodePalette( frame, numLeds, out, outSize ) ;
+  }
+  return 0 ;
+}
+
+
+uint16_t FrameCodec::encodeRle( const uint8_t* frame, uint16_t numLeds, uint8_t* out, uint16_t outSize ) {
+  uint16_t pos = 0 ;
+  put( out, outSize, pos, FC_RLE ) ;
+
+  uint16_t i = 0 ;
+  while ( i < numLeds ) {
+    uint16_t run = 1 ;
+    while ( i + run < numLeds && run < FC_MAX_RUN && samePixel( frame + 3 * i, frame + 3 * ( i + run ) ) ) run++ ;
+
+    if ( run >= 2 ) {
+      // 4 bytes for the run beats 6 for two literals already
+      put( out, outSize, pos, 0x80 | ( run - 1 ) ) ;
+      for ( uint8_t b = 0 ; b < 3 ; b++ ) put( out, outSize, pos, frame[3 * i + b] ) ;
+      i += run ;
+      continue ;
+    }
+
+    // Literals up to where the next run starts
+    uint16_t start = i ;
+    do {
+      i++ ;
+    } while ( i < numLeds && i - start < FC_MAX_RUN && ! ( i + 1 < numLeds && samePixel( frame + 3 * i, frame + 3 * ( i + 1 ) ) ) ) ;
+
+    put( out, outSize, pos, i - start - 1 ) ;
+    for ( uint16_t b = 3 * start ; b < 3 * i ; b++ ) put( out, outSize, pos, frame[b] ) ;
+  }
+  return finish( out, outSize, pos ) ;
+}
+
+
+uint16_t FrameCodec::encodeDelta( const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) {
+  uint16_t pos = 0 ;
+  put( out, outSize, pos, FC_DELTA ) ;
+
+  uint16_t i = 0 ;
+  while ( i < numLeds ) {
+    uint16_t start = i ;
+    bool same = samePixel( frame + 3 * i, prev + 3 * i ) ;
+    do {
+      i++ ;
+    } while ( i < numLeds && i - start < FC_MAX_RUN && samePixel( frame + 3 * i, prev + 3 * i ) == same ) ;
+
+    if ( same ) {
+      put( out, outSize, pos, 0x80 | ( i - start - 1 ) ) ;
+    } else {
+      put( out, outSize, pos, i - start - 1 ) ;
+      for ( uint16_t b = 3 * start ; b < 3 * i ; b++ ) put( out, outSize, pos, frame[b] ^ prev[b] ) ;
+    }
+  }
+  return finish( out, outSize, pos ) ;
+}
+
+
+uint16_t FrameCodec::encodePalette( const uint8_t* frame, uint16_t numLeds, uint8_t* out, uint16_t outSize ) {
+  uint8_t palette[FC_MAX_PALETTE * 3] ;
+  uint8_t k = 0 ;
+
+  // Collect the colours first; more than 16 and this format is out
+  for ( uint16_t i = 0 ; i < numLeds ; i++ ) {
+    uint8_t idx = 0 ;
+    while ( idx < k && ! samePixel( palette + 3 * idx, frame + 3 * i ) ) idx++ ;
+    if ( idx == k ) {
+      if ( k == FC_MAX_PALETTE ) return 0 ;
+      memcpy( palette + 3 * k++, frame + 3 * i, 3 ) ;
+    }
+  }
+
+  uint16_t pos = 0 ;
+  put( out, outSize, pos, FC_PALETTE ) ;
+  put( out, outSize, pos, k ) ;
+  for ( uint8_t b = 0 ; b < 3 * k ; b++ ) put( out, outSize, pos, palette[b] ) ;
+
+  if ( ! out ) return pos + ( numLeds + 1 ) / 2 ;
+
+  uint8_t pair = 0 ;
+  for ( uint16_t i = 0 ; i < numLeds ; i++ ) {
+    uint8_t idx = 0 ;
+    while ( ! samePixel( palette + 3 * idx, frame + 3 * i ) ) idx++ ;
+    if ( i & 1 ) {
+      put( out, outSize, pos, pair | ( idx << 4 ) ) ;
+    } else {
+      pair = idx ;
+    }
+  }
+  if ( numLeds & 1 ) put( out, outSize, pos, pair ) ;
+  return finish( out, outSize, pos ) ;
+}
@@ -0,0 +1,66 @@
+#ifndef FrameCodec_H
+#define FrameCodec_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+   Compact frame packets for the serial link (SC_CMD_FRAME_CODED).
+
+   Only needs stdint/string, so the same files build in a host tool: the host
+   encodes (tools/frameenc.cpp), the MCU decodes straight into leds[].
+   tools/codec_bench.py measures it on every routine of every board. Pixels are 3 bytes in CRGB
+   order. A packet is one type byte followed by the body:
+
+     FC_RAW      numLeds x RGB
+     FC_RLE      tokens; c < 0x80: c+1 literal pixels follow (RGB each)
+                         c >= 0x80: one RGB follows, repeated (c & 0x7F) + 1 times
+     FC_DELTA    XOR against the previous frame, tokens;
+                         c < 0x80: c+1 pixels follow, each XOR'ed onto the old one
+                         c >= 0x80: (c & 0x7F) + 1 pixels unchanged
+     FC_PALETTE  k (1..16), k x RGB, then numLeds 4-bit indices, two per byte,
+                 low nibble first
+
+   RLE catches fill_solid() and mostly-black frames, DELTA the slow fades and
+   single moving dots, PALETTE the few-colour patterns (twirls, racers).
+
+   decode() checks the whole packet before it writes anything, so a bad packet
+   leaves the previous frame, which is also the base for the next DELTA, alone.
+   Nothing is allocated; decoding needs no memory besides the frame itself.
+*/
+
+#define FC_RAW      0x00
+#define FC_RLE      0x01
+#define FC_DELTA    0x02
+#define FC_PALETTE  0x03
+
+#define FC_MAX_RUN          128
+#define FC_MAX_PALETTE      16
+
+class FrameCodec
+{
+  public:
+    // Apply a packet to 'frame' (numLeds x RGB, holding the previous frame). False if the packet is bad.
+    static bool decode( const uint8_t* packet, uint16_t len, uint8_t* frame, uint16_t numLeds ) ;
+
+    // Encode 'frame' in whichever format comes out smallest. 'prev' is the frame the
+    // receiver currently has, or NULL to skip DELTA (first frame, after an error).
+    // Returns the packet length, or 0 if nothing fits in outSize.
+    static uint16_t encode( const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) ;
+
+    // Encode in one given format; 'out' may be NULL to only get the size. 0 if it can't be done.
+    static uint16_t encodeAs( uint8_t type, const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) ;
+
+  private:
+    static bool apply( const uint8_t* packet, uint16_t len, uint8_t* frame, uint16_t numLeds, bool write ) ;
+
+    static uint16_t encodeRle( const uint8_t* frame, uint16_t numLeds, uint8_t* out, uint16_t outSize ) ;
+    static uint16_t encodeDelta( const uint8_t* frame, const uint8_t* prev, uint16_t numLeds, uint8_t* out, uint16_t outSize ) ;
+    static uint16_t encodePalette( const uint8_t* frame, uint16_t numLeds, uint8_t* out, uint16_t outSize ) ;
+
+    static bool samePixel( const uint8_t* a, const uint8_t* b ) {
+      return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] ;
+    }
+};
+
+#endif
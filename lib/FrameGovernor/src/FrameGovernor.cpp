@@ -0,0 +1,51 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "FrameGovernor.h"
+
+void FrameGovernor::begin( CRGB* last, uint16_t numLeds ) {
+  _last = last ;
+  _numLeds = numLeds ;
+  reset() ;
+}
+
+
+void FrameGovernor::reset() {
+  _level = 0 ;
+  _force = true ;
+}
+
+
+bool FrameGovernor::changed( const CRGB* leds, uint8_t brightness ) {
+  // Stop comparing at the first channel over the threshold; the frame goes out either way
+  uint8_t delta = 0 ;
+  for ( uint16_t i = 0 ; i < _numLeds && delta <= FRAME_GOVERNOR_THRESHOLD ; i++ ) {
+    CRGB out = leds[i] ;
+    out.nscale8( brightness ) ;
+    for ( uint8_t c = 0 ; c < 3 ; c++ ) {
+      uint8_t d = out[c] > _last[i][c] ? out[c] - _last[i][c] : _last[i][c] - out[c] ;
+      if ( d > delta ) delta = d ;
+    }
+  }
+  _changed = _force || delta > FRAME_GOVERNOR_THRESHOLD ;
+
+  if ( ! _changed ) {
+    if ( _level < 31 ) _level++ ;
+    return false ;
+  }
+
+  for ( uint16_t i = 0 ; i < _numLeds ; i++ ) {
+    _last[i] = leds[i] ;
+    _last[i].nscale8( brightness ) ;
+  }
+  _level = 0 ;
+  _force = false ;
+  return true ;
+}
+
+
+uint32_t FrameGovernor::stretch( uint32_t interval, uint32_t maxInterval ) {
+  if ( interval >= maxInterval ) return interval ;
+  uint8_t level = _level ;
+  while ( level-- && interval < maxInterval ) interval <<= 1 ;
+  return interval < maxInterval ? interval : maxInterval ;
+}
@@ -0,0 +1,67 @@
+#ifndef FrameGovernor_H
+#define FrameGovernor_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Lowers the frame rate while the output isn't visibly changing: slow
+   routines (heartbeat's tail, color_glow at a low BPM, the palettes at a
+   low brightness) otherwise draw and send frames that differ from the last
+   one by a single step, or not at all.
+
+   show() hands every frame to changed() just before it goes out. That
+   compares it, at the brightness it is sent with, to the last frame that
+   was sent; the largest difference in any channel is the frame's delta.
+   A frame within FRAME_GOVERNOR_THRESHOLD of it isn't sent at all (the
+   strip already shows it), and each such frame in a row doubles what
+   stretch() makes of the routine's interval, up to a maximum (the sketch
+   uses FRAME_GOVERNOR_MAX_MS). The first frame that does change is sent and
+   puts the routine straight back on its own interval.
+
+   Small changes still add up: a frame is compared to the last one sent,
+   not to the one drawn before it, so a slow fade goes out as soon as it
+   has moved far enough to see.
+
+   Only stretch the interval of routines that draw from the clock (beat8(),
+   now()). Routines that step a counter each frame would slow down, and ones
+   that act on a moment of the beat (color_glow changes colour in the trough)
+   would miss it; for those changed() on its own still saves the sends.
+
+   Not for TEMPORAL_DITHER, which is there to show the in-between steps.
+*/
+
+#ifndef FRAME_GOVERNOR_THRESHOLD
+#define FRAME_GOVERNOR_THRESHOLD 1    // largest channel difference that counts as no change
+#endif
+#ifndef FRAME_GOVERNOR_MAX_MS
+#define FRAME_GOVERNOR_MAX_MS 80      // longest a static frame gets stretched to
+#endif
+
+class FrameGovernor
+{
+  public:
+    // 'last' holds the last frame sent, numLeds long
+    void begin( CRGB* last, uint16_t numLeds ) ;
+
+    // Compare the frame about to go out; false: nothing visible changed, don't send it
+    bool changed( const CRGB* leds, uint8_t brightness ) ;
+
+    // 'interval' stretched while frames stay static, up to 'maxInterval'; any units
+    uint32_t stretch( uint32_t interval, uint32_t maxInterval ) ;
+
+    // Next frame goes out whatever it looks like, at full rate (new routine, new output)
+    void reset() ;
+
+    // Whether the last frame went out
+    bool lastChanged() { return _changed ; }
+
+  private:
+    CRGB* _last = NULL ;
+    uint16_t _numLeds = 0 ;
+    uint8_t _level = 0 ;      // static frames in a row, up to the one that hits the maximum
+    bool _changed = true ;
+    bool _force = true ;
+};
+
+#endif
@@ -0,0 +1,95 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "FrameQueue.h"
+#ifdef FRAME_CHECK
+#include <FrameCheck.h>
+#endif
+
+uint32_t FrameQueue::renderAhead = 0 ;
+
+#ifdef USE_GET_MILLISECOND_TIMER
+// FastLED reads time through this instead of millis() when USE_GET_MILLISECOND_TIMER is set
+uint32_t get_millisecond_timer() {
+#ifdef FRAME_CHECK
+  if ( FrameCheck::running() ) return FrameCheck::now() ;
+#endif
+  return millis() + FrameQueue::renderAhead ;
+}
+#endif
+
+
+void FrameQueue::begin( CLEDController* controller, CRGB* liveLeds, uint8_t numLeds ) {
+  _controller = controller ;
+  _liveLeds = liveLeds ;
+  _numLeds = numLeds ;
+  clear() ;
+}
+
+
+void FrameQueue::beginCapture() {
+  uint32_t now = millis() ;
+  _nextDue = _lastDue + _frameInterval ;
+  // After an underrun the next slot may already be in the past: start again from now
+  if ( empty() || (int32_t) ( _nextDue - now ) < 0 ) {
+    _nextDue = now ;
+  }
+  renderAhead = _nextDue - now ;
+  _capturing = true ;
+}
+
+
+void FrameQueue::endCapture() {
+  renderAhead = 0 ;
+  _capturing = false ;
+}
+
+
+void FrameQueue::capture( const CRGB* leds, uint8_t brightness ) {
+  if ( full() ) return ;
+
+  QueuedFrame& frame = _frames[ ( _head + _count ) % FRAME_QUEUE_SLOTS ] ;
+  memcpy( frame.leds, leds, _numLeds * sizeof(CRGB) ) ;
+  frame.due = _nextDue ;
+  frame.brightness = brightness ;
+  _count++ ;
+
+  _lastDue = _nextDue ;
+}
+
+
+bool FrameQueue::showDue() {
+  uint32_t now = millis() ;
+
+  if ( empty() || (int32_t) ( now - _frames[_head].due ) < 0 ) return false ;
+
+  // If we fell behind, drop straight to the newest frame that is due
+  while ( _count > 1 && (int32_t) ( now - _frames[ ( _head + 1 ) % FRAME_QUEUE_SLOTS ].due ) >= 0 ) {
+    _head = ( _head + 1 ) % FRAME_QUEUE_SLOTS ;
+    _count-- ;
+  }
+
+  QueuedFrame& frame = _frames[_head] ;
+  pointControllersAt( frame.leds ) ;
+  FastLED.setBrightness( frame.brightness ) ;
+  FastLED.show() ;
+
+  _head = ( _head + 1 ) % FRAME_QUEUE_SLOTS ;
+  _count-- ;
+  return true ;
+}
+
+
+void FrameQueue::clear() {
+  _head = 0 ;
+  _count = 0 ;
+  endCapture() ;
+  pointControllersAt( _liveLeds ) ;
+}
+
+
+// Mirrored strips (STRIPS_MIRROR) are registered after ours and show the same frame
+void FrameQueue::pointControllersAt( CRGB* leds ) {
+  for ( CLEDController* c = _controller ; c ; c = c->next() ) {
+    c->setLeds( leds, _numLeds ) ;
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef FrameQueue_H
+#define FrameQueue_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Render-ahead queue for routines whose output only depends on time
+   (palette scrolls, threeSinPal, fastLoop3, circularLoader).
+
+   While capturing, LEDRoutines::show() copies the frame into the queue instead
+   of sending it, stamped with the time it should appear. The FastLED clock is
+   shifted to that time while the frame is rendered (see get_millisecond_timer()),
+   so beat8()/beatsin8() produce the frame as it would have looked then.
+
+   showDue() is called from a fast output task and only has to point the
+   controller at the queued frame and send it, so frame timing jitter drops to
+   the cost of show().
+
+   RAM: FRAME_QUEUE_DEPTH * NUM_LEDS * 3 bytes.
+*/
+
+// FRAME_QUEUE_DEPTH is what turns the queue on (see the sketch), so it gets no
+// default here; the class only has to compile without it.
+#ifdef FRAME_QUEUE_DEPTH
+#define FRAME_QUEUE_SLOTS FRAME_QUEUE_DEPTH
+#else
+#define FRAME_QUEUE_SLOTS 1
+#endif
+
+struct QueuedFrame
+{
+  CRGB leds[NUM_LEDS] ;
+  uint32_t due ;        // millis() at which to show this frame
+  uint8_t brightness ;
+};
+
+class FrameQueue
+{
+  public:
+    void begin( CLEDController* controller, CRGB* liveLeds, uint8_t numLeds ) ;
+
+    bool full() { return _count == FRAME_QUEUE_SLOTS ; }
+    bool empty() { return _count == 0 ; }
+    uint8_t count() { return _count ; }
+
+    // Time between queued frames, in ms (the routine's own task interval)
+    void setFrameInterval( uint32_t ms ) { _frameInterval = ms ; }
+    uint32_t getFrameInterval() { return _frameInterval ; }
+
+    // Render the next frame into the queue instead of onto the LEDs
+    void beginCapture() ;
+    void endCapture() ;
+    bool capturing() { return _capturing ; }
+    void capture( const CRGB* leds, uint8_t brightness ) ;
+
+    // Push the frame that is due (skipping any we're too late for). Returns true if something was shown.
+    bool showDue() ;
+
+    // Throw away everything queued and send the live buffer again (mode/BPM/brightness change)
+    void clear() ;
+
+    // Offset added to millis() for FastLED's beat functions while rendering ahead
+    static uint32_t renderAhead ;
+
+  private:
+    void pointControllersAt( CRGB* leds ) ;
+
+    QueuedFrame _frames[FRAME_QUEUE_SLOTS] ;
+    uint8_t _head = 0 ;   // next to show
+    uint8_t _count = 0 ;
+    uint32_t _nextDue = 0 ;   // stamp for the frame being captured
+    uint32_t _lastDue = 0 ;   // stamp of the newest queued frame
+    uint32_t _frameInterval = 10 ;
+    bool _capturing = false ;
+
+    CLEDController* _controller = NULL ;
+    CRGB* _liveLeds = NULL ;
+    uint8_t _numLeds = 0 ;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#include <Arduino.h>
+#include "IdleSleep.h"
+
+uint32_t IdleSleep::sleep( uint32_t untilDueUs ) {
+  if ( untilDueUs < IDLE_SLEEP_MIN_US ) return 0 ;
+
+  uint32_t start = micros() ;
+#if defined(__arm__)
+  asm volatile ( "wfi" ) ;
+#endif
+  return micros() - start ;
+}
@@ -0,0 +1,36 @@
+#ifndef IdleSleep_H
+#define IdleSleep_H
+
+#include <Arduino.h>
+
+/*
+   Sleep between frames, for props that run off a battery.
+
+   loop() calls sleep() when the scheduler had nothing to run, with the time
+   until the next task is due. No timer gets reprogrammed:
+
+   - ARM (Teensy LC, SAMD): WFI stops the core until the next interrupt. That
+     is the 1 ms SysTick at the latest, and earlier for a button edge, the
+     MPU's data-ready pin or serial data, so those wake it straight away and
+     millis()/micros() stay right. loop() comes round after each wake-up and
+     goes back to sleep if there is still time.
+   - ESP8266: not supported. delay() only yields to the SDK, and light sleep
+     (wifi_fpm_*) stops the timers millis() runs on, so the sketch refuses
+     IDLE_SLEEP there.
+
+   Gaps shorter than IDLE_SLEEP_MIN_US are spun through as before, so routines
+   with sub-millisecond intervals (pendulum, jugglePal) keep their timing.
+*/
+
+#ifndef IDLE_SLEEP_MIN_US
+#define IDLE_SLEEP_MIN_US 1100   // a bit more than one SysTick
+#endif
+
+class IdleSleep
+{
+  public:
+    // Sleep for up to 'untilDueUs'; returns the microseconds actually slept
+    uint32_t sleep( uint32_t untilDueUs ) ;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "KeyframeCurve.h"
+
+// KEYFRAME_STEPS is 64: the top 6 bits pick the step, the next 8 are the fraction
+CurvePhase curvePhase( uint16_t phase ) {
+  CurvePhase p ;
+  p.step = phase >> 10 ;
+  p.frac = phase >> 2 ;
+  return p ;
+}
+
+
+uint8_t curveSample( const uint8_t* table, CurvePhase phase ) {
+  uint8_t a = pgm_read_byte( table + phase.step ) ;
+  uint8_t b = pgm_read_byte( table + phase.step + 1 ) ;
+  return lerp8by8( a, b, phase.frac ) ;
+}
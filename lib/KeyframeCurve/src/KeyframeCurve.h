@@ -0,0 +1,90 @@
+#ifndef KeyframeCurve_H
+#define KeyframeCurve_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Shapes over one beat (a heartbeat's double thump, a swell and decay),
+   written as a few keyframes instead of a hand-typed table.
+
+   A curve is a constexpr list of Keyframe { at, value, ease }: 'at' is the
+   position in the beat, 0 - 256, and 'ease' shapes the segment from that
+   keyframe to the next one. The first keyframe is at 0 and the last at 256.
+   KEYFRAME_TABLE() has the compiler sample the curve into KEYFRAME_STEPS + 1
+   bytes, which go in flash; the keyframes themselves don't end up in the
+   build.
+
+   At run time curvePhase() turns a 16-bit beat phase (beat16()) into a step
+   and a fraction, and curveSample() interpolates between the two table
+   entries around it, so the output moves smoothly between steps. A routine
+   with several curves over the same beat (brightness, hue, position)
+   looks the phase up once and samples each table with it:
+
+     static constexpr Keyframe keys[] = { { 0, 0, EASE_OUT }, { 128, 255, EASE_IN }, { 256, 0, EASE_LINEAR } } ;
+     static constexpr uint8_t swell[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( keys ) ;
+     CurvePhase phase = curvePhase( beat16( bpm ) ) ;
+     uint8_t brightness = curveSample( swell, phase ) ;
+
+   Integer maths throughout, at compile time and run time.
+*/
+
+#define KEYFRAME_STEPS 64   // table entries per beat, plus one for the end; curvePhase() assumes 64
+
+enum KeyframeEase { EASE_LINEAR, EASE_IN, EASE_OUT, EASE_IN_OUT } ;
+
+struct Keyframe
+{
+  uint16_t at ;       // 0 - 256 over the beat
+  uint8_t value ;
+  uint8_t ease ;      // KeyframeEase, towards the next keyframe
+};
+
+struct CurvePhase
+{
+  uint8_t step ;      // table entry at or before the phase
+  uint8_t frac ;      // how far to the next one, 0 - 255
+};
+
+// Where 'phase' (0 - 65535, e.g. beat16()) falls in a KEYFRAME_TABLE()
+CurvePhase curvePhase( uint16_t phase ) ;
+
+// The curve at 'phase'; 'table' is a KEYFRAME_TABLE() in flash
+uint8_t curveSample( const uint8_t* table, CurvePhase phase ) ;
+
+
+// ---- Compile time: C++11 constexpr, one return statement each ----
+
+// 'f' 0 - 255 through the segment, eased; quadratic curves
+constexpr int keyframeEase( uint8_t ease, int f ) {
+  return ease == EASE_IN ? f * f / 255
+       : ease == EASE_OUT ? 255 - ( 255 - f ) * ( 255 - f ) / 255
+       : ease == EASE_IN_OUT ? ( f < 128 ? 2 * f * f / 255 : 255 - 2 * ( 255 - f ) * ( 255 - f ) / 255 )
+       : f ;
+}
+
+// Value between keyframes k[0] and k[1] at 'x'
+constexpr uint8_t keyframeLerp( const Keyframe* k, int x ) {
+  return (uint8_t) ( k[0].value + ( ( k[1].value - k[0].value ) * keyframeEase( k[0].ease, ( x - k[0].at ) * 255 / ( k[1].at - k[0].at ) ) + ( k[1].value >= k[0].value ? 127 : -127 ) ) / 255 ) ;
+}
+
+// The curve at 'x' (0 - 256): find the segment, then interpolate
+constexpr uint8_t keyframeValue( const Keyframe* k, int x ) {
+  return x <= k[1].at ? keyframeLerp( k, x ) : keyframeValue( k + 1, x ) ;
+}
+
+// Starts at 0, ends at 256, and every keyframe after the one before it
+constexpr bool keyframesValid( const Keyframe* k, int count ) {
+  return count == 1 ? k[0].at == 256 : k[1].at > k[0].at && keyframesValid( k + 1, count - 1 ) ;
+}
+
+#define KEYFRAME_AT(K, i)    keyframeValue( K, (i) * 256 / KEYFRAME_STEPS )
+#define KEYFRAME_4(K, i)     KEYFRAME_AT(K, i), KEYFRAME_AT(K, i + 1), KEYFRAME_AT(K, i + 2), KEYFRAME_AT(K, i + 3)
+#define KEYFRAME_16(K, i)    KEYFRAME_4(K, i), KEYFRAME_4(K, i + 4), KEYFRAME_4(K, i + 8), KEYFRAME_4(K, i + 12)
+#define KEYFRAME_64(K, i)    KEYFRAME_16(K, i), KEYFRAME_16(K, i + 16), KEYFRAME_16(K, i + 32), KEYFRAME_16(K, i + 48)
+
+// { KEYFRAME_STEPS + 1 samples of the keyframes 'K' }, checked when compiled
+#define KEYFRAME_TABLE(K)    { KEYFRAME_64(K, 0), KEYFRAME_AT(K, KEYFRAME_STEPS) } ; \
+  static_assert( K[0].at == 0 && keyframesValid( K, sizeof(K) / sizeof(K[0]) ), #K ": keyframes must run from 0 to 256, in order" )
+
+#endif
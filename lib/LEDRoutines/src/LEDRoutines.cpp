@@ -5,6 +5,38 @@
 #include <math.h>
 #include "LEDRoutines.h"
 #include "easing.h"
+#include <NoiseField.h>
+#include <KeyframeCurve.h>
+#include <ParticlePool.h>
+#include <PaletteSequencer.h>
+
+ // The palette sequence, as threeSinPal always had it: a new palette every
+ // 5 seconds, fading in over 2. Blue, purple, green as CHSV( HUE_x, 255, 255 ).
+ #define SEQ_B 0x000000
+ #define SEQ_W 0xFFFFFF
+ #define SEQ_U 0x0000FF
+ #define SEQ_P 0x5500AB
+ #define SEQ_G 0x00FF00
+ static const TProgmemRGBPalette16 seqBluePurple_p PROGMEM = { SEQ_U, SEQ_U, SEQ_B, SEQ_B, SEQ_P, SEQ_P, SEQ_B, SEQ_B, SEQ_U, SEQ_U, SEQ_B, SEQ_B, SEQ_P, SEQ_P, SEQ_B, SEQ_B } ;
+ static const TProgmemRGBPalette16 seqWhiteDots_p PROGMEM = { SEQ_B, SEQ_B, SEQ_B, SEQ_W, SEQ_B, SEQ_B, SEQ_B, SEQ_W, SEQ_B, SEQ_B, SEQ_B, SEQ_W, SEQ_B, SEQ_B, SEQ_B, SEQ_W } ;
+ static const TProgmemRGBPalette16 seqBlueWhite_p PROGMEM = { SEQ_U, SEQ_U, SEQ_U, SEQ_W, SEQ_U, SEQ_U, SEQ_U, SEQ_W, SEQ_U, SEQ_U, SEQ_U, SEQ_W, SEQ_U, SEQ_U, SEQ_U, SEQ_W } ;
+ static const TProgmemRGBPalette16 seqMix_p PROGMEM = { SEQ_U, SEQ_P, SEQ_U, SEQ_W, SEQ_P, SEQ_U, SEQ_U, SEQ_W, SEQ_U, SEQ_G, SEQ_U, SEQ_W, SEQ_U, SEQ_P, SEQ_U, SEQ_W } ;
+ static const TProgmemRGBPalette16 seqBluePurpleWhite_p PROGMEM = { SEQ_U, SEQ_U, SEQ_U, SEQ_W, SEQ_U, SEQ_U, SEQ_P, SEQ_P, SEQ_U, SEQ_P, SEQ_P, SEQ_P, SEQ_U, SEQ_P, SEQ_P, SEQ_W } ;
+
+ static const PaletteStep paletteSteps[] = {
+   { &RainbowColors_p,      5000, 2000 },
+   { &seqBluePurple_p,      5000, 2000 },
+   { &OceanColors_p,        5000, 2000 },
+   { &CloudColors_p,        5000, 2000 },
+   { &LavaColors_p,         5000, 2000 },
+   { &ForestColors_p,       5000, 2000 },
+   { &PartyColors_p,        5000, 2000 },
+   { &seqWhiteDots_p,       5000, 2000 },
+   { &seqBlueWhite_p,       5000, 2000 },
+   { &seqMix_p,             5000, 2000 },
+   { &CloudColors_p,        5000, 2000 },
+   { &seqBluePurpleWhite_p, 5000, 2000 }
+ } ;
 
  void LEDRoutines::setLeds(CRGB* leds, uint8_t numLeds, ArduinoTapTempo* tapTempo, Task* taskLedModeSelect, uint8_t* currentBrightness) {
    this->_leds = leds ;
@@ -12,6 +44,152 @@
    this->_numLeds = numLeds ;
    this->_taskLedModeSelect = taskLedModeSelect ;
    this->_currentBrightness = currentBrightness;
+   _palettes.begin( paletteSteps, sizeof(paletteSteps) / sizeof(paletteSteps[0]), now() ) ;
+ }
+
+ void LEDRoutines::setLayout( PixelLayout* layout ) {
+   this->_layout = layout ;
+ }
+
+ void LEDRoutines::setFrameQueue( FrameQueue* frameQueue ) {
+   this->_frameQueue = frameQueue ;
+ }
+
+ void LEDRoutines::setPowerLimiter( PowerLimiter* power ) {
+   this->_power = power ;
+ }
+
+ void LEDRoutines::setDitherOutput( DitherOutput* dither ) {
+   this->_dither = dither ;
+ }
+
+ void LEDRoutines::setApa102Hd( Apa102Hd* hd ) {
+   this->_hd = hd ;
+ }
+
+ void LEDRoutines::setColorLut( ColorLut* lut ) {
+   this->_lut = lut ;
+ }
+
+ // Frames that look the same as the last one sent aren't sent again, see FrameGovernor.h
+ void LEDRoutines::setFrameGovernor( FrameGovernor* governor ) {
+   this->_governor = governor ;
+ }
+
+ void LEDRoutines::setAudioInput( AudioInput* audio ) {
+   this->_audio = audio ;
+ }
+
+ // With several instances each drawing their own segment of leds[], none of
+ // them sends: show() wakes the flush task, which runs after every segment
+ // that was due has drawn and pushes all strips out with one FastLED.show().
+ void LEDRoutines::setFlushTask( Task* flush ) {
+   this->_flush = flush ;
+ }
+
+ uint32_t LEDRoutines::systemClock() {
+   return millis() ;
+ }
+
+ // Routines read the time through now(), so the sketch can hand them the same
+ // clock FastLED's beat functions use (and FrameCheck's virtual one with it).
+ void LEDRoutines::setClock( ShowClock clock ) {
+   this->_clock = clock ? clock : systemClock ;
+ }
+
+ // Before each frame: one look at the clock and the tempo moves all the
+ // routine's oscillators on together (see OscillatorBank.h), and the palette
+ // sequence along with them. The frame starts at the global brightness.
+ void LEDRoutines::beginFrame() {
+   uint32_t t = now() ;
+   _osc.advance( t, (uint32_t) ( _tapTempo->getBPM() * 256 ) ) ;
+   _palettes.update( t ) ;
+   _brightness = FastLED.getBrightness() ;
+ }
+
+ // 16 RGB triplets, e.g. straight from a serial palette upload
+ void LEDRoutines::setUserPalette( const uint8_t* rgb ) {
+   for ( uint8_t i = 0 ; i < 16 ; i++ ) {
+     _userPalette[i] = CRGB( rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2] ) ;
+   }
+ }
+
+ void LEDRoutines::setUserPalette( const CRGBPalette16& palette ) {
+   _userPalette = palette ;
+ }
+
+ // Scale the output down without touching leds[], so routines that build on
+ // their previous frame (fades, trails) carry on undisturbed during a transition.
+ void LEDRoutines::setFade( uint8_t fade ) {
+   _fade = fade ;
+ }
+
+ // All routines send their frame through here, so it can be captured into
+ // the render-ahead queue instead of going straight out.
+ void LEDRoutines::show() {
+   if ( _flush ) {
+     _flush->restart() ;
+     return ;
+   }
+
+   uint8_t brightness = _brightness ;
+   if ( _fade < 255 ) brightness = scale8( brightness, _fade ) ;
+   if ( _power ) brightness = _power->limit( _leds, brightness ) ;
+
+   if ( _frameQueue && _frameQueue->capturing() ) {
+     _frameQueue->capture( _leds, brightness ) ;
+   } else if ( _governor && ! _governor->changed( _leds, brightness ) ) {
+     return ;   // the strip already shows it
+   } else if ( _dither ) {
+     _dither->show( brightness ) ;
+   } else if ( _hd ) {
+     _hd->show( _leds, brightness ) ;
+   } else if ( _lut ) {
+     _lut->show( brightness ) ;
+   } else {
+     FastLED.show( brightness ) ;
+   }
+ }
+
+
+ // Ring helpers: indexes past either end wrap around, so routines can draw
+ // across LED 0 on hoops and rings without doing the modulo themselves.
+
+ int LEDRoutines::mod(int x, int m) {
+   int r = x % m ;
+   return r < 0 ? r + m : r ;
+ }
+
+ void LEDRoutines::fillGradientRing( int startLed, CHSV startColor, int endLed, CHSV endColor ) {
+   int len = endLed - startLed ;
+   if ( len < 0 ) {  // drawn backwards: swap ends
+     fillGradientRing( endLed, endColor, startLed, startColor ) ;
+     return ;
+   }
+   for ( int i = 0 ; i <= len ; i++ ) {
+     fract8 amount = len ? ( i * 255 ) / len : 0 ;
+     _leds[ _layout->wrap( startLed + i ) ] = blend( startColor, endColor, amount ) ;
+   }
+ }
+
+ void LEDRoutines::fillSolidRing( int startLed, int endLed, CHSV color ) {
+   if ( endLed < startLed ) {
+     int tmp = startLed ; startLed = endLed ; endLed = tmp ;
+   }
+   for ( int i = startLed ; i <= endLed ; i++ ) {
+     _leds[ _layout->wrap( i ) ] = color ;
+   }
+ }
+
+ // Scale everything down to fade_all_speed/256: 250 leaves long trails, 120 short ones
+ void LEDRoutines::fadeall(uint8_t fade_all_speed) {
+   nscale8( _leds, _numLeds, fade_all_speed ) ;
+ }
+
+ void LEDRoutines::addGlitter( fract8 chanceOfGlitter) {
+   if ( random8() < chanceOfGlitter ) {
+     _leds[ random16( _numLeds ) ] += CRGB::White ;
+   }
  }
 
 
@@ -32,29 +210,10 @@
    static int flowDir = 1 ;
  #endif
 
-   const CRGBPalette16 palettes[] = { RainbowColors_p,
- #ifdef RT_P_RB_STRIPE
-                                      RainbowStripeColors_p,
- #endif
- #ifdef RT_P_OCEAN
-                                      OceanColors_p,
- #endif
- #ifdef RT_P_HEAT
-                                      HeatColors_p,
- #endif
- #ifdef RT_P_LAVA
-                                      LavaColors_p,
- #endif
- #ifdef RT_P_PARTY
-                                      PartyColors_p,
- #endif
- #ifdef RT_P_CLOUD
-                                      CloudColors_p,
- #endif
- #ifdef RT_P_FOREST
-                                      ForestColors_p
- #endif
-                                    } ;
+   // Fixed indexes, whichever p_* routines the board has: see RoutineCatalog.h
+   static const TProgmemRGBPalette16* const palettes[] = { &RainbowColors_p, &RainbowStripeColors_p,
+                                                           &OceanColors_p, &HeatColors_p, &LavaColors_p,
+                                                           &PartyColors_p, &CloudColors_p, &ForestColors_p } ;
    // Check our orientation and adjust flow direction accordingly
  #ifdef USING_MPU
    if ( isMpuUp() ) {
@@ -68,8 +227,12 @@
 
    uint8_t colorIndex = startIndex ;
 
-   for ( uint8_t i = 0; i < NUM_LEDS; i++) {
-     _leds[i] = ColorFromPalette( palettes[paletteIndex], colorIndex, 255, LINEARBLEND );
+   const CRGBPalette16 palette = paletteIndex == PALETTE_USER ? _userPalette
+                               : paletteIndex == PALETTE_SEQUENCE ? _palettes.palette()
+                               : CRGBPalette16( *palettes[paletteIndex] ) ;
+
+   for ( uint8_t i = 0; i < _numLeds; i++) {
+     _leds[i] = ColorFromPalette( palette, colorIndex, 255, LINEARBLEND );
      colorIndex += STEPS;
    }
 
@@ -83,11 +246,11 @@
    #endif
 
  #ifdef USING_MPU
-   FastLED.setBrightness( map( constrain(aaRealZ, 0, P_MAX_POS_ACCEL), 0, P_MAX_POS_ACCEL, *_currentBrightness, 10 )) ;
+   _brightness = map( constrain(aaRealZ, 0, P_MAX_POS_ACCEL), 0, P_MAX_POS_ACCEL, *_currentBrightness, 10 ) ;
  #else
-   FastLED.setBrightness( *_currentBrightness );
+   _brightness = *_currentBrightness ;
  #endif
-   FastLED.show();
+   show();
 
  //#if defined(GLOWSTAFF) || defined(BALLOON)
  #if defined(RING) || defined( HOOP )
@@ -98,67 +261,61 @@
  }
 
 
- #ifdef RT_FADE_GLITTER
  void LEDRoutines::fadeGlitter() {
    addGlitter(70);
-   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness ; // Add 50% brightness
+   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness ; // Add 50% brightness
    #ifdef ESP8266
-     FastLED.setBrightness( _max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = _min(extraBright,255) ; // but restrict it to 255
    #else
-     FastLED.setBrightness( max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = min(extraBright,255) ; // but restrict it to 255
    #endif
-   FastLED.show();
-   fadeToBlackBy(leds, NUM_LEDS, 50);
+   show();
+   fadeToBlackBy(_leds, _numLeds, 50);
  }
- #endif
 
- #ifdef RT_DISCO_GLITTER
  void LEDRoutines::discoGlitter() {
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
+   fill_solid(_leds, _numLeds, CRGB::Black);
  #ifdef USING_MPU
    addGlitter(map( constrain( activityLevel(), 0, 3000), 0, 3000, 100, 255 ));
  #else
    addGlitter( 255 ) ;
  #endif
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  }
- #endif
 
- #ifdef RT_STROBE1
  #define FLASHLENGTH 20
  void LEDRoutines::strobe1() {
-   if ( tapTempo.beatProgress() > 0.95 ) {
+   if ( _tapTempo->beatProgress() > 0.95 ) {
  #ifdef USING_MPU
-     fill_solid(leds, NUM_LEDS, CHSV( map( yprX, 0, 360, 0, 255 ), 255, 255)); // yaw for color
+     fill_solid(_leds, _numLeds, CHSV( map( yprX, 0, 360, 0, 255 ), 255, 255)); // yaw for color
  #else
-     fill_solid(leds, NUM_LEDS, CHSV( 0, 255, 255)); // yaw for color
+     fill_solid(_leds, _numLeds, CHSV( 0, 255, 255)); // yaw for color
  #endif
-   } else if ( tapTempo.beatProgress() > 0.80 and tapTempo.beatProgress() < 0.85 ) {
-     fill_solid(leds, NUM_LEDS, CRGB::White );
+   } else if ( _tapTempo->beatProgress() > 0.80 and _tapTempo->beatProgress() < 0.85 ) {
+     fill_solid(_leds, _numLeds, CRGB::White );
    } else {
-     fill_solid(leds, NUM_LEDS, CRGB::Black); // black
+     fill_solid(_leds, _numLeds, CRGB::Black); // black
    }
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   if ( _power ) _power->solidFrame( _leds[0] ) ;
+   _brightness = *_currentBrightness ;
+   show();
  }
- #endif
 
- #ifdef RT_STROBE2
+ #ifdef USING_MPU
  #define S_SENSITIVITY 3500  // lower for less movement to trigger accelerometer routines
 
  void LEDRoutines::strobe2() {
    if ( activityLevel() > S_SENSITIVITY ) {
-     fill_solid(leds, NUM_LEDS, CHSV( map( yprX, 0, 360, 0, 255 ), 255, currentBrightness)); // yaw for color
+     fill_solid(_leds, _numLeds, CHSV( map( yprX, 0, 360, 0, 255 ), 255, *_currentBrightness)); // yaw for color
    } else {
      fadeall(120);
    }
-   FastLED.show();
+   show();
  }
  #endif
 
 
- #ifdef RT_FIRE2012
  // Fire2012 by Mark Kriegsman, July 2012
 
  // COOLING: How much does the air cool as it rises?
@@ -177,12 +334,12 @@
      static byte heat[NUM_LEDS];
 
      // Step 1.  Cool down every cell a little
-       for( int i = 0; i < NUM_LEDS; i++) {
-         heat[i] = qsub8( heat[i],  random8(0, ((COOLING * 10) / NUM_LEDS) + 2));
+       for( int i = 0; i < _numLeds; i++) {
+         heat[i] = qsub8( heat[i],  random8(0, ((COOLING * 10) / _numLeds) + 2));
        }
 
        // Step 2.  Heat from each cell drifts 'up' and diffuses a little
-       for( int k= NUM_LEDS - 1; k >= 2; k--) {
+       for( int k= _numLeds - 1; k >= 2; k--) {
          heat[k] = (heat[k - 1] + heat[k - 2] + heat[k - 2] ) / 3;
        }
 
@@ -193,18 +350,18 @@
        }
 
        // Step 4.  Map from heat cells to LED colors
-       for( int j = 0; j < NUM_LEDS; j++) {
+       for( int j = 0; j < _numLeds; j++) {
          CRGB color = HeatColor( heat[j]);
          int pixelnumber;
          if( gReverseDirection ) {
-           pixelnumber = (NUM_LEDS-1) - j;
+           pixelnumber = (_numLeds-1) - j;
          } else {
            pixelnumber = j;
          }
          _leds[pixelnumber] = color;
        }
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
 
    #ifdef USING_MPU
      if ( isMpuUp() ) {
@@ -218,66 +375,50 @@
 
 
  } // end Fire2012
- #endif
 
 
- #ifdef RT_RACERS
  void LEDRoutines::racingLeds() {
-   //  static long loopCounter = 0 ;
-   static uint8_t racer[] = {0, 1, 2, 3}; // Starting positions
-   static int racerDir[] = {1, 1, 1, 1}; // Current direction
-   static int racerSpeed[] = { random8(1, 4), random8(1, 4) , random8(1, 4), random8(1, 4) }; // Starting speed
-   const CRGB racerColor[] = { CRGB::Red, CRGB::Blue, CRGB::White, CRGB::Orange }; // Racer colors
-
- #define NUMRACERS sizeof(racer) //array size
+   static const CRGB racerColor[] = { CRGB::Red, CRGB::Blue, CRGB::White, CRGB::Orange }; // Racer colors
+   #define NUMRACERS ( sizeof(racerColor) / sizeof(racerColor[0]) )
+   static ParticlePool<NUMRACERS> racers( PARTICLE_WRAP ) ;   // round and round, never die, so index = racer
 
-   fill_solid(leds, NUM_LEDS, CRGB::Black);    // Start with black slate
+   if ( racers.count() == 0 ) {
+     for ( uint8_t i = 0; i < NUMRACERS ; i++ ) {
+       racers.emit( i * 256, 256 / random8(1, 4), racerColor[i] ) ;   // one LED every 1-3 frames
+     }
+   }
 
-   for ( uint8_t i = 0; i < NUMRACERS ; i++ ) {
-     _leds[racer[i]] = racerColor[i]; // Assign color
+   fill_solid(_leds, _numLeds, CRGB::Black);    // Start with black slate
+   racers.render( _leds, _numLeds ) ;
 
-     // If _taskLedModeSelect.getRunCounter() is evenly divisible by 'speed' then check if we've reached the end (if so, reverse), and do a step
-     if ( ( _taskLedModeSelect.getRunCounter() % racerSpeed[i]) == 0 ) {
-       if ( racer[i] + racerDir[i] >= NUM_LEDS) {
-         racer[i] = 0 ;
-       } else {
-         racer[i] += racerDir[i] ;
-       }
-       /*
-             if ( (racer[i] + racerDir[i] >= NUM_LEDS) or (racer[i] + racerDir[i] <= 0) ) {
-               racerDir[i] *= -1 ;
-             }
-             racer[i] += racerDir[i] ;
-       */
-     }
+   _brightness = *_currentBrightness ;
+   show();
 
-     if ( (_taskLedModeSelect.getRunCounter() % 40 ) == 0 ) {
-       racerSpeed[i] = random8(2, 6) ;  // Randomly speed up or slow down
+   racers.update( _numLeds ) ;
+   if ( (_taskLedModeSelect->getRunCounter() % 40 ) == 0 ) {
+     for ( uint8_t i = 0; i < NUMRACERS ; i++ ) {
+       racers.vel(i) = 256 / random8(2, 6) ;  // Randomly speed up or slow down
      }
    }
-
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
  } // end racers()
- #endif
 
 
- #ifdef RT_WAVE
+ #ifdef USING_MPU
  #define WAVE_MAX_NEG_ACCEL -5000
  #define WAVE_MAX_POS_ACCEL 5000
  #define MIN_BRIGHT 20
 
  void LEDRoutines::waveYourArms() {
    // Use yaw for color; use accelZ for brightness
-   fill_solid(leds, NUM_LEDS, CHSV( map( yprX, 0, 360, 0, 255 ) , 255, map( constrain(aaRealZ, WAVE_MAX_NEG_ACCEL, WAVE_MAX_POS_ACCEL), WAVE_MAX_NEG_ACCEL, WAVE_MAX_POS_ACCEL, MIN_BRIGHT, 255 )) );
+   fill_solid(_leds, _numLeds, CHSV( map( yprX, 0, 360, 0, 255 ) , 255, map( constrain(aaRealZ, WAVE_MAX_NEG_ACCEL, WAVE_MAX_POS_ACCEL), WAVE_MAX_NEG_ACCEL, WAVE_MAX_POS_ACCEL, MIN_BRIGHT, 255 )) );
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  }
  #endif
 
 
- #ifdef RT_SHAKE_IT
+ #ifdef USING_MPU
  #define SENSITIVITY 3000  // lower for less movement to trigger
 
  void LEDRoutines::shakeIt() {
@@ -286,7 +427,7 @@
    if ( isMpuUp() ) {  // Start near controller if down
      startLed = 0 ;
    } else if ( isMpuDown() ) {
-     startLed = NUM_LEDS - 1 ;
+     startLed = _numLeds - 1 ;
    }
 
    if ( activityLevel() > SENSITIVITY ) {
@@ -295,23 +436,23 @@
      _leds[startLed] = CHSV(0, 0, 0); // black
    }
 
-   //  for (int8_t i = NUM_LEDS - 2; i >= 0 ; i--) {
+   //  for (int8_t i = _numLeds - 2; i >= 0 ; i--) {
    //    _leds[i + 1] = _leds[i];
    //  }
 
    if ( isMpuUp() ) {
-     for (int8_t i = NUM_LEDS - 2; i >= 0 ; i--) {
+     for (int8_t i = _numLeds - 2; i >= 0 ; i--) {
        _leds[i + 1] = _leds[i];
      }
    } else if ( isMpuDown() ) {
-     for (int8_t i = 0 ; i <= NUM_LEDS - 2 ; i++) {
+     for (int8_t i = 0 ; i <= _numLeds - 2 ; i++) {
        _leds[i] = _leds[i + 1];
      }
    }
 
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  }
  #endif
 
@@ -344,11 +485,11 @@
    }
    patternCopy[STRIPE_LENGTH - 1] = _leds[startLed + STRIPE_LENGTH] ;
 
-   fill_gradient(leds, startLed + 1, CHSV(0, 0, 255), startLed + STRIPE_LENGTH, CHSV(0, 0, 255), SHORTEST_HUES);
+   fill_gradient(_leds, startLed + 1, CHSV(0, 0, 255), startLed + STRIPE_LENGTH, CHSV(0, 0, 255), SHORTEST_HUES);
 
    startLed++ ;
 
-   if ( startLed + STRIPE_LENGTH == NUM_LEDS - 1) { // LED nr 90 is index 89
+   if ( startLed + STRIPE_LENGTH == _numLeds - 1) { // LED nr 90 is index 89
      for (uint8_t i = startLed; i < startLed + STRIPE_LENGTH; i++ ) {
        _leds[i] = patternCopy[i];
      }
@@ -357,22 +498,22 @@
      taskWhiteStripe.setInterval(random16(4000, 10000)) ;
    }
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  }
  #endif
 
 
- #ifdef RT_GLED_ORIGINAL
+ #ifdef USING_MPU
  void LEDRoutines::gLedOrig() {
-   _leds[lowestPoint()] = ColorFromPalette( PartyColors_p, _taskLedModeSelect.getRunCounter(), currentBrightness, NOBLEND );
-   FastLED.show();
-   fadeToBlackBy(leds, NUM_LEDS, 200);
+   _leds[lowestPoint()] = ColorFromPalette( PartyColors_p, _taskLedModeSelect->getRunCounter(), *_currentBrightness, NOBLEND );
+   show();
+   fadeToBlackBy(_leds, _numLeds, 200);
  }
  #endif
 
 
- #ifdef RT_GLED
+ #ifdef USING_MPU
  // Gravity LED: lights up a small gradient at the lowest point on the ring
  #define GLED_WIDTH 3
  void LEDRoutines::gLed() {
@@ -380,15 +521,14 @@
    static uint8_t hue = 0 ;
    fillGradientRing( ledPos, CHSV(hue, 255, 0) , ledPos + GLED_WIDTH , CHSV(hue, 255, 255) ) ;
    fillGradientRing( ledPos + GLED_WIDTH + 1, CHSV(hue, 255, 255), ledPos + GLED_WIDTH + GLED_WIDTH, CHSV(hue, 255, 0) ) ;
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
    hue++ ;
  }
  #endif
 
 
 
- #if defined(RT_TWIRL1) || defined(RT_TWIRL2) || defined(RT_TWIRL4) || defined(RT_TWIRL6) || defined(RT_TWIRL2_O) || defined(RT_TWIRL4_O) || defined(RT_TWIRL6_O)
  // Counter rotating twirlers with blending
  // 1 twirler - 1 white = 120/1
  // 2 twirler - 1 white = 120/1
@@ -404,7 +544,7 @@
    } else {
      speedCorrection = numTwirlers / 2 ;
    }
-   uint8_t clockwiseFirst = /8by8( 0, NUM_LEDS, beat8( tapTempo.getBPM() / speedCorrection )) ;
+   uint8_t clockwiseFirst = lerp8by8( 0, _numLeds, beat8( _tapTempo->getBPM() / speedCorrection )) ;
    const CRGB clockwiseColor = CRGB::White ;
    const CRGB antiClockwiseColor = CRGB::Red ;
 
@@ -416,7 +556,7 @@
 
    for (uint8_t i = 0 ; i < numTwirlers ; i++) {
      if ( (i % 2) == 0 ) {
-       pos = (clockwiseFirst + round( NUM_LEDS / numTwirlers ) * i) % NUM_LEDS ;
+       pos = (clockwiseFirst + ( _numLeds / numTwirlers ) * i) % _numLeds ;
        if ( _leds[pos] ) { // FALSE if currently BLACK - don't blend with black
          _leds[pos] = blend( _leds[pos], clockwiseColor, 128 ) ;
        } else {
@@ -426,10 +566,10 @@
      } else {
 
        if ( opposing ) {
-         uint8_t antiClockwiseFirst = NUM_LEDS - (lerp8by8( 0, NUM_LEDS, beat8( tapTempo.getBPM() / speedCorrection ))) % NUM_LEDS ;
-         pos = (antiClockwiseFirst + round( NUM_LEDS / numTwirlers ) * i) % NUM_LEDS ;
+         uint8_t antiClockwiseFirst = _numLeds - (lerp8by8( 0, _numLeds, beat8( _tapTempo->getBPM() / speedCorrection ))) % _numLeds ;
+         pos = (antiClockwiseFirst + ( _numLeds / numTwirlers ) * i) % _numLeds ;
        } else {
-         pos = (clockwiseFirst + round( NUM_LEDS / numTwirlers ) * i) % NUM_LEDS ;
+         pos = (clockwiseFirst + ( _numLeds / numTwirlers ) * i) % _numLeds ;
        }
        if ( _leds[pos] ) { // FALSE if currently BLACK - don't blend with black
          _leds[pos] = blend( _leds[pos], antiClockwiseColor, 128 ) ;
@@ -439,107 +579,47 @@
      }
 
    }
-   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness ; // Add 50% brightness
+   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness ; // Add 50% brightness
    #ifdef ESP8266
-     FastLED.setBrightness( _max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = _min(extraBright,255) ; // but restrict it to 255
    #else
-     FastLED.setBrightness( max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = min(extraBright,255) ; // but restrict it to 255
    #endif
-   FastLED.show();
- //  _taskLedModeSelect.setInterval( 1 * TASK_RES_MULTIPLIER ) ;
+   show();
+ //  _taskLedModeSelect->setInterval( 1 * TASK_RES_MULTIPLIER ) ;
  }
- #endif
 
 
- #ifdef RT_HEARTBEAT
  void LEDRoutines::heartbeat() {
-   const uint8_t hbTable[] = {
-     25,
-     61,
-     105,
-     153,
-     197,
-     233,
-     253,
-     255,
-     252,
-     243,
-     230,
-     213,
-     194,
-     149,
-     101,
-     105,
-     153,
-     197,
-     216,
-     233,
-     244,
-     253,
-     255,
-     255,
-     252,
-     249,
-     243,
-     237,
-     230,
-     223,
-     213,
-     206,
-     194,
-     184,
-     174,
-     162,
-     149,
-     138,
-     126,
-     112,
-     101,
-     91,
-     78,
-     69,
-     62,
-     58,
-     51,
-     47,
-     43,
-     39,
-     37,
-     35,
-     29,
-     25,
-     22,
-     20,
-     19,
-     15,
-     12,
-     9,
-     8,
-     6,
-     5,
-     3
-   };
-
- #define NUM_STEPS (sizeof(hbTable)/sizeof(uint8_t)) //array size
-   //#define NUM_STEPS 64
-   fill_solid(leds, NUM_LEDS, CRGB::Red);
-   // beat8 generates index 0-255 (fract8) as per getBPM(). lerp8by8 interpolates that to array index:
-   uint8_t hbIndex = lerp8by8( 0, NUM_STEPS, beat8( tapTempo.getBPM() / 2 )) ;
-   uint8_t brightness = lerp8by8( 0, 255, hbTable[hbIndex] ) ;
-   //  DEBUG_PRINT(NUM_STEPS) ;
-   //  DEBUG_PRINT(F("\t")) ;
-   //  DEBUG_PRINT(hbIndex) ;
-   //  DEBUG_PRINT(F("\t")) ;
-   //  DEBUG_PRINT(brightness) ;
-   //  DEBUG_PRINTLN() ;
-
-   FastLED.setBrightness( brightness );
-   FastLED.show();
+   // Two thumps, then a long decay; positions are out of 256 per beat. Each
+   // keyframe is an entry of the 64-step table this used to step through
+   // (entry i at 4 * i), and the curve stays within 7 of the others.
+   static constexpr Keyframe hbKeys[] = {
+     {   0,  25, EASE_LINEAR },   // first thump
+     {   8, 105, EASE_OUT },
+     {  28, 255, EASE_IN },
+     {  48, 194, EASE_LINEAR },
+     {  56, 101, EASE_LINEAR },   // second thump
+     {  60, 105, EASE_LINEAR },
+     {  68, 197, EASE_LINEAR },
+     {  76, 233, EASE_LINEAR },
+     {  88, 255, EASE_IN },       // decay
+     { 124, 206, EASE_LINEAR },
+     { 172,  69, EASE_OUT },
+     { 256,   3, EASE_LINEAR }
+   } ;
+   static constexpr uint8_t hbCurve[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( hbKeys ) ;
+
+   fill_solid(_leds, _numLeds, CRGB::Red);
+   if ( _power ) _power->solidFrame( CRGB::Red ) ;
+   // One heartbeat every two beats
+   uint8_t brightness = curveSample( hbCurve, curvePhase( beat16( _tapTempo->getBPM() / 2 ) ) ) ;
+
+   _brightness = brightness ;
+   show();
  }
- #endif
 
 
- #if defined(RT_FASTLOOP) || defined(RT_FASTLOOP2)
 
  #define FL_LENGHT 20   // how many LEDs should be in the "stripe"
  #define FL_MIDPOINT FL_LENGHT / 2
@@ -550,29 +630,27 @@
    static uint8_t hue = 0 ;
 
    if ( ! reverse ) {
-     startP = lerp8by8( 0, NUM_LEDS, beat8( tapTempo.getBPM() )) ;  // start position
+     startP = lerp8by8( 0, _numLeds, beat8( _tapTempo->getBPM() )) ;  // start position
    } else {
-     startP += map( sin8( beat8( tapTempo.getBPM() / 4 )), 0, 255, -MAX_LOOP_SPEED, MAX_LOOP_SPEED + 1 ) ; // it was hard to write, it should be hard to undestand :grimacing:
+     startP += map( sin8( beat8( _tapTempo->getBPM() / 4 )), 0, 255, -MAX_LOOP_SPEED, MAX_LOOP_SPEED + 1 ) ; // it was hard to write, it should be hard to undestand :grimacing:
    }
 
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
+   fill_solid(_leds, _numLeds, CRGB::Black);
    fillGradientRing(startP, CHSV(hue, 255, 0), startP + FL_MIDPOINT, CHSV(hue, 255, 255));
    fillGradientRing(startP + FL_MIDPOINT + 1, CHSV(hue, 255, 255), startP + FL_LENGHT, CHSV(hue, 255, 0));
 
-   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness ; // Add 50% brightness
+   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness ; // Add 50% brightness
    #ifdef ESP8266
-     FastLED.setBrightness( _max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = _min(extraBright,255) ; // but restrict it to 255
    #else
-     FastLED.setBrightness( max(extraBright,255) ) ; // but restrict it to 255
+     _brightness = min(extraBright,255) ; // but restrict it to 255
    #endif
-   FastLED.show();
+   show();
    hue++  ;
 
  }
- #endif
 
 
- #if defined(RT_NOISE_LAVA) || defined(RT_NOISE_PARTY) || defined(RT_NOISE_OCEAN)
  // FastLED library NoisePlusPalette routine rewritten for 1 dimensional LED strip
  // - speed determines how fast time moves forward.  Try  1 for a very slow moving effect,
  // or 60 for something that ends up looking like water.
@@ -586,8 +664,11 @@
 
  void LEDRoutines::fillnoise8(uint8_t currentPalette, uint8_t speed, uint8_t scale, boolean colorLoop ) {
    static uint8_t noise[NUM_LEDS];
+   static uint8_t raw[NUM_LEDS];
+   static NoiseField field ;
 
-   const CRGBPalette16 palettes[] = { LavaColors_p, PartyColors_p, OceanColors_p } ;
+   static const TProgmemRGBPalette16* const palettes[] = { &LavaColors_p, &PartyColors_p, &OceanColors_p } ;
+   const CRGBPalette16 palette = currentPalette == PALETTE_SEQUENCE ? _palettes.palette() : CRGBPalette16( *palettes[currentPalette] ) ;
 
    static uint16_t x = random16();
    static uint16_t y = random16();
@@ -602,10 +683,20 @@
      dataSmoothing = 200 - (speed * 4);
    }
 
-   for (uint8_t i = 0; i < NUM_LEDS; i++) {
-     int ioffset = scale * i;
+ #ifdef LAYOUT_FAN
+   // Fans: one row of noise per blade, neighbouring blades are 'scale' apart
+   // in y so the pattern flows across blades as well as along them.
+   const uint8_t bladeLen = _layout->bladeLength() ;
+   const uint8_t blades = _layout->numBlades() ;
+   field.fillField( raw, bladeLen, blades, x, scale, y, scale, z ) ;
+   // any LEDs after the last full blade get a row of their own
+   field.fillStrip( raw + bladeLen * blades, _numLeds - bladeLen * blades, x, scale, y + scale * blades, z ) ;
+ #else
+   field.fillStrip( raw, _numLeds, x, scale, y, z ) ;
+ #endif
 
-     uint8_t data = inoise8(x + ioffset, y, z);
+   for (uint8_t i = 0; i < _numLeds; i++) {
+     uint8_t data = raw[i];
 
      // The range of the inoise8 function is roughly 16-238.
      // These two operations expand those values out to roughly 0..255
@@ -630,14 +721,14 @@
 
    static uint8_t ihue = 0;
 
-   for (uint8_t i = 0; i < NUM_LEDS; i++) {
+   for (uint8_t i = 0; i < _numLeds; i++) {
      // We use the value at the i coordinate in the noise
-     // array for our brightness, and a 'random' value from NUM_LEDS - 1
+     // array for our brightness, and a 'random' value from _numLeds - 1
      // for our pixel's index into the color palette.
 
      uint8_t index = noise[i];
-     uint8_t bri =   noise[NUM_LEDS - i];
-     // uint8_t bri =  sin(noise[NUM_LEDS - i]);  // more light/dark variation
+     uint8_t bri =   noise[_numLeds - 1 - i];
+     // uint8_t bri =  sin(noise[_numLeds - 1 - i]);  // more light/dark variation
 
      // if this palette is a 'loop', add a slowly-changing base value
      if ( colorLoop) {
@@ -649,58 +740,59 @@
      if ( bri > 127 ) {
        bri = 255;
      } else {
+ #ifdef COLOR_LUT
+       bri = bri * 2 ;            // the output gamma does the dimming
+ #else
        bri = dim8_raw( bri * 2);
+ #endif
      }
 
-     CRGB color = ColorFromPalette( palettes[currentPalette], index, bri);
+     CRGB color = ColorFromPalette( palette, index, bri);
      _leds[i] = color;
    }
    ihue += 1;
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  }
- #endif
 
 
- #ifdef RT_PENDULUM
  void LEDRoutines::pendulum() {
  #ifdef USING_MPU
    uint8_t hue = map( yprX, 0, 360, 0, 255 ) ; // yaw for color
  #else
    uint8_t hue = 0 ; // yaw for color
  #endif
-   uint8_t sPos1 = beatsin8( tapTempo.getBPM(), 0, NUM_LEDS / 2 ) ;
-   uint8_t sPos2 = beatsin8( tapTempo.getBPM(), NUM_LEDS / 2, NUM_LEDS ) ;
+   // Both halves swing off the same oscillator, so they stay in step
+   _osc.set( 0, 1, 1, WAVE_SINE ) ;
+   uint8_t sPos1 = _osc.range8( 0, 0, _numLeds / 2 ) ;
+   uint8_t sPos2 = _osc.range8( 0, _numLeds / 2, _numLeds ) ;
    fillGradientRing(sPos1, CHSV(hue, 255, 0), sPos1 + 10, CHSV(hue, 255, 255));
    fillGradientRing(sPos1 + 11, CHSV(hue, 255, 255), sPos1 + 20, CHSV(hue, 255, 0));
    fillGradientRing(sPos2, CHSV(hue + 128, 255, 0), sPos2 + 10, CHSV(hue + 128, 255, 255));
    fillGradientRing(sPos2 + 11, CHSV(hue + 128, 255, 255), sPos2 + 20, CHSV(hue + 128, 255, 0));
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
  } // end pendulum()
- #endif
 
 
 
- #ifdef RT_BOUNCEBLEND
  void LEDRoutines::bounceBlend() {
-   uint8_t speed = beatsin8( tapTempo.getBPM(), 0, 255);
+   uint8_t speed = beatsin8( _tapTempo->getBPM(), 0, 255);
    static uint8_t startLed = 1 ;
    CHSV endclr = blend(CHSV(0, 255, 255), CHSV(160, 255, 0) , speed);
    CHSV midclr = blend(CHSV(160, 255, 0) , CHSV(0, 255, 255) , speed);
-   fillGradientRing(startLed, endclr, startLed + NUM_LEDS / 2, midclr);
-   fillGradientRing(startLed + NUM_LEDS / 2 + 1, midclr, startLed + NUM_LEDS, endclr);
+   fillGradientRing(startLed, endclr, startLed + _numLeds / 2, midclr);
+   fillGradientRing(startLed + _numLeds / 2 + 1, midclr, startLed + _numLeds, endclr);
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
 
-   if ( (_taskLedModeSelect.getRunCounter() % 10 ) == 0 ) {
+   if ( (_taskLedModeSelect->getRunCounter() % 10 ) == 0 ) {
      startLed++ ;
-     if ( startLed + 1 == NUM_LEDS ) startLed = 0  ;
+     if ( startLed + 1 == _numLeds ) startLed = 0  ;
    }
  } // end bounceBlend()
- #endif
 
 
  /* juggle_pal
@@ -710,7 +802,6 @@
     Date: May, 2017
  */
 
- #ifdef RT_JUGGLE_PAL
  void LEDRoutines::jugglePal() {                                             // A time (rather than loop) based demo sequencer. This gives us full control over the length of each sequence.
 
    static uint8_t    numdots =   4;                                     // Number of dots in use.
@@ -718,10 +809,9 @@
    static uint8_t   thisdiff =  16;                                     // Incremental change in hue between each dot.
    static uint8_t    thishue =   0;                                     // Starting hue.
    static uint8_t     curhue =   0;                                     // The current hue
-   static uint8_t   thisbeat =   35;                                     // Higher = faster movement.
    static float   fadeFactor = 1.00;                                     // 120 is reference BPM. Fade values are calculated for that.
 
-   uint8_t secondHand = (millis() / 1000) % 60;                // Change '60' to a different value to change duration of the loop (also change timings below)
+   uint8_t secondHand = (now() / 1000) % 60;                   // Change '60' to a different value to change duration of the loop (also change timings below)
    static uint8_t lastSecond = 99;                             // This is our 'debounce' variable.
 
 
@@ -729,20 +819,22 @@
    if (lastSecond != secondHand) {                             // Debounce to make sure we're not repeating an assignment.
      lastSecond = secondHand;
      switch (secondHand) {
-       case  1: numdots = 1; thisbeat = tapTempo.getBPM() / 2; thisdiff = 8;  thisfade = (int)8*fadeFactor;  thishue = 0;   break;
-       case  6: numdots = 2; thisbeat = tapTempo.getBPM() / 2; thisdiff = 4;  thisfade = (int)12*fadeFactor; thishue = 0;   break;
-       case 25: numdots = 4; thisbeat = tapTempo.getBPM() / 2; thisdiff = 24; thisfade = (int)50*fadeFactor; thishue = 128; break;
-       case 40: numdots = 2; thisbeat = tapTempo.getBPM() / 2; thisdiff = 16; thisfade = (int)50*fadeFactor; thishue = 0; break;
-       case 52: numdots = 4; thisbeat = tapTempo.getBPM() / 2; thisdiff = 24; thisfade = (int)80*fadeFactor; thishue = 160; break;
+       case  1: numdots = 1; thisdiff = 8;  thisfade = (int)8*fadeFactor;  thishue = 0;   break;
+       case  6: numdots = 2; thisdiff = 4;  thisfade = (int)12*fadeFactor; thishue = 0;   break;
+       case 25: numdots = 4; thisdiff = 24; thisfade = (int)50*fadeFactor; thishue = 128; break;
+       case 40: numdots = 2; thisdiff = 16; thisfade = (int)50*fadeFactor; thishue = 0; break;
+       case 52: numdots = 4; thisdiff = 24; thisfade = (int)80*fadeFactor; thishue = 160; break;
      }
-     fadeFactor = tapTempo.getBPM() / 120 ;
+     fadeFactor = _tapTempo->getBPM() / 120 ;
    }
 
    curhue = thishue;                                           // Reset the hue values.
-   fadeToBlackBy(leds, NUM_LEDS, thisfade);
+   fadeToBlackBy(_leds, _numLeds, thisfade);
 
    for ( uint8_t i = 0; i < numdots; i++) {
-     uint8_t whichLED = beatsin16(thisbeat + i + numdots, 0, NUM_LEDS - 1);
+     // Half the tempo, each dot a little faster than the one before (~1 BPM at 120)
+     _osc.set( i, 64 + i + numdots, 128, WAVE_SINE ) ;
+     uint8_t whichLED = _osc.range16( i, 0, _numLeds - 1 ) ;
      // if( numdots == 1 ) {
      //   DEBUG_PRINT(whichLED);
      //   DEBUG_PRINT(" ");
@@ -752,66 +844,62 @@
      curhue += thisdiff;
    }
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
 
  } // end jugglePal()
- #endif
 
 
- #ifdef RT_QUAD_STROBE
 
  // TODO: make strobes shorter
  void LEDRoutines::quadStrobe() {
    static uint8_t shift = 0 ;
-   uint8_t triwave = triwave8( _taskLedModeSelect.getRunCounter() * 6 ) ;
+   uint8_t triwave = triwave8( _taskLedModeSelect->getRunCounter() * 6 ) ;
    uint8_t striplength = lerp8by8( 1, 16, triwave ) ;
-   uint8_t startP = mod( _taskLedModeSelect.getRunCounter() * 15 + shift, NUM_LEDS ) ;
+   uint8_t startP = mod( _taskLedModeSelect->getRunCounter() * 15 + shift, _numLeds ) ;
 
-   fill_solid( leds, NUM_LEDS, CRGB::Black ) ;
+   fill_solid( _leds, _numLeds, CRGB::Black ) ;
    fillSolidRing( startP, startP + striplength, CHSV(0, 0, 255) ) ; // white
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
 
    if ( striplength == 1 ) shift++ ; // shift the sequence on clockwise
  } // end quadStrobe()
- #endif
 
 
- #ifdef RT_PULSE_3
  #define PULSE_WIDTH 10
  void LEDRoutines::pulse3() {
-   uint8_t width = beatsin8( constrain( tapTempo.getBPM() * 2, 0, 255), 0, PULSE_WIDTH ) ; // can't use BPM > 255
+   uint8_t width = beatsin8( constrain( _tapTempo->getBPM() * 2, 0, 255), 0, PULSE_WIDTH ) ; // can't use BPM > 255
    uint8_t hue = beatsin8( 1, 0, 255) ;
    static uint8_t middle = 0 ;
 
    if ( width == 1 ) {
-     middle = _taskLedModeSelect.getRunCounter() % 60 + _taskLedModeSelect.getRunCounter() % 2;
+     middle = _taskLedModeSelect->getRunCounter() % 60 + _taskLedModeSelect->getRunCounter() % 2;
    }
 
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
+   fill_solid(_leds, _numLeds, CRGB::Black);
    fillGradientRing(middle - width, CHSV(hue, 255, 0), middle, CHSV(hue, 255, 255));
    fillGradientRing(middle, CHSV(hue, 255, 255), middle + width, CHSV(hue, 255, 0));
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show() ;
+   _brightness = *_currentBrightness ;
+   show() ;
  }
- #endif
 
- #if defined(RT_PULSE_5_1) || defined(RT_PULSE_5_2) || defined(RT_PULSE_5_3)
  void LEDRoutines::pulse5( uint8_t numPulses, boolean leadingDot) {
-   uint8_t spacing = NUM_LEDS / numPulses ;
+   uint8_t spacing = _numLeds / numPulses ;
    uint8_t pulseWidth = (spacing / 2) - 1 ; // leave 1 led empty at max
-   uint8_t middle = beatsin8( 10, 0, NUM_LEDS / 2) ;
-   uint8_t width = beatsin8( tapTempo.getBPM(), 0, pulseWidth) ;
+   _osc.set( 0, 1, 12, WAVE_SINE ) ;   // drifts along once every 12 beats: 10 BPM at 120, and follows the tap
+   _osc.set( 1, 1, 1, WAVE_SINE ) ;    // breathes on the beat
+   uint8_t middle = _osc.range8( 0, 0, _numLeds / 2 ) ;
+   uint8_t width = _osc.range8( 1, 0, pulseWidth ) ;
  #ifdef USING_MPU
    uint8_t hue = map( yprX, 0, 360, 0, 255 ) ;
  #else
    uint8_t hue = 180 ;
  #endif
 
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
+   fill_solid(_leds, _numLeds, CRGB::Black);
 
    for ( uint8_t i = 0 ; i < numPulses; i++ ) {
      uint8_t offset = spacing * i ;
@@ -824,14 +912,12 @@
      }
    }
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show() ;
+   _brightness = *_currentBrightness ;
+   show() ;
  }
- #endif
 
 
 
- #ifdef RT_THREE_SIN_PAL
 
  /* three_sin_pal_demo
     By: Andrew Tuline
@@ -844,67 +930,34 @@
  #define MUL2 6
  #define MUL3 5
  void LEDRoutines::threeSinPal() {
-   static int wave1 = 0;                                                // Current phase is calculated.
-   static int wave2 = 0;
-   static int wave3 = 0;
-
-   static CRGBPalette16 currentPalette(CRGB::Black);
-   static CRGBPalette16 targetPalette(PartyColors_p);
-
-   if ( _taskLedModeSelect.getRunCounter() % 2 == 0 ) {
-     nblendPaletteTowardPalette( currentPalette, targetPalette, MAXCHANGES);
+   static uint8_t wave1 = 0;                                            // Current phase is calculated; wraps like the sin8() angle it feeds.
+   static uint8_t wave2 = 0;
+   static uint8_t wave3 = 0;
 
+   if ( _taskLedModeSelect->getRunCounter() % 2 == 0 ) {
      wave1 += beatsin8(10, -4, 4);
      wave2 += beatsin8(15, -2, 2);
      wave3 += beatsin8(12, -3, 3);
 
-     for (int k = 0; k < NUM_LEDS; k++) {
+     // The palette changes every few seconds, see paletteSteps
+     const CRGBPalette16& palette = _palettes.palette() ;
+     for (int k = 0; k < _numLeds; k++) {
        uint8_t tmp = sin8(MUL1 * k + wave1) + sin8(MUL2 * k + wave2) + sin8(MUL3 * k + wave3);
-       _leds[k] = ColorFromPalette(currentPalette, tmp, 255);
-     }
-   }
-
-   uint8_t secondHand = (millis() / 1000) % 60;
-   static uint8_t lastSecond = 99;
-
-   if ( lastSecond != secondHand) {
-     lastSecond = secondHand;
-     CRGB p = CHSV( HUE_PURPLE, 255, 255);
-     CRGB g = CHSV( HUE_GREEN, 255, 255);
-     CRGB u = CHSV( HUE_BLUE, 255, 255);
-     CRGB b = CRGB::Black;
-     CRGB w = CRGB::White;
-
-     switch (secondHand) {
-       case  0: targetPalette = RainbowColors_p; break;
-       case  5: targetPalette = CRGBPalette16( u, u, b, b, p, p, b, b, u, u, b, b, p, p, b, b); break;
-       case 10: targetPalette = OceanColors_p; break;
-       case 15: targetPalette = CloudColors_p; break;
-       case 20: targetPalette = LavaColors_p; break;
-       case 25: targetPalette = ForestColors_p; break;
-       case 30: targetPalette = PartyColors_p; break;
-       case 35: targetPalette = CRGBPalette16( b, b, b, w, b, b, b, w, b, b, b, w, b, b, b, w); break;
-       case 40: targetPalette = CRGBPalette16( u, u, u, w, u, u, u, w, u, u, u, w, u, u, u, w); break;
-       case 45: targetPalette = CRGBPalette16( u, p, u, w, p, u, u, w, u, g, u, w, u, p, u, w); break;
-       case 50: targetPalette = CloudColors_p; break;
-       case 55: targetPalette = CRGBPalette16( u, u, u, w, u, u, p, p, u, p, p, p, u, p, p, w); break;
-       case 60: break;
+       _leds[k] = ColorFromPalette(palette, tmp, 255);
      }
    }
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
 
  } // threeSinPal()
- #endif
 
 
 
- #ifdef RT_COLOR_GLOW
  void LEDRoutines::colorGlow() {
    static uint8_t paletteColorIndex = 0 ;
    static bool indexUpdated = false ;
-   uint8_t brightness = beatsin8( tapTempo.getBPM(), 0, 255 ) ;
+   uint8_t brightness = beatsin8( _tapTempo->getBPM(), 0, 255 ) ;
 
    // To ensure we update paletteColorIndex only once per brightness cycle, use the flag indexUpdated.
    if( brightness < 5 and not indexUpdated ) {
@@ -918,81 +971,94 @@
  //    Serial.println("going back up");
    }
 
-   fill_solid(leds, NUM_LEDS, ColorFromPalette( RainbowColors_p, paletteColorIndex, brightness, LINEARBLEND ));
-   // fill_solid(leds, NUM_LEDS, CRGB::Blue);
+   fill_solid(_leds, _numLeds, ColorFromPalette( RainbowColors_p, paletteColorIndex, brightness, LINEARBLEND ));
+   // fill_solid(_leds, _numLeds, CRGB::Blue);
+   if ( _power ) _power->solidFrame( _leds[0] ) ;
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show() ;
+   _brightness = *_currentBrightness ;
+   show() ;
  }
- #endif
 
- #ifdef RT_FAN_WIPE
  void LEDRoutines::fanWipe() {
      uint8_t hue = beatsin8( 1, 0, 255) ;
- //    uint8_t vertIndex = lerp8by8( 0, 6, triwave8( _taskLedModeSelect.getRunCounter() % 128 ) * 2 ) ;
-     uint8_t vertIndex = beatsin8( 45, 0, 5 ) ;
+ //    uint8_t vertIndex = lerp8by8( 0, 6, triwave8( _taskLedModeSelect->getRunCounter() % 128 ) * 2 ) ;
+     uint8_t vertIndex = beatsin8( 45, 0, _layout->bladeLength() - 1 ) ;
 
- //    fill_solid(leds, NUM_LEDS, CRGB::Black);
+ //    fill_solid(_leds, _numLeds, CRGB::Black);
  //   DEBUG_PRINTLN(vertIndex) ;
 
-     for(uint8_t blade = 0 ; blade < NUM_BLADES; blade++ ) {
-       _leds[vertIndex+(blade*6)] = CHSV(hue, 255, 255) ;
+     for(uint8_t blade = 0 ; blade < _layout->numBlades(); blade++ ) {
+       _leds[_layout->ledAt(blade, vertIndex)] = CHSV(hue, 255, 255) ;
      }
      // if( vertIndex == 0 ) {
      // } else {
      //   _leds[vertIndex-1] = CHSV(hue, 255, 255) ; // blade 0
      // }
 
-     FastLED.setBrightness( currentBrightness ) ;
-     FastLED.show() ;
-     fadeToBlackBy(leds, NUM_LEDS, 25);
+     _brightness = *_currentBrightness ;
+     show() ;
+     fadeToBlackBy(_leds, _numLeds, 25);
    }
- #endif
 
- #ifdef RT_DROPLETS
  //#define STOPPING
  void LEDRoutines::droplets() {
-   //  static long loopCounter = 0 ;
-   // static uint8_t droplet[] = { random8(0, NUM_LEDS - 1), random8(0, NUM_LEDS - 1), random8(0, NUM_LEDS - 1), random8(0, NUM_LEDS - 1) }; // Starting positions
-   static uint8_t droplet[] = { 1, 1, 1, 1 }; // Starting positions
-   static int dropletSpeed[] = { random8(1, 3), random8(1, 3) , random8(1, 3), random8(1, 3) }; // Starting speed
-   //static int dropletSpeed[] = { 1, 1, 1, 1 }; // Starting speed
-   const CRGB dropletColor[] = { CRGB::White, CRGB::White, CRGB::White, CRGB::White }; // droplet colors
+   #define NUM_DROPLETS 4
+   static ParticlePool<NUM_DROPLETS> drops( PARTICLE_DIE ) ;   // fall off the end, start again near the top
 
-   #define NUM_DROPLETS sizeof(droplet) //array size
+   while ( drops.count() < NUM_DROPLETS ) {
+     drops.emit( random8(1, 30) * 256, 256 / random8(1, 3), CRGB::White ) ;
+   }
 
-   for ( uint8_t i = 0; i < NUM_DROPLETS ; i++ ) {
-     _leds[droplet[i]] = dropletColor[i]; // Assign droplet color
-     _leds[droplet[i]-1] = CRGB::Red ; // Assign tail
+   for ( uint8_t i = 0; i < drops.count() ; i++ ) {
+     uint8_t led = drops.pos(i) >> 8 ;
+     if ( led ) _leds[led - 1] = CRGB::Red ; // Assign tail
 
      #ifdef STOPPING
-     if( random8(1,10) == 5 && dropletSpeed[i] < 2 ) {
-       dropletSpeed[i] = random8(2, 3);
-     } else if( random8(1,20) == 5 && dropletSpeed[i] >= 2 ) {
-       dropletSpeed[i] = random8(0, 1);
+     if( random8(1,10) == 5 && drops.vel(i) != 128 ) {
+       drops.vel(i) = 128;    // running or stopped: slow down / start again
+     } else if( random8(1,20) == 5 && drops.vel(i) == 128 ) {
+       drops.vel(i) = 0;      // slow: stop
      }
 
      if( random8(1,50) == 5 ) {
-       droplet[i] = random8(1, NUM_LEDS - 10) ;
+       drops.pos(i) = random8(1, _numLeds - 10) * 256 ;
      }
      #endif
-
-     // If _taskLedModeSelect.getRunCounter() is evenly divisible by 'speed' then check if we've reached the end (if so, pick a new random starting point)
-     if( ( _taskLedModeSelect.getRunCounter() % dropletSpeed[i]) == 0 ) {
-       if ( droplet[i] + 1 >= NUM_LEDS) {
-         droplet[i] = random8(1, 30) ;
-       } else {
-         droplet[i] += 1 ;
-       }
-
-     }
    }
+   drops.render( _leds, _numLeds ) ;
 
-   FastLED.setBrightness( currentBrightness ) ;
-   FastLED.show();
+   _brightness = *_currentBrightness ;
+   show();
    fadeall(210);
+   drops.update( _numLeds ) ;
  } // end droplets()
- #endif
+
+
+ // Level meter from LED 0 up, green to red, with a peak dot that falls back
+ // slowly; the dot flashes white on a kick (onset in the two lowest bands).
+ void LEDRoutines::vuMeter() {
+   static uint8_t peakLed = 0 ;
+   if ( ! _audio ) return ;
+   bool kick = _audio->onsets() & 0x03 ;
+
+   uint8_t lit = scale8( _audio->volume(), _numLeds ) ;
+   if ( lit > peakLed ) {
+     peakLed = lit ;
+   } else if ( peakLed && ( _taskLedModeSelect->getRunCounter() % 4 ) == 0 ) {
+     peakLed-- ;
+   }
+
+   fill_solid(_leds, _numLeds, CRGB::Black);
+   for ( uint8_t i = 0 ; i < lit ; i++ ) {
+     _leds[i] = CHSV( HUE_GREEN - ( i * HUE_GREEN ) / _numLeds, 255, 255 ) ;
+   }
+   if ( peakLed ) {
+     _leds[peakLed - 1] = kick ? CRGB::White : CRGB::Red ;
+   }
+
+   _brightness = *_currentBrightness ;
+   show();
+ }
 
 
 
@@ -1004,29 +1070,28 @@
 
  void LEDRoutines::povPatterns(unsigned long time, const char pattern[][NUM_LEDS][3], int pictureWidth)
  {
-   unsigned long currentTime = millis();
+   uint32_t startTime = now();
 
-   while (millis() < currentTime + (time * 1000))
+   while (now() - startTime < time * 1000)
    {
      for(int slice = 0; slice < pictureWidth; slice ++)
      {
-       for(uint8_t LED = NUM_LEDS-1; LED > -1; LED --) // LED number
+       for(uint8_t LED = _numLeds-1; LED > -1; LED --) // LED number
        {
          _leds[LED].setRGB(pattern[slice] [LED] [redVal],
                                 pattern[slice] [LED] [greenVal],
                                 pattern[slice] [LED] [blueVal]);
        }
-       FastLED.show();
-       _taskLedModeSelect.delay(800); // How wide the image is
+       show();
+       _taskLedModeSelect->delay(800); // How wide the image is
      }
-     _taskLedModeSelect.delay(1000); // Gap between images
+     _taskLedModeSelect->delay(1000); // Gap between images
    }
  }
 
  #endif
 
 
- #ifdef RT_BOUNCYBALLS
  // Code by Danny Wilson
  // https://github.com/daterdots/LEDs/blob/master/BouncingBalls2014/BouncingBalls2014.ino
 
@@ -1039,14 +1104,14 @@
  float vImpact[NUM_BALLS] ;                   // As time goes on the impact velocity will change, so make an array to store those values
  float tCycle[NUM_BALLS] ;                    // The time since the last time the ball struck the ground
  int   pos[NUM_BALLS] ;                       // The integer position of the dot on the strip (LED index)
- long  tLast[NUM_BALLS] ;                     // The clock time of the last ground strike
+ uint32_t tLast[NUM_BALLS] ;                 // The clock time of the last ground strike
  float COR[NUM_BALLS] ;                       // Coefficient of Restitution (bounce damping)
  boolean firstRun = true ;                    // ugly way to run init only once :(
 
  void LEDRoutines::bouncyBalls() {
    if( firstRun ) {                             // Only run once
      for (int i = 0 ; i < NUM_BALLS ; i++) {    // Initialize variables
-       tLast[i] = millis();
+       tLast[i] = now();
        h[i] = h0;
        pos[i] = 0;                              // Balls start on the ground
        vImpact[i] = vImpact0;                   // And "pop" up at vImpact0
@@ -1057,7 +1122,7 @@
    }
 
    for (int i = 0 ; i < NUM_BALLS ; i++) {
-     tCycle[i] =  millis() - tLast[i] ;     // Calculate the time since the last time the ball was on the ground
+     tCycle[i] =  now() - tLast[i] ;        // Calculate the time since the last time the ball was on the ground
 
      // A little kinematics equation calculates positon as a function of time, acceleration (gravity) and intial velocity
      h[i] = 0.5 * GRAVITY * pow( tCycle[i]/1000 , 2.0 ) + vImpact[i] * tCycle[i]/1000;
@@ -1065,11 +1130,11 @@
      if ( h[i] < 0 ) {
        h[i] = 0;                            // If the ball crossed the threshold of the "ground," put it back on the ground
        vImpact[i] = COR[i] * vImpact[i] ;   // and recalculate its new upward velocity as it's old velocity * COR
-       tLast[i] = millis();
+       tLast[i] = now();
 
        if ( vImpact[i] < 0.01 ) vImpact[i] = vImpact0;  // If the ball is barely moving, "pop" it back up at vImpact0
      }
-     pos[i] = round( h[i] * (NUM_LEDS - 1) / h0);       // Map "h" to a "pos" integer index position on the LED strip
+     pos[i] = round( h[i] * (_numLeds - 1) / h0);       // Map "h" to a "pos" integer index position on the LED strip
    }
 
    //Choose color of LEDs, then the "pos" LED on
@@ -1077,64 +1142,60 @@
      _leds[pos[i]] = CHSV( uint8_t (i * 40) , 255, 255);
    }
 
-   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness ; // Add 20% brightness
-   FastLED.setBrightness( max(extraBright,255) ) ; // but restrict it to 255
-   FastLED.show();
+   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness ; // Add 20% brightness
+   _brightness = min(extraBright,255) ; // but restrict it to 255
+   show();
    //Then off for the next loop around
    for (int i = 0 ; i < NUM_BALLS ; i++) {
      _leds[pos[i]] = CRGB::Black;
    }
  }
 
- #endif
 
- #ifdef RT_DROPLETS2
    // pos = 0.5 * 9.8 * time
 
  void LEDRoutines::droplets2() {
-   static int pos = 0 ; // start from top
-   static long dropStart = millis() ;
-   static long elapsed ;
+   static uint32_t dropStart = now() ;
 
-   elapsed = millis() - dropStart ;
+   // Back after a long time in other routines: the drop would be far past the
+   // end, so check before the float turns into an LED index
+   uint32_t elapsed = now() - dropStart ;
+   float fallen = round( 0.5 * 1 * elapsed * elapsed / 10000 ) ;
+   uint8_t pos = 0 ; // start from top
 
-   pos = round( 0.5 * 1 * elapsed * elapsed / 10000 ) ;
- //  DEBUG_PRINTLN(pos);
-
-   if( pos >= NUM_LEDS ) {
+   if( fallen >= _numLeds ) {
  //    delay(200);
-     FastLED.show() ;
-     pos = 0 ; // reset to top
-     dropStart = millis() ;
+     show() ;
+     dropStart = now() ;
+   } else {
+     pos = fallen ;
    }
 
    fadeall(120);
 
    _leds[pos] = CRGB::White ;
-   FastLED.show() ;
+   show() ;
  }
 
- #endif
 
 
 
 
  // #ifdef RT_CIRC_LOADER
  // void LEDRoutines::circularLoader() {
- //   uint8_t triwave = triwave8( _taskLedModeSelect.getRunCounter() * 5 ) ;
+ //   uint8_t triwave = triwave8( _taskLedModeSelect->getRunCounter() * 5 ) ;
  //   uint8_t striplength = lerp8by8( 2, 20, triwave ) ;
  //   static uint8_t startP = 50;
  //
- //   fill_solid( leds, NUM_LEDS, CRGB::Black ) ;
+ //   fill_solid( _leds, _numLeds, CRGB::Black ) ;
  //   fillSolidRing( startP - striplength, startP, CHSV(0, 255, 255) ) ; // white
  //
- //   FastLED.setBrightness( currentBrightness ) ;
- //   FastLED.show();
+ //   FastLED.setBrightness( *_currentBrightness ) ;
+ //   show();
  //   startP = startP + lerp8by8( 2, 5, triwave ) ;
  // }
  // #endif
 
- #ifdef RT_CIRC_LOADER
 
 
  // Playing with easing http://crisbeto.github.io/angular-svg-round-progressbar/
@@ -1146,69 +1207,53 @@
  // void LEDRoutines::circularLoader2() {
  //   static int16_t startP = 0 ;
  //   static uint8_t hue = 0 ;
- //   uint8_t cl_length = lerp8by8( 0, 40, beatsin8(  tapTempo.getBPM() ) );
+ //   uint8_t cl_length = lerp8by8( 0, 40, beatsin8(  _tapTempo->getBPM() ) );
  // //  uint8_t cl_length = 20 ;
  //   uint8_t cl_midpoint = cl_length / 2 ;
  //
- //   startP = lerp8by8( 0, NUM_LEDS, beat8(  tapTempo.getBPM() )) ;  // start position
+ //   startP = lerp8by8( 0, _numLeds, beat8(  _tapTempo->getBPM() )) ;  // start position
  //
- //   fill_solid(leds, NUM_LEDS, CRGB::Black);
+ //   fill_solid(_leds, _numLeds, CRGB::Black);
  //
  //   fillGradientRing(startP - cl_midpoint, CHSV(hue, 255, 0), startP, CHSV(hue, 255, 255));
  //   fillGradientRing(startP + 1, CHSV(hue, 255, 255), startP + cl_midpoint, CHSV(hue, 255, 0));
  //
- //   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness ; // Add 50% brightness
+ //   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness ; // Add 50% brightness
  //   #ifdef ESP8266
- //     FastLED.setBrightness( _max(extraBright,255) ) ; // but restrict it to 255
+ //     FastLED.setBrightness( _min(extraBright,255) ) ; // but restrict it to 255
  //   #else
- //     FastLED.setBrightness( max(extraBright,255) ) ; // but restrict it to 255
+ //     FastLED.setBrightness( min(extraBright,255) ) ; // but restrict it to 255
  //   #endif
- //   FastLED.show();
+ //   show();
  //   hue++  ;
  //
  // }
 
- #define CL_LENGTH  10
- void LEDRoutines::circularLoader() {
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
-   uint8_t uneased_startP = lerp8by8( 0, NUM_LEDS, beat8( 30, 5000 ) );  // start position, runs behind endP
-   uint8_t uneased_endP   = lerp8by8( 0, NUM_LEDS, beat8( 30 ) );  // start position
-   uint8_t startP = QuadraticEaseIn8( uneased_startP );
-   uint8_t endP   = CubicEaseIn8( uneased_endP );
-   DEBUG_PRINT(F("startP: ")) ;
-   DEBUG_PRINT(startP) ;
-   DEBUG_PRINT(F("\t")) ;
-   DEBUG_PRINT(F("endP: ")) ;
-   DEBUG_PRINT(endP) ;
-   // DEBUG_PRINT(F("\t")) ;
-   // DEBUG_PRINT(F("eased: ")) ;
-   // DEBUG_PRINT(eased) ;
-   DEBUG_PRINTLN() ;
-
-   fillSolidRing(startP, endP, CHSV(90, 255, 255));
-
-   FastLED.show();
- }
-
- uint8_t QuadraticEaseIn8( uint8_t p ) {
-   int     i_100       = map(p, 0, NUM_LEDS, 0, 100); // Map current led p to percentage between 0 - 100
+ uint8_t QuadraticEaseIn8( uint8_t p, uint8_t numLeds ) {
+   int     i_100       = map(p, 0, numLeds, 0, 100); // Map current led p to percentage between 0 - 100
    AHFloat eased_float = QuadraticEaseInOut( (float)i_100 / (float)100); // Convert to value between 0 - 1
    int     eased_100   = (int)(eased_float * 100); // convert back to percentage
-   return  map(eased_100, 0, 100, 0, NUM_LEDS);  // convert back to LED position
+   return  map(eased_100, 0, 100, 0, numLeds);  // convert back to LED position
  }
 
- uint8_t CubicEaseIn8( uint8_t p ) {
-   int     i_100       = map(p, 0, NUM_LEDS, 0, 100); // Map current led p to percentage between 0 - 100
+ uint8_t CubicEaseIn8( uint8_t p, uint8_t numLeds ) {
+   int     i_100       = map(p, 0, numLeds, 0, 100); // Map current led p to percentage between 0 - 100
    AHFloat eased_float = CubicEaseInOut( (float)i_100 / (float)100); // Convert to value between 0 - 1
    int     eased_100   = (int)(eased_float * 100); // convert back to percentage
-   return  map(eased_100, 0, 100, 0, NUM_LEDS);  // convert back to LED position
+   return  map(eased_100, 0, 100, 0, numLeds);  // convert back to LED position
  }
 
- #endif
-
-
+ #define CL_LENGTH  10
+ void LEDRoutines::circularLoader() {
+   fill_solid(_leds, _numLeds, CRGB::Black);
+   uint8_t uneased_startP = lerp8by8( 0, _numLeds, beat8( 30, 5000 ) );  // start position, runs behind endP
+   uint8_t uneased_endP   = lerp8by8( 0, _numLeds, beat8( 30 ) );  // start position
+   uint8_t startP = QuadraticEaseIn8( uneased_startP, _numLeds );
+   uint8_t endP   = CubicEaseIn8( uneased_endP, _numLeds );
+   fillSolidRing(startP, endP, CHSV(90, 255, 255));
 
- #if defined(RT_FASTLOOP3)
+   show();
+ }
 
  #define SL_LENGHT 20 // how many LEDs should be in the "stripe"
  #define SL_MIDPOINT SL_LENGHT / 2
@@ -1218,29 +1263,27 @@
    static int16_t startP = 0;
    static uint8_t hue = 0;
 
-   fill_solid(leds, NUM_LEDS, CRGB::Black);
+   fill_solid(_leds, _numLeds, CRGB::Black);
    for (int i = 0; i < SL_NUMSTRIPES; i++) {
-     startP = lerp8by8(0, NUM_LEDS, beat8(30 + (i * 15))); // 40, 43, 46
+     startP = lerp8by8(0, _numLeds, beat8(30 + (i * 15))); // 40, 43, 46
      fillGradientRing(startP, CHSV(hue + (i * 30), 255, 0), startP + SL_MIDPOINT,
                       CHSV(hue + (i * 60), 255, 255));
      fillGradientRing(startP + SL_MIDPOINT + 1, CHSV(hue + (i * 60), 255, 255),
                       startP + SL_LENGHT, CHSV(hue + (i * 30), 255, 0));
    }
 
-   uint16_t extraBright = round(currentBrightness * BRIGHTFACTOR) + currentBrightness; // Add 50% brightness
+   uint16_t extraBright = round(*_currentBrightness * BRIGHTFACTOR) + *_currentBrightness; // Add 50% brightness
  #ifdef ESP8266
-   FastLED.setBrightness(_max(extraBright, 255)); // but restrict it to 255
+   _brightness = _min(extraBright, 255) ; // but restrict it to 255
  #else
-   FastLED.setBrightness(max(extraBright, 255)); // but restrict it to 255
+   _brightness = min(extraBright, 255) ; // but restrict it to 255
  #endif
-   FastLED.show();
+   show();
    hue++;
  }
- #endif
 
 
 
- #ifdef RT_RIPPLE
  // Adapted by Andrew Tuline from NeoPixel version
  // https://pastebin.com/LfBsPLRn
  // https://www.youtube.com/watch?v=IrMzopUe8F4
@@ -1249,26 +1292,26 @@
  #define fadeRate 0.8
 
  void LEDRoutines::ripple() {
-   static uint32_t currentBg = random(256);
+   static uint32_t currentBg = random8();
    static uint32_t nextBg = currentBg;
    static int color;
    static int center = 0;
    static int step = -1;
 
    if (currentBg == nextBg) {
-     nextBg = random(256);
+     nextBg = random8();
    } else if (nextBg > currentBg) {
      currentBg++;
    } else {
      currentBg--;
    }
-   for (uint16_t l = 0; l < NUM_LEDS; l++) {
+   for (uint16_t l = 0; l < _numLeds; l++) {
      _leds[l] = CHSV(currentBg, 255, 50); // strip.setPixelColor(l, Wheel(currentBg, 0.1));
    }
 
    if (step == -1) {
-     center = random(NUM_LEDS);
-     color = random(256);
+     center = random16(_numLeds);
+     color = random8();
      step = 0;
    }
 
@@ -1280,23 +1323,23 @@
      if (step < maxSteps) {
  //      Serial.println(pow(fadeRate, step));
 
-       _leds[wrap(center + step)] =
+       _leds[mod(center + step, _numLeds)] =
            CHSV(color, 255,
                 pow(fadeRate, step) *
                     255); //   strip.setPixelColor(wrap(center + step),
                           //   Wheel(color, pow(fadeRate, step)));
-       _leds[wrap(center - step)] =
+       _leds[mod(center - step, _numLeds)] =
            CHSV(color, 255,
                 pow(fadeRate, step) *
                     255); //   strip.setPixelColor(wrap(center - step),
                           //   Wheel(color, pow(fadeRate, step)));
        if (step > 3) {
-         _leds[wrap(center + step - 3)] =
+         _leds[mod(center + step - 3, _numLeds)] =
              CHSV(color, 255,
                   pow(fadeRate, step - 2) *
                       255); //   strip.setPixelColor(wrap(center + step - 3),
                             //   Wheel(color, pow(fadeRate, step - 2)));
-         _leds[wrap(center - step + 3)] =
+         _leds[mod(center - step + 3, _numLeds)] =
              CHSV(color, 255,
                   pow(fadeRate, step - 2) *
                       255); //   strip.setPixelColor(wrap(center - step + 3),
@@ -1307,37 +1350,29 @@
        step = -1;
      }
    }
-   FastLED.setBrightness( currentBrightness );
-   FastLED.show();
- }
-
- int wrap(int step) {
-   if(step < 0) return NUM_LEDS + step;
-   if(step > NUM_LEDS - 1) return step - NUM_LEDS;
-   return step;
+   _brightness = *_currentBrightness ;
+   show();
  }
 
  void LEDRoutines::one_color_allHSV(int ahue, int abright) {                // SET ALL LEDS TO ONE COLOR (HSV)
-   for (int i = 0 ; i < NUM_LEDS; i++ ) {
+   for (int i = 0 ; i < _numLeds; i++ ) {
      _leds[i] = CHSV(ahue, 255, abright);
    }
  }
- #endif
 
 
- #ifdef RT_RANDOMWALK
  // Source: https://www.arduino.cc/reference/en/language/variables/variable-scope--qualifiers/static/
  // Thought it might be interesting
 
  #define randomWalkLowRange  0
- #define randomWalkHighRange NUM_LEDS
+ #define randomWalkHighRange ( _numLeds - 1 )
  #define moveSize 2
 
  void LEDRoutines::randomWalk(){
    static int  place;     // variable to store value in random walk - declared static so that it stores
                           // values in between function calls, but no other functions can change its value
 
-   place = place + (random(-moveSize, moveSize + 1));
+   place = place + random8( 2 * moveSize + 1 ) - moveSize;
 
    if (place < randomWalkLowRange){                              // check lower and upper limits
      place = randomWalkLowRange + (randomWalkLowRange - place);  // reflect number back in positive direction
@@ -1347,8 +1382,7 @@
    }
 
    _leds[place] = CHSV(0, 255, 255); // red
-   FastLED.show();
+   show();
    fadeall(210);
  }
 
- #endif
@@ -5,12 +5,49 @@
 #include <FastLED.h>
 #include <ArduinoTapTempo.h>
 #include <TaskScheduler.h>
+#include <PixelLayout.h>
+#include <FrameQueue.h>
+#include <PowerLimiter.h>
+#include <DitherOutput.h>
+#include <Apa102Hd.h>
+#include <ColorLut.h>
+#include <FrameGovernor.h>
+#include <OscillatorBank.h>
+#include <AudioInput.h>
+#include <PaletteSequencer.h>
 
 
+// FillLEDsFromPaletteColors() index for the palette uploaded over serial
+#define PALETTE_USER 255
+// FillLEDsFromPaletteColors() / fillnoise8() index for the palette sequence (_palettes)
+#define PALETTE_SEQUENCE 254
+
+// How much brighter the strobes and glitter flash than the current brightness
+#ifndef BRIGHTFACTOR
+#define BRIGHTFACTOR 0.2
+#endif
+
+// Time source for the routines, in ms
+typedef uint32_t (*ShowClock)() ;
+
 class LEDRoutines
 {
   public:
     void setLeds(CRGB* leds, uint8_t numLeds, ArduinoTapTempo* tapTempo, Task* taskLedModeSelect, uint8_t* currentBrightness ) ;
+    void setLayout( PixelLayout* layout ) ;
+    void setFrameQueue( FrameQueue* frameQueue ) ;
+    void setPowerLimiter( PowerLimiter* power ) ;
+    void setDitherOutput( DitherOutput* dither ) ;
+    void setApa102Hd( Apa102Hd* hd ) ;
+    void setColorLut( ColorLut* lut ) ;
+    void setFrameGovernor( FrameGovernor* governor ) ;
+    void setAudioInput( AudioInput* audio ) ;
+    void setFlushTask( Task* flush ) ;
+    void setClock( ShowClock clock ) ;
+    uint32_t now() { return _clock() ; }
+    static uint32_t systemClock() ;
+    void beginFrame() ;
+    void show() ;
     void FillLEDsFromPaletteColors(uint8_t paletteIndex ) ;
     void fadeGlitter() ;
     void discoGlitter() ;
@@ -36,6 +73,17 @@ class LEDRoutines
     void threeSinPal() ;
     void colorGlow() ;
     void fanWipe() ;
+    void droplets() ;
+    void bouncyBalls() ;
+    void droplets2() ;
+    void circularLoader() ;
+    void fastLoop3() ;
+    void ripple() ;
+    void randomWalk() ;
+    void vuMeter() ;
+#if defined(RT_POVPATTERNS) && defined(_TASK_MICRO_RES)
+    void povPatterns(unsigned long time, const char pattern[][NUM_LEDS][3], int pictureWidth) ;
+#endif
 
     // Helpers:
     void fillGradientRing( int startLed, CHSV startColor, int endLed, CHSV endColor ) ;
@@ -45,10 +93,11 @@ class LEDRoutines
     void fadeall(uint8_t fade_all_speed) ;
     void brightall(uint8_t bright_all_speed) ;
     void addGlitter( fract8 chanceOfGlitter) ;
-    void checkButtonPress() ;
-    void cycleBrightness() ;
-    void serialEvent() ;
+    void one_color_allHSV(int ahue, int abright) ;
     void setMaxBright( uint8_t maxBright );
+    void setUserPalette( const uint8_t* rgb ) ;
+    void setUserPalette( const CRGBPalette16& palette ) ;
+    void setFade( uint8_t fade ) ;
 
     CRGB* _leds ;
     ArduinoTapTempo* _tapTempo ;
@@ -56,6 +105,23 @@ class LEDRoutines
     uint8_t _numLeds = 0 ;
     Task* _taskLedModeSelect;
     uint8_t* _currentBrightness ;
+    PixelLayout* _layout ;
+    FrameQueue* _frameQueue = NULL ;
+    PowerLimiter* _power = NULL ;
+    DitherOutput* _dither = NULL ;
+    Apa102Hd* _hd = NULL ;
+    ColorLut* _lut = NULL ;
+    FrameGovernor* _governor = NULL ;
+    AudioInput* _audio = NULL ;
+    Task* _flush = NULL ;   // STRIPS_SEGMENTS: show() leaves sending the frame to this task
+    ShowClock _clock = systemClock ;   // millis()
+    OscillatorBank _osc ;
+    PaletteSequencer _palettes ;
+    CRGBPalette16 _userPalette = RainbowColors_p ;
+    uint8_t _fade = 255 ;   // extra output scale for transitions, leaves leds[] alone
+    // Brightness show() sends the frame with. Routines set it instead of FastLED's global
+    // brightness, so with STRIPS_SEGMENTS one segment's heartbeat doesn't dim all the strips.
+    uint8_t _brightness = 255 ;
 
 };
 
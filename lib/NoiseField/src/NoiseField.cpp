@@ -0,0 +1,137 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "NoiseField.h"
+
+// Ken Perlin's permutation table, same as the one FastLED's inoise8() uses.
+// 257 entries so P(n + 1) never needs a wrap.
+static const uint8_t noisePerm[257] PROGMEM = {
+  151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,
+  140,36,103,30,69,142,8,99,37,240,21,10,23,190,6,148,
+  247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,
+  57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,
+  74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,
+  60,211,133,230,220,105,92,41,55,46,245,40,244,102,143,54,
+  65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,
+  200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,
+  52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,
+  207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,
+  119,248,152,2,44,154,163,70,221,153,101,155,167,43,172,9,
+  129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,
+  218,246,97,228,251,34,242,193,238,210,144,12,191,179,162,241,
+  81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,
+  184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,
+  222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180,
+  151
+};
+
+#define P(n) pgm_read_byte( &noisePerm[(n)] )
+
+// grad8() and lerp7by8() are private to FastLED's noise.cpp; these are the
+// same operations so our output matches inoise8() bit for bit.
+static inline int8_t grad8( uint8_t hash, int8_t x, int8_t y, int8_t z ) {
+  hash = hash & 0xF ;
+  int8_t u = ( hash & 8 ) ? y : x ;
+  int8_t v = hash < 4 ? y : ( hash == 12 || hash == 14 ) ? x : z ;
+  if ( hash & 1 ) u = -u ;
+  if ( hash & 2 ) v = -v ;
+  return avg7( u, v ) ;
+}
+
+static inline int8_t lerp7by8( int8_t a, int8_t b, fract8 frac ) {
+  if ( b > a ) {
+    uint8_t delta = b - a ;
+    return a + scale8( delta, frac ) ;
+  } else {
+    uint8_t delta = a - b ;
+    return a - scale8( delta, frac ) ;
+  }
+}
+
+
+void NoiseField::setOctaves( uint8_t octaves ) {
+  _octaves = constrain( octaves, 1, 8 ) ;
+}
+
+uint8_t NoiseField::getOctaves() {
+  return _octaves ;
+}
+
+
+void NoiseField::fillStrip( uint8_t* out, uint8_t numLeds, uint16_t x, uint16_t scale, uint16_t y, uint16_t z ) {
+  // Each octave doubles the spatial frequency and adds at half the weight,
+  // the same way FastLED's fill_raw_noise8() stacks octaves.
+  for ( uint8_t o = 0 ; o < _octaves ; o++ ) {
+    addOctave( out, numLeds, x << o, scale << o, y << o, z, o ) ;
+  }
+}
+
+
+void NoiseField::fillField( uint8_t* out, uint8_t width, uint8_t height, uint16_t x, uint16_t scaleX, uint16_t y, uint16_t scaleY, uint16_t z ) {
+  for ( uint8_t row = 0 ; row < height ; row++ ) {
+    fillStrip( out + row * width, width, x, scaleX, y, z ) ;
+    y += scaleY ;
+  }
+}
+
+
+void NoiseField::addOctave( uint8_t* out, uint8_t numLeds, uint16_t x, uint16_t scale, uint16_t y, uint16_t z, uint8_t octave ) {
+  const uint8_t N = 0x80 ;
+
+  // Constant along the strip
+  uint8_t Y = y >> 8 ;
+  uint8_t Z = z >> 8 ;
+  uint8_t v = ease8InOutQuad( (uint8_t) y ) ;
+  uint8_t w = ease8InOutQuad( (uint8_t) z ) ;
+  int8_t yy = ( (uint8_t) y >> 1 ) & 0x7F ;
+  int8_t zz = ( (uint8_t) z >> 1 ) & 0x7F ;
+
+  // Hashed gradients of the 8 cube corners, refreshed when x changes cell
+  uint8_t h[8] ;
+  uint16_t cell = 0x100 ; // not a valid cell, forces the first lookup
+
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    uint8_t X = x >> 8 ;
+
+    if ( X != cell ) {
+      cell = X ;
+      uint8_t A  = P(X) + Y ;
+      uint8_t AA = P(A) + Z ;
+      uint8_t AB = P(A + 1) + Z ;
+      uint8_t B  = P(X + 1) + Y ;
+      uint8_t BA = P(B) + Z ;
+      uint8_t BB = P(B + 1) + Z ;
+      h[0] = P(AA) ;
+      h[1] = P(BA) ;
+      h[2] = P(AB) ;
+      h[3] = P(BB) ;
+      h[4] = P(AA + 1) ;
+      h[5] = P(BA + 1) ;
+      h[6] = P(AB + 1) ;
+      h[7] = P(BB + 1) ;
+    }
+
+    uint8_t u = ease8InOutQuad( (uint8_t) x ) ;
+    int8_t xx = ( (uint8_t) x >> 1 ) & 0x7F ;
+
+    int8_t X1 = lerp7by8( grad8( h[0], xx, yy, zz ),         grad8( h[1], xx - N, yy, zz ), u ) ;
+    int8_t X2 = lerp7by8( grad8( h[2], xx, yy - N, zz ),     grad8( h[3], xx - N, yy - N, zz ), u ) ;
+    int8_t X3 = lerp7by8( grad8( h[4], xx, yy, zz - N ),     grad8( h[5], xx - N, yy, zz - N ), u ) ;
+    int8_t X4 = lerp7by8( grad8( h[6], xx, yy - N, zz - N ), grad8( h[7], xx - N, yy - N, zz - N ), u ) ;
+
+    int8_t Y1 = lerp7by8( X1, X2, v ) ;
+    int8_t Y2 = lerp7by8( X3, X4, v ) ;
+
+    // -64..64 raw, expanded to 0..255 like inoise8()
+    int8_t n = lerp7by8( Y1, Y2, w ) ;
+    n += 64 ;
+    uint8_t data = qadd8( n, n ) ;
+
+    if ( octave == 0 ) {
+      out[i] = data ;
+    } else {
+      out[i] = qadd8( out[i], data >> octave ) ;
+    }
+
+    x += scale ;
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef NoiseField_H
+#define NoiseField_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+// Default number of noise octaves. Every extra octave costs one more pass
+// over the strip; override in the board header for more detail.
+#ifndef NOISE_OCTAVES
+#define NOISE_OCTAVES 1
+#endif
+
+// 3D noise evaluated along a strip (or a grid of strips, e.g. fan blades).
+//
+// With one octave the output is identical to calling inoise8(x + scale*i, y, z)
+// for every LED, but instead of hashing the lattice cube for each pixel the
+// corner hashes are cached and only refreshed when x steps into the next
+// lattice cell. y and z are constant along a strip, so their easing and
+// gradient inputs are computed once per strip too.
+class NoiseField
+{
+  public:
+    void setOctaves( uint8_t octaves ) ;
+    uint8_t getOctaves() ;
+
+    // One row: out[i] = noise(x + scale * i, y, z)
+    void fillStrip( uint8_t* out, uint8_t numLeds, uint16_t x, uint16_t scale, uint16_t y, uint16_t z ) ;
+
+    // width x height grid stored row after row (blade after blade on a fan):
+    // out[row * width + i] = noise(x + scaleX * i, y + scaleY * row, z)
+    void fillField( uint8_t* out, uint8_t width, uint8_t height, uint16_t x, uint16_t scaleX, uint16_t y, uint16_t scaleY, uint16_t z ) ;
+
+  private:
+    void addOctave( uint8_t* out, uint8_t numLeds, uint16_t x, uint16_t scale, uint16_t y, uint16_t z, uint8_t octave ) ;
+
+    uint8_t _octaves = NOISE_OCTAVES ;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "OscillatorBank.h"
+
+void OscillatorBank::set( uint8_t i, uint8_t num, uint8_t den, uint8_t wave, uint16_t phase ) {
+  if ( i >= OSCILLATOR_BANK_SIZE ) return ;
+  Oscillator& o = _osc[i] ;
+  if ( i >= _count ) {   // new slot: start where asked
+    _count = i + 1 ;
+    o.phase = (uint32_t) phase << 16 ;
+  } else if ( o.start != phase ) {   // same slot, new offset: move by the difference only
+    o.phase += (uint32_t) (uint16_t) ( phase - o.start ) << 16 ;
+  }
+  if ( den == 0 ) den = 1 ;
+  // Routines set() their slots every frame: only a new rate costs the divide
+  if ( o.num != num || o.den != den ) {
+    o.num = num ;
+    o.den = den ;
+    setRate( o ) ;
+  }
+  o.start = phase ;
+  o.wave = wave ;
+  o.value = shape( wave, o.phase >> 16 ) ;
+}
+
+
+// The 64-bit divide (__aeabi_uldivmod on the M0+), only when a slot gets a new
+// num / den or the tempo changes, not per set() or per slot per frame.
+// A beat is 2^32; beat88() uses the same 280 for 2^32 / 60000 / 256.
+void OscillatorBank::setRate( Oscillator& o ) {
+  o.rate = (uint32_t) ( (uint64_t) _bpm88 * 280 * o.num / o.den ) ;
+}
+
+
+void OscillatorBank::advance( uint32_t nowMs, uint32_t bpm88 ) {
+  uint32_t dt = nowMs - _last ;
+  _last = nowMs ;
+
+  bool newTempo = bpm88 != _bpm88 ;
+  _bpm88 = bpm88 ;
+  for ( uint8_t i = 0 ; i < _count ; i++ ) {
+    Oscillator& o = _osc[i] ;
+    if ( ! o.den ) continue ;   // slot below one that was set, never set itself
+    o.phase += dt * o.rate ;    // wraps with the phase, a whole number of beats
+    if ( newTempo ) setRate( o ) ;
+    o.value = shape( o.wave, o.phase >> 16 ) ;
+  }
+}
+
+
+void OscillatorBank::reset( uint32_t nowMs ) {
+  _last = nowMs ;
+  for ( uint8_t i = 0 ; i < _count ; i++ ) {
+    _osc[i].phase = (uint32_t) _osc[i].start << 16 ;
+    _osc[i].value = shape( _osc[i].wave, _osc[i].start ) ;
+  }
+}
+
+
+uint16_t OscillatorBank::shape( uint8_t wave, uint16_t phase ) {
+  uint16_t tri = phase < 32768 ? phase * 2 : ( 65535 - phase ) * 2 ;
+  switch ( wave ) {
+    case WAVE_TRIANGLE: return tri ;
+    case WAVE_SAW:      return phase ;
+    case WAVE_SQUARE:   return phase < 32768 ? 65535 : 0 ;
+    case WAVE_EASED:    return ease16InOutQuad( tri ) ;   // triangle that slows at the ends
+    default:            return sin16( phase ) + 32768 ;
+  }
+}
@@ -0,0 +1,75 @@
+#ifndef OscillatorBank_H
+#define OscillatorBank_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Beat-synced waves for the routines, instead of calling beatsin8() and
+   friends several times a frame.
+
+   beat8() / beatsin8() work out the phase from millis() and the BPM on
+   every call. Two calls in one frame can see different times, and when the
+   tempo is tapped the phase of every wave jumps, each by a different amount,
+   so waves that were in step (pendulum's two dots, jugglePal's dots) drift
+   apart.
+
+   Here each oscillator is a phase accumulator. advance() runs once before
+   a frame is drawn: it takes the time once, moves every oscillator on by
+   that much at its own rate (the tap tempo times num / den) and works out
+   its output. A new tempo only changes how fast the phases move from then
+   on, so nothing jumps. The routine then reads the outputs, as often as it
+   likes.
+
+   Routines say what they want from a slot with set(), every frame or once.
+   Changing the rate or the wave of a slot keeps its phase. Only one routine
+   draws with an LEDRoutines at a time, so they all share slots from 0.
+*/
+
+#ifndef OSCILLATOR_BANK_SIZE
+#define OSCILLATOR_BANK_SIZE 8
+#endif
+
+enum Waveform { WAVE_SINE, WAVE_TRIANGLE, WAVE_SAW, WAVE_SQUARE, WAVE_EASED } ;
+
+class OscillatorBank
+{
+  public:
+    // Slot 'i' runs at num / den times the tempo, starting 'phase' (out of 65536) into the beat
+    void set( uint8_t i, uint8_t num, uint8_t den, uint8_t wave, uint16_t phase = 0 ) ;
+
+    // Once per frame: move every oscillator on to 'nowMs' at 'bpm88' (Q8.8, as
+    // beat88(), but wide enough for 256 BPM and up)
+    void advance( uint32_t nowMs, uint32_t bpm88 ) ;
+
+    // All phases back to where set() put them, with the clock at 'nowMs'
+    void reset( uint32_t nowMs ) ;
+
+    uint16_t value16( uint8_t i ) { return _osc[i].value ; }
+    uint8_t value8( uint8_t i ) { return _osc[i].value >> 8 ; }
+    // The output spread over lo - hi, as beatsin8( bpm, lo, hi )
+    uint8_t range8( uint8_t i, uint8_t lo, uint8_t hi ) { return lo + scale8( value8( i ), hi - lo ) ; }
+    uint16_t range16( uint8_t i, uint16_t lo, uint16_t hi ) { return lo + scale16( value16( i ), hi - lo ) ; }
+
+  private:
+    struct Oscillator
+    {
+      uint32_t phase ;    // a whole beat is 2^32
+      uint32_t rate ;     // phase per ms at _bpm88
+      uint16_t start ;    // phase set() asked for, for reset()
+      uint16_t value ;
+      uint8_t num ;
+      uint8_t den ;
+      uint8_t wave ;
+    };
+
+    static uint16_t shape( uint8_t wave, uint16_t phase ) ;
+    void setRate( Oscillator& o ) ;
+
+    Oscillator _osc[OSCILLATOR_BANK_SIZE] ;
+    uint8_t _count = 0 ;    // slots set so far
+    uint32_t _last = 0 ;
+    uint32_t _bpm88 = 0 ;   // tempo the rates were worked out for
+};
+
+#endif
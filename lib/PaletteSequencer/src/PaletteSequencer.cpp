@@ -0,0 +1,48 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "PaletteSequencer.h"
+
+void PaletteSequencer::begin( const PaletteStep* steps, uint8_t count, uint32_t nowMs ) {
+  _steps = steps ;
+  _count = count ;
+  if ( ! count ) return ;
+  _current = CRGBPalette16( *steps[0].palette ) ;   // first one straight in, no fade from black
+  start( 0, nowMs ) ;
+  _blending = false ;
+}
+
+
+void PaletteSequencer::start( uint8_t step, uint32_t nowMs ) {
+  _step = step ;
+  _stepStart = nowMs ;
+  _from = _current ;
+  _blending = true ;
+  _settled = 0 ;
+}
+
+
+void PaletteSequencer::update( uint32_t nowMs ) {
+  if ( ! _count ) return ;
+
+  uint32_t elapsed = nowMs - _stepStart ;
+  const PaletteStep& step = _steps[_step] ;
+  if ( elapsed >= step.durationMs ) {
+    start( ( _step + 1 ) % _count, nowMs ) ;
+    return ;
+  }
+  if ( ! _blending ) return ;
+
+  fract8 amount = elapsed >= step.blendMs ? 255 : ( elapsed * 255 ) / step.blendMs ;
+  for ( uint8_t n = 0 ; n < PALETTE_SEQ_ENTRIES_PER_UPDATE ; n++ ) {
+    uint8_t i = _nextEntry ;
+    CRGB to( pgm_read_dword( &( *step.palette )[i] ) ) ;
+    _current[i] = amount == 255 ? to : blend( _from[i], to, amount ) ;
+    _nextEntry = ( i + 1 ) & 15 ;
+    // Done once every entry has been set with the fade complete
+    _settled = amount == 255 ? _settled + 1 : 0 ;
+    if ( _settled == 16 ) {
+      _blending = false ;
+      return ;
+    }
+  }
+}
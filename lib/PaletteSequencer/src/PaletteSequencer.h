@@ -0,0 +1,60 @@
+#ifndef PaletteSequencer_H
+#define PaletteSequencer_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   A list of palettes that follow each other, each crossfading in from the
+   one before, for any routine that draws from a palette (tsp, p_seq,
+   noise_seq): they all read palette() and get the same slow evolution.
+
+   A step is a palette in flash, how long the step lasts, and how much of
+   that is spent blending into it from wherever the previous step left off.
+   After the last step the list starts again.
+
+   update() runs once per frame. While blending it works out each entry as
+   a blend of the old palette and the new one at the current point of the
+   fade, but only PALETTE_SEQ_ENTRIES_PER_UPDATE of the 16 entries per call,
+   taking turns. The fade lags a few frames behind at most, and a frame
+   never pays for all 16. While holding it only checks the time.
+*/
+
+#ifndef PALETTE_SEQ_ENTRIES_PER_UPDATE
+#define PALETTE_SEQ_ENTRIES_PER_UPDATE 4
+#endif
+
+struct PaletteStep
+{
+  const TProgmemRGBPalette16* palette ;
+  uint16_t durationMs ;     // on this step, blend included
+  uint16_t blendMs ;        // fading in from the previous one
+};
+
+class PaletteSequencer
+{
+  public:
+    void begin( const PaletteStep* steps, uint8_t count, uint32_t nowMs ) ;
+    // Back to the first step
+    void restart( uint32_t nowMs ) { begin( _steps, _count, nowMs ) ; }
+
+    // Once per frame
+    void update( uint32_t nowMs ) ;
+
+    const CRGBPalette16& palette() { return _current ; }
+
+  private:
+    void start( uint8_t step, uint32_t nowMs ) ;
+
+    const PaletteStep* _steps = NULL ;
+    uint8_t _count = 0 ;
+    uint8_t _step = 0 ;
+    uint32_t _stepStart = 0 ;
+    bool _blending = false ;
+    uint8_t _nextEntry = 0 ;      // where the next update() carries on blending
+    uint8_t _settled = 0 ;        // entries set since the fade reached the new palette
+    CRGBPalette16 _from ;         // what was showing when the step started
+    CRGBPalette16 _current ;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "ParticlePool.h"
+
+bool ParticleBase::emit( uint16_t pos, int16_t vel, const CRGB& color, uint8_t life ) {
+  if ( _count >= _capacity ) return false ;
+  _pos[_count] = pos ;
+  _vel[_count] = vel ;
+  _color[_count] = color ;
+  _life[_count] = life ;
+  _count++ ;
+  return true ;
+}
+
+
+void ParticleBase::kill( uint16_t i ) {
+  _count-- ;
+  _pos[i] = _pos[_count] ;
+  _vel[i] = _vel[_count] ;
+  _color[i] = _color[_count] ;
+  _life[i] = _life[_count] ;
+}
+
+
+void ParticleBase::update( uint8_t numLeds ) {
+  int32_t end = (int32_t) numLeds << 8 ;   // just past the last LED
+  int32_t last = end - 256 ;               // on the last LED
+
+  for ( uint16_t i = 0 ; i < _count ; ) {
+    if ( _life[i] != PARTICLE_FOREVER && --_life[i] == 0 ) {
+      kill( i ) ;   // the last one is in slot i now, so don't move on
+      continue ;
+    }
+
+    int32_t p = (int32_t) _pos[i] + _vel[i] ;
+    if ( _edge == PARTICLE_WRAP ) {
+      if ( p < 0 ) p += end ;
+      else if ( p >= end ) p -= end ;
+    } else if ( p < 0 || p > last ) {
+      if ( _edge == PARTICLE_DIE ) {
+        kill( i ) ;
+        continue ;
+      }
+      p = p < 0 ? -p : 2 * last - p ;   // bounce
+      _vel[i] = -_vel[i] ;
+    }
+    _pos[i] = p ;
+    i++ ;
+  }
+}
+
+
+void ParticleBase::render( CRGB* leds, uint8_t numLeds ) {
+  for ( uint16_t i = 0 ; i < _count ; i++ ) {
+    uint8_t led = _pos[i] >> 8 ;
+    uint8_t frac = _pos[i] ;
+    if ( led >= numLeds ) continue ;   // strip got shorter
+
+    CRGB c = _color[i] ;
+    leds[led] += c.nscale8( 255 - frac ) ;
+    if ( frac ) {
+      uint8_t next = led + 1 < numLeds ? led + 1 : 0 ;
+      if ( next || _edge == PARTICLE_WRAP ) {
+        c = _color[i] ;
+        leds[next] += c.nscale8( frac ) ;
+      }
+    }
+  }
+}
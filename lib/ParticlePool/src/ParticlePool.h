@@ -0,0 +1,81 @@
+#ifndef ParticlePool_H
+#define ParticlePool_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Dots that move along the strip (racers, droplets), kept in one place
+   instead of every routine having its own position and speed arrays and
+   stepping them every so many frames.
+
+   A pool holds up to N particles, one array per field: position and
+   velocity in 1/256ths of an LED, colour, and life in frames. The live ones
+   are kept at the front, so update() and render() only ever touch those;
+   a particle that dies is replaced by the last live one. That means a
+   particle's index can change when one before it dies, so routines that
+   need to tell particles apart (by index) use PARTICLE_FOREVER and an edge
+   that doesn't kill.
+
+   - emit() adds a particle, if there is room
+   - update() moves every live particle on by its velocity, once per frame,
+     and handles the ends of the strip: wrap round (rings), bounce, or die
+   - render() adds every live particle into leds[], split between the two
+     LEDs it is between, so slow particles glide instead of jumping
+
+   The arrays live in ParticlePool<N>; the code is shared by every size.
+*/
+
+enum ParticleEdge { PARTICLE_WRAP, PARTICLE_BOUNCE, PARTICLE_DIE } ;
+
+#define PARTICLE_FOREVER 255    // life that doesn't count down
+
+class ParticleBase
+{
+  public:
+    // 'pos' in LEDs * 256, 'vel' added to it every update(); false if the pool is full
+    bool emit( uint16_t pos, int16_t vel, const CRGB& color, uint8_t life = PARTICLE_FOREVER ) ;
+
+    // One frame on, on a strip of 'numLeds'
+    void update( uint8_t numLeds ) ;
+    void render( CRGB* leds, uint8_t numLeds ) ;
+
+    void kill( uint16_t i ) ;
+    void clear() { _count = 0 ; }
+    uint16_t count() { return _count ; }
+
+    // Live particles are 0 - count()-1
+    uint16_t& pos( uint16_t i ) { return _pos[i] ; }
+    int16_t& vel( uint16_t i ) { return _vel[i] ; }
+    CRGB& color( uint16_t i ) { return _color[i] ; }
+    uint8_t& life( uint16_t i ) { return _life[i] ; }
+
+  protected:
+    ParticleBase( uint16_t* pos, int16_t* vel, CRGB* color, uint8_t* life, uint16_t capacity, uint8_t edge )
+      : _pos( pos ), _vel( vel ), _color( color ), _life( life ), _capacity( capacity ), _edge( edge ) {}
+
+  private:
+    uint16_t* _pos ;
+    int16_t* _vel ;
+    CRGB* _color ;
+    uint8_t* _life ;
+    uint16_t _capacity ;
+    uint16_t _count = 0 ;
+    uint8_t _edge ;       // ParticleEdge
+};
+
+template<uint16_t N>
+class ParticlePool : public ParticleBase
+{
+  public:
+    ParticlePool( uint8_t edge = PARTICLE_WRAP )
+      : ParticleBase( _posQ8, _velQ8, _colors, _lives, N, edge ) {}
+
+  private:
+    uint16_t _posQ8[N] ;
+    int16_t _velQ8[N] ;
+    CRGB _colors[N] ;
+    uint8_t _lives[N] ;
+};
+
+#endif
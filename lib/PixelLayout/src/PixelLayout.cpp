@@ -0,0 +1,135 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <math.h>
+#include "PixelLayout.h"
+
+void PixelLayout::begin( uint8_t numLeds ) {
+  _numLeds = numLeds ;
+  _bladeLength = numLeds ;
+  _numBlades = 1 ;
+#if defined(LAYOUT_FAN)
+  _bladeLength = LEDS_PER_BLADE ;
+  _numBlades = min( NUM_BLADES, numLeds / LEDS_PER_BLADE ) ;
+#elif defined(LAYOUT_STAFF) && defined(STAFF_FOLDED)
+  _numBlades = 2 ;
+  _bladeLength = numLeds / 2 ;
+#endif
+
+#ifdef LAYOUT_TABLES
+  fillTables() ;
+#endif
+}
+
+
+#ifdef LAYOUT_TABLES
+void PixelLayout::fillTables() {
+  uint8_t numLeds = _numLeds ;
+
+#if defined(LAYOUT_RING)
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    setPolar( i, ( (uint16_t) i * 256 ) / numLeds, 255 ) ;
+  }
+
+#elif defined(LAYOUT_FAN)
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    uint8_t blade = i / _bladeLength ;
+    uint8_t pos = i % _bladeLength ;
+ #ifdef FAN_ZIGZAG
+    if ( blade & 1 ) pos = _bladeLength - 1 - pos ;
+ #endif
+    if ( blade >= _numBlades ) {
+      setPolar( i, 0, 255 ) ; // spare LEDs after the last blade
+    } else {
+      setPolar( i, ( (uint16_t) blade * 256 ) / _numBlades, _bladeLength > 1 ? ( (uint16_t) pos * 255 ) / ( _bladeLength - 1 ) : 0 ) ;
+    }
+  }
+
+#elif defined(LAYOUT_STAFF)
+  // The staff spins around its middle: one half points at angle 0, the other at 128
+  uint8_t centre = ( _bladeLength - 1 ) / 2 ;
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    uint8_t side = i >= _bladeLength ? 1 : 0 ;
+    uint8_t pos = side ? numLeds - 1 - i : i ;
+    int16_t d = pos - centre ;
+    _angle[i] = d < 0 ? 128 : 0 ;
+    _radius[i] = centre ? min( 255, ( abs(d) * 255 ) / centre ) : 0 ;
+ #ifndef LAYOUT_POLAR_ONLY
+    _x[i] = _bladeLength > 1 ? ( (uint16_t) pos * 255 ) / ( _bladeLength - 1 ) : 0 ;
+    _y[i] = _numBlades == 1 ? 128 : side * 255 ;
+ #endif
+  }
+
+#elif defined(LAYOUT_XY)
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    int16_t dx = (int16_t) LayoutXY[i][0] - 128 ;
+    int16_t dy = (int16_t) LayoutXY[i][1] - 128 ;
+    // Only runs at setup, so float trig is fine here
+    _angle[i] = (uint8_t) (int16_t) lround( atan2f( dy, dx ) * 128.0 / M_PI ) ;
+    _radius[i] = min( 255, (int) lround( sqrtf( dx * dx + dy * dy ) * 2 ) ) ;
+ #ifndef LAYOUT_POLAR_ONLY
+    _x[i] = dx + 128 ;
+    _y[i] = dy + 128 ;
+ #endif
+  }
+
+#else // LAYOUT_STRIP
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    _angle[i] = 0 ;
+    _radius[i] = numLeds > 1 ? ( (uint16_t) i * 255 ) / ( numLeds - 1 ) : 0 ;
+ #ifndef LAYOUT_POLAR_ONLY
+    _x[i] = _radius[i] ;
+    _y[i] = 128 ;
+ #endif
+  }
+#endif
+}
+
+
+void PixelLayout::setPolar( uint8_t led, uint8_t angle, uint8_t radius ) {
+  _angle[led] = angle ;
+  _radius[led] = radius ;
+#ifndef LAYOUT_POLAR_ONLY
+  // cos8/sin8 are 0-255 around 128; scale the swing by the radius
+  _x[led] = 128 + ( ( (int16_t) cos8( angle ) - 128 ) * radius ) / 256 ;
+  _y[led] = 128 + ( ( (int16_t) sin8( angle ) - 128 ) * radius ) / 256 ;
+#endif
+}
+#endif
+
+
+uint8_t PixelLayout::wrap( int led ) {
+  int r = led % _numLeds ;
+  return r < 0 ? r + _numLeds : r ;
+}
+
+
+uint8_t PixelLayout::ledAt( uint8_t blade, uint8_t pos ) {
+  pos = pos % _bladeLength ;
+#if defined(LAYOUT_FAN)
+ #ifdef FAN_ZIGZAG
+  if ( blade & 1 ) pos = _bladeLength - 1 - pos ;
+ #endif
+  return ( blade % _numBlades ) * _bladeLength + pos ;
+#elif defined(LAYOUT_STAFF) && defined(STAFF_FOLDED)
+  return ( blade & 1 ) ? _numLeds - 1 - pos : pos ;
+#else
+  (void) blade ;   // one blade
+  return pos ;
+#endif
+}
+
+
+#ifdef LAYOUT_TABLES
+uint8_t PixelLayout::nearestToAngle( uint8_t angle ) {
+  uint8_t best = 0 ;
+  uint8_t bestDiff = 255 ;
+  for ( uint8_t i = 0 ; i < _numLeds ; i++ ) {
+    uint8_t diff = abs( (int8_t) ( _angle[i] - angle ) ) ;
+    if ( diff < bestDiff ) {
+      bestDiff = diff ;
+      best = i ;
+    }
+  }
+  return best ;
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef PixelLayout_H
+#define PixelLayout_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Physical geometry of the LEDs, declared once in the board header:
+
+     #define LAYOUT_STRIP      plain strip (default)
+     #define LAYOUT_RING       hoops and rings, LED 0 at angle 0
+     #define LAYOUT_FAN        NUM_BLADES blades of LEDS_PER_BLADE, LED 0 of each blade at the hub
+                               (FAN_ZIGZAG if every other blade is wired outside-in)
+     #define LAYOUT_STAFF      strip that spins around its middle
+                               (STAFF_FOLDED if the second half runs back down the other side)
+     #define LAYOUT_XY         arbitrary positions, from a table in the header:
+                               const unsigned char LayoutXY[NUM_LEDS][2] = { {x, y}, ... } ;  (0-255)
+
+   Blades, wrap() and ledAt() cost no RAM. With LAYOUT_TABLES, begin() also
+   fills per-LED angle/radius/x/y tables once at setup, so effects can work in
+   polar or cartesian space with a table lookup instead of trig per frame.
+   All values are 0-255; the centre of the prop is x = y = 128. LAYOUT_XY
+   needs LAYOUT_TABLES, as its positions are only there to fill them.
+
+   RAM: 4 bytes per LED with LAYOUT_TABLES, or 2 with LAYOUT_POLAR_ONLY as
+   well (x/y then aren't available). Define it in the board header of a board
+   whose routines use them; none do yet.
+*/
+
+#if defined(LAYOUT_XY) && ! defined(LAYOUT_TABLES)
+#error "Error: LAYOUT_XY only fills the LAYOUT_TABLES; define that too"
+#endif
+
+#if defined(LAYOUT_FAN) && ! defined(LEDS_PER_BLADE)
+#define LEDS_PER_BLADE (NUM_LEDS / NUM_BLADES)
+#endif
+
+class PixelLayout
+{
+  public:
+    void begin( uint8_t numLeds ) ;
+
+#ifdef LAYOUT_TABLES
+    uint8_t angle( uint8_t led ) { return _angle[led] ; }
+    uint8_t radius( uint8_t led ) { return _radius[led] ; }
+ #ifndef LAYOUT_POLAR_ONLY
+    uint8_t x( uint8_t led ) { return _x[led] ; }
+    uint8_t y( uint8_t led ) { return _y[led] ; }
+ #endif
+#endif
+
+    // Wraps any index (negative or past the end) back onto the strip: ring math
+    uint8_t wrap( int led ) ;
+
+    // LED at position 'pos' (0 = hub/bottom) on blade or side 'blade'
+    uint8_t ledAt( uint8_t blade, uint8_t pos ) ;
+    uint8_t numBlades() { return _numBlades ; }
+    uint8_t bladeLength() { return _bladeLength ; }
+
+#ifdef LAYOUT_TABLES
+    // LED whose angle is closest to 'angle', e.g. the lowest point for a gravity vector
+    uint8_t nearestToAngle( uint8_t angle ) ;
+#endif
+
+  private:
+    uint8_t _numLeds = 0 ;
+    uint8_t _numBlades = 1 ;
+    uint8_t _bladeLength = 0 ;
+#ifdef LAYOUT_TABLES
+    void fillTables() ;
+    void setPolar( uint8_t led, uint8_t angle, uint8_t radius ) ;
+
+    uint8_t _angle[NUM_LEDS] ;
+    uint8_t _radius[NUM_LEDS] ;
+ #ifndef LAYOUT_POLAR_ONLY
+    uint8_t _x[NUM_LEDS] ;
+    uint8_t _y[NUM_LEDS] ;
+ #endif
+#endif
+};
+
+#endif
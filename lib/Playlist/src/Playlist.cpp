@@ -0,0 +1,99 @@
+#include <Arduino.h>
+#include <SerialCommand.h>
+#include "Playlist.h"
+
+#ifdef PLAYLIST_EEPROM
+#include <EEPROM.h>
+#endif
+
+bool Playlist::beginFlash( const uint8_t* data, uint16_t catalog ) {
+  _flash = data ;
+  _fromEeprom = false ;
+  return check( catalog ) ;
+}
+
+
+#ifdef PLAYLIST_EEPROM
+bool Playlist::beginEeprom( uint16_t catalog ) {
+ #ifdef ESP8266
+  // The ESP emulates EEPROM in a flash sector and needs to know how much of it we use
+  static bool started = false ;
+  if ( ! started ) {
+    EEPROM.begin( PLAYLIST_EEPROM_ADDR + PLAYLIST_EEPROM_SIZE ) ;
+    started = true ;
+  }
+ #endif
+  _fromEeprom = true ;
+  return check( catalog ) ;
+}
+
+
+bool Playlist::writeEeprom( uint16_t offset, const uint8_t* data, uint16_t len ) {
+  if ( (uint32_t) offset + len > PLAYLIST_EEPROM_SIZE ) return false ;
+
+  for ( uint16_t i = 0 ; i < len ; i++ ) {
+    // Only write what changed; EEPROM cells wear out
+    if ( EEPROM.read( PLAYLIST_EEPROM_ADDR + offset + i ) != data[i] ) {
+      EEPROM.write( PLAYLIST_EEPROM_ADDR + offset + i, data[i] ) ;
+    }
+  }
+ #ifdef ESP8266
+  EEPROM.commit() ;
+ #endif
+  return true ;
+}
+#endif
+
+
+uint8_t Playlist::readByte( uint16_t offset ) {
+#ifdef PLAYLIST_EEPROM
+  if ( _fromEeprom ) return EEPROM.read( PLAYLIST_EEPROM_ADDR + offset ) ;
+#endif
+  return pgm_read_byte( _flash + offset ) ;
+}
+
+
+bool Playlist::check( uint16_t catalog ) {
+  _count = 0 ;
+  _pos = 0 ;
+
+  if ( ! _fromEeprom && ! _flash ) return false ;
+  if ( readByte(0) != 'P' || readByte(1) != 'L' || readByte(2) != PLAYLIST_VERSION ) return false ;
+  if ( ( readByte(6) | ( readByte(7) << 8 ) ) != catalog ) return false ;
+
+  uint8_t count = readByte(3) ;
+  uint16_t size = count * PLAYLIST_ENTRY_SIZE ;
+#ifdef PLAYLIST_EEPROM
+  if ( _fromEeprom && PLAYLIST_HEADER_SIZE + size > PLAYLIST_EEPROM_SIZE ) return false ;
+#endif
+
+  uint16_t crc = 0xFFFF ;
+  for ( uint16_t i = 0 ; i < size ; i++ ) {
+    crc = SerialCommand::crc16( crc, readByte( PLAYLIST_HEADER_SIZE + i ) ) ;
+  }
+  if ( crc != ( readByte(4) | ( readByte(5) << 8 ) ) ) return false ;
+
+  _count = count ;
+  return _count > 0 ;
+}
+
+
+bool Playlist::read( uint8_t index, PlaylistEntry& entry ) {
+  if ( index >= _count ) return false ;
+
+  uint16_t at = PLAYLIST_HEADER_SIZE + index * PLAYLIST_ENTRY_SIZE ;
+  entry.routine = readByte( at ) ;
+  entry.duration = readByte( at + 1 ) | ( readByte( at + 2 ) << 8 ) ;
+  entry.bpm = readByte( at + 3 ) | ( readByte( at + 4 ) << 8 ) ;
+  entry.palette = readByte( at + 5 ) ;
+  entry.brightness = readByte( at + 6 ) ;
+  entry.transition = readByte( at + 7 ) ;
+  return true ;
+}
+
+
+bool Playlist::next( PlaylistEntry& entry ) {
+  if ( ! read( _pos, entry ) ) return false ;
+  _pos = ( _pos + 1 ) % _count ;
+  return true ;
+}
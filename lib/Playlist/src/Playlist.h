@@ -0,0 +1,95 @@
+#ifndef Playlist_H
+#define Playlist_H
+
+#include <Arduino.h>
+
+/*
+   Binary playlist, read in place from flash (PROGMEM) or EEPROM: only the
+   entry being played is ever copied out. Made by tools/playlist.py from a
+   text file, which also checks the routine names against a board header.
+
+     header   'P' 'L'  version  count  crc_lo crc_hi  catalog_lo catalog_hi
+     entry    routine  duration_lo duration_hi  bpm_lo bpm_hi  palette  brightness  transition
+
+   routine      index into routines[] for the board the list was compiled for
+   duration     seconds
+   bpm          BPM * 10, 0 = keep
+   palette      PLAYLIST_PALETTE_* preset loaded as the user palette, PLAYLIST_KEEP = keep
+   brightness   0 = keep
+   transition   fade through black, in 1/10 s, 0 = cut
+
+   crc is the serial protocol's CRC-16 over all entries, so a half-written
+   EEPROM list is never played.
+
+   catalog is the same CRC-16 over the names of the board's routines, in
+   order, each with its terminating 0. A list compiled for another board, or
+   before routines were added or moved, would play the wrong ones by index;
+   it doesn't match the firmware's and is not played.
+*/
+
+#define PLAYLIST_VERSION      2
+#define PLAYLIST_HEADER_SIZE  8
+#define PLAYLIST_ENTRY_SIZE   8
+#define PLAYLIST_KEEP         0xFF
+
+// Same order as PALETTES in tools/playlist.py
+#define PLAYLIST_PALETTE_RAINBOW        0
+#define PLAYLIST_PALETTE_RAINBOW_STRIPE 1
+#define PLAYLIST_PALETTE_CLOUD          2
+#define PLAYLIST_PALETTE_PARTY          3
+#define PLAYLIST_PALETTE_OCEAN          4
+#define PLAYLIST_PALETTE_LAVA           5
+#define PLAYLIST_PALETTE_FOREST         6
+#define PLAYLIST_PALETTE_HEAT           7
+#define PLAYLIST_NUM_PALETTES           8
+
+#ifdef PLAYLIST_EEPROM
+#ifndef PLAYLIST_EEPROM_ADDR
+#define PLAYLIST_EEPROM_ADDR 0
+#endif
+#ifndef PLAYLIST_EEPROM_SIZE
+#define PLAYLIST_EEPROM_SIZE 512
+#endif
+#endif
+
+struct PlaylistEntry
+{
+  uint8_t routine ;
+  uint16_t duration ;
+  uint16_t bpm ;
+  uint8_t palette ;
+  uint8_t brightness ;
+  uint8_t transition ;
+};
+
+class Playlist
+{
+  public:
+    // Point the cursor at a list; false (and an empty list) if the header or crc don't
+    // check out, or the list was compiled for a catalog other than 'catalog'
+    bool beginFlash( const uint8_t* data, uint16_t catalog ) ;
+#ifdef PLAYLIST_EEPROM
+    bool beginEeprom( uint16_t catalog ) ;
+    // Store part of a new list, e.g. from the serial link. Call beginEeprom() again when done.
+    bool writeEeprom( uint16_t offset, const uint8_t* data, uint16_t len ) ;
+#endif
+
+    uint8_t count() { return _count ; }
+    uint8_t position() { return _pos ; }
+    void rewind() { _pos = 0 ; }
+
+    bool read( uint8_t index, PlaylistEntry& entry ) ;
+    // Read the entry at the cursor and move on, wrapping at the end
+    bool next( PlaylistEntry& entry ) ;
+
+  private:
+    uint8_t readByte( uint16_t offset ) ;
+    bool check( uint16_t catalog ) ;
+
+    const uint8_t* _flash = NULL ;
+    bool _fromEeprom = false ;
+    uint8_t _count = 0 ;
+    uint8_t _pos = 0 ;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "PowerLimiter.h"
+
+void PowerLimiter::begin( uint8_t numLeds, uint16_t budgetMa ) {
+  _numLeds = numLeds ;
+  _budget = budgetMa ;
+#ifdef POWER_BATTERY_PIN
+  _fullBudget = budgetMa ;
+  pinMode( POWER_BATTERY_PIN, INPUT ) ;
+#endif
+}
+
+
+void PowerLimiter::solidFrame( const CRGB& color ) {
+  _solid = true ;
+  _solidColor = color ;
+}
+
+
+uint32_t PowerLimiter::estimate( const CRGB* leds, uint8_t numLeds ) {
+  uint32_t sum = 0 ;
+  for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+    sum += weigh( leds[i] ) ;
+  }
+  return sum ;
+}
+
+
+uint8_t PowerLimiter::limit( const CRGB* leds, uint8_t brightness ) {
+  uint32_t full = _solid ? weigh( _solidColor ) * _numLeds : estimate( leds, _numLeds ) ;
+  _solid = false ;
+
+  // What's left for the colours once every LED has had its idle current
+  uint32_t idle = (uint32_t) POWER_MA_IDLE * _numLeds ;
+  uint32_t allowed = _budget > idle ? _budget - idle : 0 ;
+
+  // full is mA * 255 at brightness 255, so the draw at brightness b is full * b / 65025
+  uint8_t target = 255 ;
+  if ( full * 255 > allowed * 65025 ) {
+    target = ( allowed * 65025 ) / full ;
+  }
+
+  if ( target < _ceiling ) {
+    _ceiling = target ;                                // over budget: drop now
+  } else {
+    _ceiling += ( target - _ceiling + 7 ) / 8 ;        // back up gently
+  }
+
+  uint8_t out = min( brightness, _ceiling ) ;
+  _lastMa = idle + ( full * out ) / 65025 ;
+  return out ;
+}
+
+
+#ifdef POWER_BATTERY_PIN
+void PowerLimiter::updateBattery() {
+  uint16_t mv = ( (uint32_t) analogRead( POWER_BATTERY_PIN ) * POWER_BATTERY_FULLSCALE_MV ) / 1023 ;
+  // Smooth out the sag of single bright frames
+  _batteryMv = _batteryMv ? ( _batteryMv * 7 + mv ) / 8 : mv ;
+
+  uint16_t percent = 100 ;
+  if ( _batteryMv <= POWER_BATTERY_EMPTY_MV ) {
+    percent = POWER_BUDGET_MIN_PERCENT ;
+  } else if ( _batteryMv < POWER_BATTERY_FULL_MV ) {
+    percent = map( _batteryMv, POWER_BATTERY_EMPTY_MV, POWER_BATTERY_FULL_MV, POWER_BUDGET_MIN_PERCENT, 100 ) ;
+  }
+  _budget = ( (uint32_t) _fullBudget * percent ) / 100 ;
+}
+#endif
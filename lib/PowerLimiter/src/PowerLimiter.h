@@ -0,0 +1,98 @@
+#ifndef PowerLimiter_H
+#define PowerLimiter_H
+
+#include <Arduino.h>
+#include <FastLED.h>
+
+/*
+   Keeps the strip under POWER_BUDGET_MA by lowering the brightness of frames
+   that would draw more, instead of a hand-picked MAX_BRIGHTNESS that has to
+   hold for the worst frame (all white) of any routine.
+
+   Current model, per LED: POWER_MA_IDLE always, plus POWER_MA_RED/GREEN/BLUE
+   at full value, linear in value * brightness. The defaults are the ones
+   FastLED's own power functions use; measure your strip to tighten them.
+
+   The estimate is a single multiply-add per channel over leds[] in show().
+   Routines that fill the whole frame with one colour can call solidFrame()
+   first, and then that frame costs nothing to estimate.
+
+   The limit drops straight away when a frame would go over (no brown-outs),
+   and creeps back up over a few frames, so the picture doesn't pump.
+
+   With POWER_BATTERY_PIN the budget also follows the battery: full budget at
+   POWER_BATTERY_FULL_MV, down to POWER_BUDGET_MIN_PERCENT at POWER_BATTERY_EMPTY_MV.
+*/
+
+#ifndef POWER_MA_RED
+#define POWER_MA_RED    16
+#endif
+#ifndef POWER_MA_GREEN
+#define POWER_MA_GREEN  11
+#endif
+#ifndef POWER_MA_BLUE
+#define POWER_MA_BLUE   15
+#endif
+#ifndef POWER_MA_IDLE
+#define POWER_MA_IDLE   1
+#endif
+
+#ifdef POWER_BATTERY_PIN
+#ifndef POWER_BATTERY_FULLSCALE_MV
+#define POWER_BATTERY_FULLSCALE_MV 6600   // battery mV at ADC full scale (3.3V ref, 1:2 divider)
+#endif
+#ifndef POWER_BATTERY_FULL_MV
+#define POWER_BATTERY_FULL_MV 4100
+#endif
+#ifndef POWER_BATTERY_EMPTY_MV
+#define POWER_BATTERY_EMPTY_MV 3400
+#endif
+#ifndef POWER_BUDGET_MIN_PERCENT
+#define POWER_BUDGET_MIN_PERCENT 25
+#endif
+#endif
+
+class PowerLimiter
+{
+  public:
+    void begin( uint8_t numLeds, uint16_t budgetMa ) ;
+
+    void setBudget( uint16_t budgetMa ) { _budget = budgetMa ; }
+    uint16_t getBudget() { return _budget ; }
+
+    // The next frame is 'color' everywhere: skip the pass over leds[]
+    void solidFrame( const CRGB& color ) ;
+
+    // Brightness to send this frame with: 'brightness', or less if that would go over budget
+    uint8_t limit( const CRGB* leds, uint8_t brightness ) ;
+
+    // Draw of the last frame at the brightness limit() returned, in mA
+    uint16_t lastMa() { return _lastMa ; }
+    // Draw of a frame at full brightness, in mA * 255 (without idle current)
+    static uint32_t estimate( const CRGB* leds, uint8_t numLeds ) ;
+
+#ifdef POWER_BATTERY_PIN
+    // Read the battery and scale the budget; call every second or so
+    void updateBattery() ;
+    uint16_t batteryMv() { return _batteryMv ; }
+#endif
+
+  private:
+    static uint32_t weigh( const CRGB& c ) {
+      return (uint32_t) c.r * POWER_MA_RED + (uint32_t) c.g * POWER_MA_GREEN + (uint32_t) c.b * POWER_MA_BLUE ;
+    }
+
+    uint8_t _numLeds = 0 ;
+    uint16_t _budget = 0 ;
+    uint16_t _lastMa = 0 ;
+    uint8_t _ceiling = 255 ;
+    bool _solid = false ;
+    CRGB _solidColor ;
+
+#ifdef POWER_BATTERY_PIN
+    uint16_t _fullBudget = 0 ;
+    uint16_t _batteryMv = 0 ;
+#endif
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include "SerialCommand.h"
+
+void SerialCommand::begin( Stream* stream, SerialCommandCallback onCommand, SerialTextCallback onText, SerialPayloadSink sink ) {
+  _stream = stream ;
+  _onCommand = onCommand ;
+  _onText = onText ;
+  _sink = sink ;
+  _state = IDLE ;
+}
+
+
+void SerialCommand::poll() {
+  while ( _stream->available() > 0 ) {
+    feed( _stream->read() ) ;
+  }
+}
+
+
+// CRC-16/CCITT, bitwise: small in flash, and fast enough for a serial link
+uint16_t SerialCommand::crc16( uint16_t crc, uint8_t c ) {
+  crc ^= (uint16_t) c << 8 ;
+  for ( uint8_t i = 0 ; i < 8 ; i++ ) {
+    crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1 ;
+  }
+  return crc ;
+}
+
+
+void SerialCommand::feed( uint8_t c ) {
+  // Text lines come from people typing; only binary frames time out
+  if ( _state != IDLE && _state != TEXT ) {
+    uint32_t now = millis() ;
+    if ( now - _lastByte > SC_TIMEOUT_MS ) {
+      _timeouts++ ;
+      _state = IDLE ;      // this byte may well be the next frame's SOF
+    }
+    _lastByte = now ;
+  }
+
+  switch ( _state ) {
+    case IDLE:
+      if ( c == SC_SOF ) {
+        _crc = 0xFFFF ;
+        _lastByte = millis() ;
+        _state = SEQ ;
+      } else if ( c >= ' ' && c < 0x7F ) {
+        _line[0] = c ;
+        _pos = 1 ;
+        _state = TEXT ;
+      } // else: stray line ending or noise between frames
+      break ;
+
+    case SEQ:
+      _seq = c ;
+      _crc = crc16( _crc, c ) ;
+      _state = CMD ;
+      break ;
+
+    case CMD:
+      _cmd = c ;
+      _crc = crc16( _crc, c ) ;
+      _state = LEN_LO ;
+      break ;
+
+    case LEN_LO:
+      _len = c ;
+      _crc = crc16( _crc, c ) ;
+      _state = LEN_HI ;
+      break ;
+
+    case LEN_HI:
+      _len |= (uint16_t) c << 8 ;
+      _crc = crc16( _crc, c ) ;
+      _dest = _sink ? _sink( _cmd, _len ) : NULL ;
+      if ( ! _dest ) {
+        if ( _len > SC_MAX_PAYLOAD ) {
+          // Nowhere to put it; drop the frame and resync on the next SOF
+          reply( _seq, _cmd, SC_ERR_LENGTH ) ;
+          _state = IDLE ;
+          break ;
+        }
+        _dest = _payload ;
+      }
+      _pos = 0 ;
+      _state = _len ? PAYLOAD : CRC_LO ;
+      break ;
+
+    case PAYLOAD:
+      _dest[_pos++] = c ;
+      _crc = crc16( _crc, c ) ;
+      if ( _pos == _len ) _state = CRC_LO ;
+      break ;
+
+    case CRC_LO:
+      _rxCrc = c ;
+      _state = CRC_HI ;
+      break ;
+
+    case CRC_HI:
+      _rxCrc |= (uint16_t) c << 8 ;
+      finishFrame() ;
+      _state = IDLE ;
+      break ;
+
+    case TEXT:
+      if ( c == '\n' || c == '\r' ) {
+        _line[_pos] = 0 ;
+        finishLine() ;
+        _state = IDLE ;
+      } else if ( _pos < SC_MAX_LINE - 1 ) {
+        _line[_pos++] = c ;
+      } else {
+        _tooLong = true ;
+      }
+      break ;
+  }
+}
+
+
+void SerialCommand::finishFrame() {
+  if ( _rxCrc != _crc ) {
+    _crcErrors++ ;
+    reply( _seq, _cmd, SC_ERR_CRC ) ;
+    return ;
+  }
+
+  // Host didn't see our ack and sent it again: ack again, don't execute twice.
+  // seq alone wraps every 256 frames; a different command or payload is a new frame.
+  if ( _seq == _lastSeq && _cmd == _lastCmd && _crc == _lastCrc ) {
+    reply( _seq, _cmd, _lastStatus ) ;
+    return ;
+  }
+
+  _lastStatus = _onCommand ? _onCommand( _cmd, _dest, _len ) : SC_ERR_COMMAND ;
+  _lastSeq = _seq ;
+  _lastCmd = _cmd ;
+  _lastCrc = _crc ;
+  reply( _seq, _cmd, _lastStatus ) ;
+}
+
+
+void SerialCommand::finishLine() {
+  bool ok = false ;
+
+  if ( ! _tooLong && _onText ) {
+    // split "name arg..." in place
+    char* arg = _line ;
+    while ( *arg && *arg != ' ' ) arg++ ;
+    if ( *arg ) *arg++ = 0 ;
+    while ( *arg == ' ' ) arg++ ;
+    ok = _onText( _line, arg ) ;
+  }
+  _tooLong = false ;
+
+  _stream->println( ok ? F("ok") : F("err") ) ;
+}
+
+
+void SerialCommand::reply( uint8_t seq, uint8_t cmd, uint8_t status ) {
+  uint8_t buf[8] = { SC_SOF, seq, (uint8_t) ( cmd | SC_REPLY ), 1, 0, status, 0, 0 } ;
+  uint16_t crc = 0xFFFF ;
+  for ( uint8_t i = 1 ; i < 6 ; i++ ) crc = crc16( crc, buf[i] ) ;
+  buf[6] = crc & 0xFF ;
+  buf[7] = crc >> 8 ;
+  _stream->write( buf, sizeof(buf) ) ;
+}
@@ -0,0 +1,125 @@
+#ifndef SerialCommand_H
+#define SerialCommand_H
+
+#include <Arduino.h>
+
+/*
+   Serial control protocol. No String, no heap: everything lives in fixed
+   buffers inside the parser, and bytes are fed in one at a time.
+
+   Binary frames (all multi-byte values little endian):
+
+     0x7E  seq  cmd  len_lo len_hi  payload[len]  crc_lo crc_hi
+
+   crc is CRC-16/CCITT (0x1021, init 0xFFFF) over seq..payload. Every frame is
+   answered with
+
+     0x7E  seq  cmd|0x80  1 0  status  crc_lo crc_hi
+
+   A frame with the same seq, cmd and crc as the previous one is a retransmit:
+   it is acked again but not executed twice.
+
+   A frame whose bytes stop coming for SC_TIMEOUT_MS is dropped unanswered, so
+   a host that gave up half way doesn't leave the parser waiting for bytes
+   that will be read as the rest of it.
+
+   The ack goes out after the command has been executed (for SC_CMD_FRAME:
+   after the frame has been shown), so the host can time the round trip.
+
+   Anything that doesn't start with 0x7E is read as a text line for manual use
+   from a serial monitor, e.g. "mode 3", "mode fire2012", "bpm 120", "bright 40".
+   Text commands are answered with "ok" or "err".
+*/
+
+#define SC_SOF                0x7E
+
+#define SC_CMD_SET_MODE       0x01   // uint8 routine index
+#define SC_CMD_SET_BPM        0x02   // uint16 BPM * 10
+#define SC_CMD_SET_BRIGHTNESS 0x03   // uint8
+#define SC_CMD_PALETTE        0x04   // 16 x RGB = 48 bytes
+#define SC_CMD_FRAME          0x05   // NUM_LEDS x RGB
+#define SC_CMD_FRAME_CODED    0x06   // FrameCodec packet, see FrameCodec.h
+#define SC_CMD_PLAYLIST       0x07   // uint16 offset + playlist bytes for EEPROM, see Playlist.h
+#define SC_REPLY              0x80   // or'ed into cmd on the ack
+
+#define SC_OK                 0x00
+#define SC_ERR_CRC            0x01
+#define SC_ERR_LENGTH         0x02
+#define SC_ERR_COMMAND        0x03
+#define SC_ERR_ARGUMENT       0x04
+
+// Largest payload that goes into the parser's own buffer. Bigger ones (frames)
+// need a sink so they can be written straight to their destination.
+#ifndef SC_MAX_PAYLOAD
+#define SC_MAX_PAYLOAD 48
+#endif
+
+#ifndef SC_MAX_LINE
+#define SC_MAX_LINE 32
+#endif
+
+#ifndef SC_TIMEOUT_MS
+#define SC_TIMEOUT_MS 50
+#endif
+
+// Where should 'len' payload bytes of 'cmd' go? Return NULL to use the internal buffer.
+// Called before any of the payload is read, so the frame may still fail its CRC or
+// turn out to be a retransmit: only pick the buffer here, act in the callback.
+typedef uint8_t* (*SerialPayloadSink)( uint8_t cmd, uint16_t len ) ;
+// Execute a complete, CRC-checked binary command; return one of the SC_ status codes
+typedef uint8_t (*SerialCommandCallback)( uint8_t cmd, const uint8_t* payload, uint16_t len ) ;
+// Execute a text command: 'name' is the first word, 'arg' the rest of the line (may be empty)
+typedef bool (*SerialTextCallback)( const char* name, const char* arg ) ;
+
+class SerialCommand
+{
+  public:
+    void begin( Stream* stream, SerialCommandCallback onCommand, SerialTextCallback onText, SerialPayloadSink sink = NULL ) ;
+
+    // Read and handle everything waiting on the stream
+    void poll() ;
+    // Handle one byte; exposed so other transports can reuse the parser
+    void feed( uint8_t c ) ;
+
+    static uint16_t crc16( uint16_t crc, uint8_t c ) ;
+
+    uint16_t getCrcErrors() { return _crcErrors ; }
+    uint16_t getTimeouts() { return _timeouts ; }
+
+  private:
+    enum State { IDLE, SEQ, CMD, LEN_LO, LEN_HI, PAYLOAD, CRC_LO, CRC_HI, TEXT } ;
+
+    void finishFrame() ;
+    void finishLine() ;
+    void reply( uint8_t seq, uint8_t cmd, uint8_t status ) ;
+
+    Stream* _stream = NULL ;
+    SerialCommandCallback _onCommand = NULL ;
+    SerialTextCallback _onText = NULL ;
+    SerialPayloadSink _sink = NULL ;
+
+    State _state = IDLE ;
+    uint8_t _seq = 0 ;
+    uint8_t _cmd = 0 ;
+    uint16_t _len = 0 ;
+    uint16_t _pos = 0 ;
+    uint16_t _crc = 0 ;
+    uint16_t _rxCrc = 0 ;
+    uint8_t* _dest = NULL ;
+    bool _tooLong = false ;
+    uint32_t _lastByte = 0 ;     // millis() of the last byte of a binary frame
+
+    // The last frame executed, to spot retransmits, and what it answered
+    int16_t _lastSeq = -1 ;
+    uint8_t _lastCmd = 0 ;
+    uint16_t _lastCrc = 0 ;
+    uint8_t _lastStatus = SC_OK ;
+
+    uint16_t _crcErrors = 0 ;
+    uint16_t _timeouts = 0 ;
+
+    uint8_t _payload[SC_MAX_PAYLOAD] ;
+    char _line[SC_MAX_LINE] ;
+};
+
+#endif
@@ -3,6 +3,22 @@
 #include <ArduinoTapTempo.h>
 #include <LEDRoutines.h>
 #include <MPUFunctions.h>
+#include <PixelLayout.h>
+#include <FrameQueue.h>
+#include <SerialCommand.h>
+#include <FrameCodec.h>
+#include <Playlist.h>
+#include <PowerLimiter.h>
+#include <DitherOutput.h>
+#include <Apa102Hd.h>
+#include <ColorLut.h>
+#include <Effects.h>
+#include <FrameCheck.h>
+#include <ButtonInput.h>
+#include <IdleSleep.h>
+#include <FrameGovernor.h>
+#include <ParticlePool.h>
+#include <AudioInput.h>
 
 
 /*
@@ -52,8 +68,6 @@
 #define TASK_RES_MULTIPLIER 1000
 #endif
 
-#define BRIGHTFACTOR 0.2
-
 //black green white red
 
 #ifdef NEO_PIXEL
@@ -81,6 +95,87 @@
 #error "Error: DEFAULT_BPM not defined"
 #endif
 
+#if defined(FRAME_QUEUE_DEPTH) && ! defined(USE_GET_MILLISECOND_TIMER)
+#error "Error: FRAME_QUEUE_DEPTH needs USE_GET_MILLISECOND_TIMER so frames rendered ahead get their own timestamp"
+#endif
+
+#if defined(FRAME_CHECK) && ! defined(USE_GET_MILLISECOND_TIMER)
+#error "Error: FRAME_CHECK needs USE_GET_MILLISECOND_TIMER to run routines on its virtual clock"
+#endif
+
+#if defined(FRAME_QUEUE_DEPTH) && defined(TEMPORAL_DITHER)
+#error "Error: FRAME_QUEUE_DEPTH and TEMPORAL_DITHER both want to own the LED controller's buffer"
+#endif
+
+#if defined(FRAME_QUEUE_DEPTH) && defined(COLOR_LUT)
+#error "Error: FRAME_QUEUE_DEPTH and COLOR_LUT both want to own the LED controller's buffer"
+#endif
+
+#if defined(IDLE_SLEEP) && defined(ESP8266)
+#error "Error: IDLE_SLEEP only sleeps on ARM (WFI); delay() on the ESP8266 doesn't stop the CPU"
+#endif
+
+#if defined(RT_VUMETER) && ! defined(AUDIO_PIN)
+#error "Error: RT_VUMETER needs a microphone on AUDIO_PIN"
+#endif
+
+#if defined(AUDIO_PIN) && defined(POWER_BATTERY_PIN)
+#error "Error: AUDIO_PIN samples the ADC from an interrupt; POWER_BATTERY_PIN would be read in the middle of it"
+#endif
+
+#if defined(FRAME_GOVERNOR) && ( defined(TEMPORAL_DITHER) || defined(STRIPS_SEGMENTS) )
+#error "Error: FRAME_GOVERNOR skips frames show() would send; TEMPORAL_DITHER needs every step and STRIPS_SEGMENTS sends elsewhere"
+#endif
+
+#ifdef APA102_HD
+#if ! defined(APA_102) && ! defined(APA_102_SLOW)
+#error "Error: APA102_HD is an output mode for APA_102 / APA_102_SLOW strips"
+#endif
+#if defined(FRAME_QUEUE_DEPTH) || defined(TEMPORAL_DITHER)
+#error "Error: APA102_HD drives the strip without a FastLED controller; no FRAME_QUEUE_DEPTH or TEMPORAL_DITHER"
+#endif
+// Apa102Hd sends over the hardware SPI pins whatever MY_DATA_PIN/MY_CLOCK_PIN say
+static_assert( MY_DATA_PIN == MOSI && MY_CLOCK_PIN == SCK, "APA102_HD needs the strip on the SPI MOSI/SCK pins" ) ;
+#endif
+
+// More than one strip (NUM_STRIPS 2-4, each on STRIPn_DATA_PIN / STRIPn_CLOCK_PIN):
+//   STRIPS_MIRROR    every strip shows all of leds[], e.g. the two sides of the staff
+//   STRIPS_SEGMENTS  leds[] is cut into NUM_STRIPS equal segments, one per strip, each
+//                    running its own routine ("seg" over serial). Segment 0 is the one
+//                    the button, playlist and "mode" drive. A routine (and the others
+//                    drawn by the same method) runs on one segment at a time: they
+//                    would share its state.
+// Each strip has its own brightness on top of the global one ("strip" over serial).
+#ifndef NUM_STRIPS
+#define NUM_STRIPS 1
+#endif
+
+#if NUM_STRIPS > 4
+#error "Error: NUM_STRIPS can be at most 4"
+#endif
+
+#if NUM_STRIPS > 1 && defined(STRIPS_MIRROR) == defined(STRIPS_SEGMENTS)
+#error "Error: NUM_STRIPS > 1 needs either STRIPS_MIRROR or STRIPS_SEGMENTS"
+#endif
+
+#if NUM_STRIPS > 1 && defined(APA102_HD)
+#error "Error: APA102_HD drives a single strip"
+#endif
+
+#ifdef STRIPS_SEGMENTS
+#if defined(FRAME_QUEUE_DEPTH) || defined(TEMPORAL_DITHER) || defined(COLOR_LUT)
+#error "Error: STRIPS_SEGMENTS sends leds[] as drawn; no FRAME_QUEUE_DEPTH, TEMPORAL_DITHER or COLOR_LUT"
+#endif
+#if NUM_LEDS % NUM_STRIPS
+#error "Error: STRIPS_SEGMENTS needs NUM_LEDS to be a multiple of NUM_STRIPS"
+#endif
+#define STRIP_LEDS ( NUM_LEDS / NUM_STRIPS )
+#define STRIP_FIRST(n) ( leds + (n) * STRIP_LEDS )
+#else
+#define STRIP_LEDS NUM_LEDS
+#define STRIP_FIRST(n) leds
+#endif
+
 //#define NUM_LEDS 139
 CRGB leds[NUM_LEDS];
 uint8_t currentBrightness = DEFAULT_BRIGHTNESS ;
@@ -89,9 +184,40 @@ uint8_t currentBrightness = DEFAULT_BRIGHTNESS ;
 boolean longPressActive = false;
 ArduinoTapTempo tapTempo;
 
-// Serial input to change patterns, speed, etc
-String inputString = "";         // a String to hold incoming data
-boolean stringComplete = false;  // whether the string is complete
+// Serial input to change patterns, speed, etc. See SerialCommand.h for the protocol.
+#ifndef SERIAL_BAUD
+#define SERIAL_BAUD 115200
+#endif
+SerialCommand serialCmd;
+uint8_t onSerialCommand( uint8_t cmd, const uint8_t* payload, uint16_t len ) ; // prototype method
+bool onSerialText( const char* name, const char* arg ) ;                       // prototype method
+uint8_t* serialPayloadSink( uint8_t cmd, uint16_t len ) ;                      // prototype method
+
+// Live streaming: a host sends SC_CMD_FRAME frames and we just show them. The local
+// routine is paused while frames keep coming and resumes after STREAM_TIMEOUT_MS of silence.
+#ifndef STREAM_TIMEOUT_MS
+#define STREAM_TIMEOUT_MS 1000
+#endif
+boolean streaming = false;
+uint32_t streamFramesShown = 0 ;
+uint32_t streamFramesLate = 0 ;
+void stopStreaming() ;                            // prototype method
+Task taskStreamTimeout( STREAM_TIMEOUT_MS * TASK_RES_MULTIPLIER, TASK_ONCE, &stopStreaming);
+
+// Streamed frames land here, and only reach leds[] once their CRC has checked out: plain
+// frames are copied, compressed ones (SC_CMD_FRAME_CODED) decoded on top of the last frame.
+// A coded packet that would be bigger than FRAME_CODEC_BUFFER is sent as a plain SC_CMD_FRAME.
+#ifndef FRAME_CODEC_BUFFER
+#define FRAME_CODEC_BUFFER ( NUM_LEDS * 3 / 2 + 2 )
+#endif
+#define STREAM_BUFFER ( FRAME_CODEC_BUFFER > NUM_LEDS * 3 ? FRAME_CODEC_BUFFER : NUM_LEDS * 3 )
+uint8_t streamBuffer[STREAM_BUFFER];
+
+// Uncomment to measure how well each routine's output compresses; "codec" over serial prints it
+//#define FRAME_CODEC_STATS
+
+// Uncomment to time the particle engine with 4 - 256 particles; "particles" over serial (2KB of RAM)
+//#define PARTICLE_BENCH
 
 // Which mode do we start with
 #ifdef DEFAULT_LED_MODE
@@ -102,8 +228,14 @@ byte ledMode = 0;
 
 
 MPUFunctions mpuf = MPUFunctions() ;
-uint8_t numLeds = NUM_LEDS ;
+uint8_t numLeds = STRIP_LEDS ;   // what one LEDRoutines instance draws
 LEDRoutines ldr;
+PixelLayout layout;
+
+#if NUM_STRIPS > 1
+uint8_t stripBrightness[NUM_STRIPS] ;   // 255 = just the global brightness
+void stripCorrection( uint8_t strip, uint8_t brightness ) ;   // prototype method
+#endif
 
 
 /* Scheduler stuff */
@@ -113,17 +245,126 @@ void ledModeSelect() ;                          // prototype method
 Scheduler runner;
 Task taskLedModeSelect( LEDMODE_SELECT_DEFAULT_INTERVAL, TASK_FOREVER, &ledModeSelect);
 
+#ifdef STRIPS_SEGMENTS
+// Segment 0 is ldr / ledMode / taskLedModeSelect; these are segments 1 and up
+LEDRoutines segmentLdr[NUM_STRIPS - 1];
+byte segmentMode[NUM_STRIPS - 1];
+Task segmentTask[NUM_STRIPS - 1];
+void segmentSelect() ;                          // prototype method
+void findRoutineFamilies() ;                    // prototype method
+byte segmentStartMode( uint8_t seg ) ;          // prototype method
+// Woken by LEDRoutines::show(); runs after the segments that were due and sends all strips at once
+void stripFlush() ;                             // prototype method
+Task taskStripFlush( TASK_IMMEDIATE, TASK_ONCE, &stripFlush);
+#endif
+
 #ifdef BUTTON_PIN
-#define TASK_CHECK_BUTTON_PRESS_INTERVAL  10*TASK_RES_MULTIPLIER   // in milliseconds
-void checkButtonPress() ;                       // prototype method
-Task taskCheckButtonPress( TASK_CHECK_BUTTON_PRESS_INTERVAL, TASK_FOREVER, &checkButtonPress);
+// Edges are timestamped by interrupts and sorted out from loop(), see ButtonInput.h
+ButtonInput buttons;
+void onButton( ButtonEvent event, uint32_t atMicros ) ;   // prototype method
 #endif
 
-#ifdef AUTOADVANCE
+// A playlist (PLAYLIST = header made by tools/playlist.py, and/or PLAYLIST_EEPROM)
+// takes over from AUTOADVANCE: it picks routine, BPM, palette and brightness per entry.
+#if defined(PLAYLIST) || defined(PLAYLIST_EEPROM)
+#define USE_PLAYLIST
+#ifdef PLAYLIST
+#include PLAYLIST
+#endif
+Playlist playlist;
+PlaylistEntry playlistNext;           // waits here while the previous entry fades out
+uint16_t playlistRemaining = 0 ;      // seconds left of the current entry
+uint8_t playlistFade = 255 ;
+uint8_t playlistFadeStep = 255 ;
+boolean playlistFadingOut = false ;
+void startPlaylist() ;                            // prototype method
+void playlistTick() ;                             // prototype method
+void playlistFadeTick() ;                         // prototype method
+Task taskPlaylist( TASK_SECOND, TASK_FOREVER, &playlistTick);
+Task taskPlaylistFade( 20 * TASK_RES_MULTIPLIER, TASK_FOREVER, &playlistFadeTick);
+#elif defined(AUTOADVANCE)
 void autoAdvanceLedMode() ;                       // prototype method
 Task taskAutoAdvanceLedMode( 30 * TASK_SECOND, TASK_FOREVER, &autoAdvanceLedMode);
 #endif
 
+#ifdef POWER_BUDGET_MA
+// Estimates each frame's current and turns the brightness down when it would go over the budget
+PowerLimiter power;
+// Mirrored strips all show leds[], so each gets its share of the budget
+#ifdef STRIPS_MIRROR
+#define POWER_COPIES NUM_STRIPS
+#else
+#define POWER_COPIES 1
+#endif
+#ifdef POWER_BATTERY_PIN
+void checkBattery() ;                             // prototype method
+Task taskCheckBattery( TASK_SECOND, TASK_FOREVER, &checkBattery);
+#endif
+#endif
+
+#ifdef APA102_HD
+// Sends leds[] itself, with brightness in each pixel's 5-bit current field; see Apa102Hd.h
+Apa102Hd apaHd;
+#endif
+
+#if defined(COLOR_LUT) && ! defined(TEMPORAL_DITHER) && ! defined(APA102_HD)
+// Gamma / white balance on the way out; dither and APA102_HD apply it themselves
+ColorLut colorLut;
+#endif
+
+#ifdef TEMPORAL_DITHER
+// Keeps resending the last frame with error diffusion, see DitherOutput.h
+DitherOutput dither;
+void ditherRefresh() ;                            // prototype method
+Task taskDitherRefresh( DITHER_REFRESH_US, TASK_FOREVER, &ditherRefresh);
+#endif
+
+#ifdef ZONES
+// Effects running side by side on parts of leds[], drawn by the "zones" routine.
+// The board header lists them as ZONE( name, effect type, (constructor args), first LED, length, stride );
+// the args can't be empty "()" since that would declare a function.
+#ifndef ZONE_TICK_MS
+#define ZONE_TICK_MS 5
+#endif
+#define ZONE( name, type, args, first, length, stride ) type name args ;
+ZONES
+#undef ZONE
+#define ZONE( name, type, args, first, length, stride ) { { leds + (first), (length), (stride) }, &name, 0 },
+Zone zones[] = { ZONES } ;
+#undef ZONE
+ZoneRunner zoneRunner;
+#endif
+
+#ifdef FRAME_QUEUE_DEPTH
+// Render-ahead: deterministic routines fill frameQueue in idle time, taskFrameOutput pushes them out on time
+FrameQueue frameQueue;
+void frameOutput() ;                              // prototype method
+Task taskFrameOutput( 1 * TASK_RES_MULTIPLIER, TASK_FOREVER, &frameOutput);
+#endif
+
+#ifdef FRAME_CHECK
+// Reproducible runs of the routines for the "check" command, see FrameCheck.h
+FrameCheck frameCheck;
+#endif
+
+#ifdef IDLE_SLEEP
+// Sleeps in loop() while no task is due, see IdleSleep.h
+IdleSleep idleSleep;
+void idleUntilNextTask() ;                        // prototype method
+#endif
+
+#ifdef AUDIO_PIN
+// Samples the microphone from a timer interrupt; loop() analyses each block, see AudioInput.h
+AudioInput audio;
+#endif
+
+#ifdef FRAME_GOVERNOR
+// Skips sending frames that look like the last one, and slows down routines while they do; see FrameGovernor.h
+FrameGovernor governor;
+CRGB governorLast[NUM_LEDS];
+void governFrame() ;                              // prototype method
+#endif
+
 // ==================================================================== //
 // ===               MPU6050 variable declarations                ===== //
 // ==================================================================== //
@@ -170,31 +411,114 @@ Task taskGetDMPData( 3 * TASK_RES_MULTIPLIER, TASK_FOREVER, &getDMPData);
 // ============================ Begin Setup =========================== //
 // ==================================================================== //
 
+// Strips 2 and up: same chipset and data rate as the first one
+#if defined(NEO_PIXEL)
+#define ADD_STRIP(n) FastLED.addLeds<CHIPSET, STRIP##n##_DATA_PIN, COLOR_ORDER>(STRIP_FIRST(n - 1), STRIP_LEDS).setCorrection( TypicalLEDStrip )
+#elif defined(APA_102_SLOW)
+#define ADD_STRIP(n) FastLED.addLeds<CHIPSET, STRIP##n##_DATA_PIN, STRIP##n##_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(2)>(STRIP_FIRST(n - 1), STRIP_LEDS).setCorrection( TypicalLEDStrip )
+#else
+#define ADD_STRIP(n) FastLED.addLeds<CHIPSET, STRIP##n##_DATA_PIN, STRIP##n##_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(12)>(STRIP_FIRST(n - 1), STRIP_LEDS).setCorrection( TypicalLEDStrip )
+#endif
+
 
 void setup() {
   delay( 1000 ); // power-up safety delay
 
   #ifdef NEO_PIXEL
-  FastLED.addLeds<CHIPSET, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS).setCorrection( TypicalLEDStrip );
+  FastLED.addLeds<CHIPSET, LED_PIN, COLOR_ORDER>(leds, STRIP_LEDS).setCorrection( TypicalLEDStrip );
   #endif
 
-  #ifdef APA_102
-  FastLED.addLeds<CHIPSET, MY_DATA_PIN, MY_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(12)>(leds, NUM_LEDS).setCorrection( TypicalLEDStrip );
+  #if defined(APA102_HD) && defined(APA_102_SLOW)
+  apaHd.begin( numLeds, 2000000 );
+  ldr.setApa102Hd( &apaHd );
+  #elif defined(APA102_HD)
+  apaHd.begin( numLeds );
+  ldr.setApa102Hd( &apaHd );
   #endif
 
-  #ifdef APA_102_SLOW
+  #if defined(APA_102) && ! defined(APA102_HD)
+  FastLED.addLeds<CHIPSET, MY_DATA_PIN, MY_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(12)>(leds, STRIP_LEDS).setCorrection( TypicalLEDStrip );
+  #endif
+
+  #if defined(APA_102_SLOW) && ! defined(APA102_HD)
   // Some APA102's require a very low data rate or they start flickering. Shitty quality LEDs? Wiring? Level shifter?? TODO: figure it out!
-  FastLED.addLeds<CHIPSET, MY_DATA_PIN, MY_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(2)>(leds, NUM_LEDS).setCorrection( TypicalLEDStrip );
+  FastLED.addLeds<CHIPSET, MY_DATA_PIN, MY_CLOCK_PIN, COLOR_ORDER, DATA_RATE_MHZ(2)>(leds, STRIP_LEDS).setCorrection( TypicalLEDStrip );
+  #endif
+
+  #if NUM_STRIPS > 1
+  ADD_STRIP(2);
+  #endif
+  #if NUM_STRIPS > 2
+  ADD_STRIP(3);
+  #endif
+  #if NUM_STRIPS > 3
+  ADD_STRIP(4);
+  #endif
+  #if NUM_STRIPS > 1
+  memset( stripBrightness, 255, sizeof(stripBrightness) ) ;
   #endif
 
+  layout.begin( numLeds );
   ldr.setLeds( leds, numLeds, &tapTempo, &taskLedModeSelect, &currentBrightness );
+  ldr.setLayout( &layout );
+  #ifdef USE_GET_MILLISECOND_TIMER
+  ldr.setClock( get_millisecond_timer );   // render-ahead and "check" time reach the routines' own timing too
+  #endif
 
-  FastLED.setBrightness( currentBrightness );
+  #ifdef ZONES
+  zoneRunner.begin( zones, sizeof(zones) / sizeof(zones[0]) );
+  #endif
 
-  #if defined(BUTTON_PIN)
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  #ifdef STRIPS_SEGMENTS
+  ldr.setFlushTask( &taskStripFlush );
+  findRoutineFamilies();
+  for ( uint8_t i = 0 ; i < NUM_STRIPS - 1 ; i++ ) {
+    segmentLdr[i].setLeds( STRIP_FIRST(i + 1), numLeds, &tapTempo, &segmentTask[i], &currentBrightness );
+    segmentLdr[i].setLayout( &layout );
+    segmentLdr[i].setFlushTask( &taskStripFlush );
+    segmentLdr[i].setClock( ldr._clock );
+    segmentMode[i] = segmentStartMode( i + 1 ) ;
+    segmentTask[i].set( LEDMODE_SELECT_DEFAULT_INTERVAL, TASK_FOREVER, &segmentSelect );
+  }
+  #endif
+
+  #ifdef FRAME_QUEUE_DEPTH
+  frameQueue.begin( &FastLED[0], leds, numLeds );
+  ldr.setFrameQueue( &frameQueue );
+  #endif
+
+  #ifdef POWER_BUDGET_MA
+  power.begin( NUM_LEDS, POWER_BUDGET_MA / POWER_COPIES );
+   #ifndef STRIPS_SEGMENTS
+  ldr.setPowerLimiter( &power );
+   #endif   // else stripFlush() limits all segments together; no one routine's solidFrame() holds for leds[]
+  #endif
+
+  #ifdef TEMPORAL_DITHER
+  dither.begin( &FastLED[0], leds, numLeds );
+  ldr.setDitherOutput( &dither );
+  #endif
+
+  #ifdef AUDIO_PIN
+  audio.begin( AUDIO_PIN );
+  ldr.setAudioInput( &audio );
+  #endif
+
+  #ifdef FRAME_GOVERNOR
+  governor.begin( governorLast, numLeds );
+  ldr.setFrameGovernor( &governor );
   #endif
 
+  #ifdef COLOR_LUT
+  FastLED.setCorrection( UncorrectedColor );  // white balance is in the LUT
+   #if ! defined(TEMPORAL_DITHER) && ! defined(APA102_HD)
+  colorLut.begin( &FastLED[0], leds, numLeds );
+  ldr.setColorLut( &colorLut );
+   #endif
+  #endif
+
+  FastLED.setBrightness( currentBrightness );
+
   // On these boards one of the button pins is connected to these, so we pull it low so when the button is pressed, the input pin goes low too.
   #if defined(BUTTON_GND_PIN)
   pinMode(BUTTON_GND_PIN, OUTPUT);
@@ -206,13 +530,12 @@ void setup() {
   digitalWrite(BUTTON_LED_PIN, HIGH);
   #endif
 
-  #if defined(BPM_BUTTON_PIN)
-  pinMode(BPM_BUTTON_PIN, INPUT_PULLUP);
+  #if defined(BUTTON_PIN) && defined(BPM_BUTTON_PIN)
+  buttons.begin( BUTTON_PIN, BPM_BUTTON_PIN, &onButton );
+  #elif defined(BUTTON_PIN)
+  buttons.begin( BUTTON_PIN, -1, &onButton );
   #endif
 
-  // Not sure this actually works
-  //FastLED.setMaxPowerInVoltsAndMilliamps(5,475);
-
   #ifdef ESP8266
     yield(); // not sure if needed to placate ESP watchdog
   #endif
@@ -222,16 +545,41 @@ void setup() {
   runner.addTask(taskLedModeSelect);
   taskLedModeSelect.enable() ;
 
-#ifdef BUTTON_PIN
-  runner.addTask(taskCheckButtonPress);
-  taskCheckButtonPress.enable() ;
+#ifdef STRIPS_SEGMENTS
+  for ( uint8_t i = 0 ; i < NUM_STRIPS - 1 ; i++ ) {
+    runner.addTask(segmentTask[i]);
+    segmentTask[i].enable() ;
+  }
+  runner.addTask(taskStripFlush);   // after the segments, so one pass draws them all before it sends
 #endif
 
-#ifdef AUTOADVANCE
+#if defined(USE_PLAYLIST)
+  startPlaylist() ;
+  runner.addTask(taskPlaylist);
+  runner.addTask(taskPlaylistFade);
+  taskPlaylist.enable() ;
+#elif defined(AUTOADVANCE)
   runner.addTask(taskAutoAdvanceLedMode);
   taskAutoAdvanceLedMode.enable() ;
 #endif
 
+#ifdef FRAME_QUEUE_DEPTH
+  runner.addTask(taskFrameOutput);
+  taskFrameOutput.enable() ;
+#endif
+
+  runner.addTask(taskStreamTimeout);
+
+#if defined(POWER_BUDGET_MA) && defined(POWER_BATTERY_PIN)
+  runner.addTask(taskCheckBattery);
+  taskCheckBattery.enable() ;
+#endif
+
+#ifdef TEMPORAL_DITHER
+  runner.addTask(taskDitherRefresh);
+  taskDitherRefresh.enable() ;
+#endif
+
 
 // #ifdef ESP8266
 // WiFi.forceSleepBegin();
@@ -297,7 +645,9 @@ void setup() {
 #endif
 
   tapTempo.setBPM(DEFAULT_BPM);
-  inputString.reserve(200);
+
+  Serial.begin(SERIAL_BAUD);
+  serialCmd.begin( &Serial, &onSerialCommand, &onSerialText, &serialPayloadSink );
 }  // end setup()
 
 
@@ -310,481 +660,818 @@ void loop() {
   #ifdef ESP8266
     yield() ; // Pat the ESP watchdog
   #endif
+  serialCmd.poll();
+#ifdef BUTTON_PIN
+  buttons.poll();
+#endif
+#ifdef AUDIO_PIN
+  audio.poll();
+#endif
+#ifdef IDLE_SLEEP
+  if ( runner.execute() ) idleUntilNextTask() ;   // true: nothing was due
+#else
   runner.execute();
+#endif
 }
 
 
 
- // Routine Palette Rainbow is always included - a safe routine
- const char *routines[] = {
-   "p_rb",
- #ifdef RT_P_RB_STRIPE
-   "p_rb_stripe",
- #endif
- #ifdef RT_P_OCEAN
-   "p_ocean",
- #endif
- #ifdef RT_P_HEAT
-   "p_heat",
- #endif
- #ifdef RT_P_LAVA
-   "p_lava",
- #endif
- #ifdef RT_P_PARTY
-   "p_party",
- #endif
- #ifdef RT_TWIRL1
-   "twirl1",
- #endif
- #ifdef RT_TWIRL2
-   "twirl2",
- #endif
- #ifdef RT_TWIRL4
-   "twirl4",
- #endif
- #ifdef RT_TWIRL6
-   "twirl6",
- #endif
- #ifdef RT_TWIRL2_O
-   "twirl2o",
- #endif
- #ifdef RT_TWIRL4_O
-   "twirl4o",
- #endif
- #ifdef RT_TWIRL6_O
-   "twirl6o",
- #endif
- #ifdef RT_FADE_GLITTER
-   "fglitter",
- #endif
- #ifdef RT_DISCO_GLITTER
-   "dglitter",
- #endif
- #ifdef RT_FIRE2012
-   "fire2012",
- #endif
- #ifdef RT_RACERS
-   "racers",
- #endif
- #ifdef RT_WAVE
-   "wave",
- #endif
- #ifdef RT_SHAKE_IT
-   "shakeit",
- #endif
- #ifdef RT_STROBE1
-   "strobe1",
- #endif
- #ifdef RT_STROBE2
-   "strobe2",
- #endif
- #ifdef RT_GLED
-   "gled",
- #endif
- #ifdef RT_HEARTBEAT
-   "heartbeat",
- #endif
- #ifdef RT_FASTLOOP
-   "fastloop",
- #endif
- #ifdef RT_FASTLOOP2
-   "fastloop2",
- #endif
- #ifdef RT_PENDULUM
-   "pendulum",
- #endif
- #ifdef RT_VUMETER
-   "vumeter",
- #endif
- #ifdef RT_NOISE_LAVA
-   "noise_lava",
- #endif
- #ifdef RT_NOISE_PARTY
-   "noise_party",
- #endif
- #ifdef RT_BOUNCEBLEND
-   "bounceblend",
- #endif
- #ifdef RT_JUGGLE_PAL
-   "jugglepal",
- #endif
- #ifdef RT_QUAD_STROBE
-   "quadstrobe",
- #endif
- #ifdef RT_PULSE_3
-   "pulse3",
- #endif
- #ifdef RT_PULSE_5_1
-   "pulse5_1",
- #endif
- #ifdef RT_PULSE_5_2
-   "pulse5_2",
- #endif
- #ifdef RT_PULSE_5_3
-   "pulse5_3",
- #endif
- #ifdef RT_THREE_SIN_PAL
-   "tsp",
- #endif
- #ifdef RT_COLOR_GLOW
-   "color_glow",
- #endif
- #ifdef RT_FAN_WIPE
-   "fan_wipe",
- #endif
- #ifdef RT_DROPLETS
-   "droplets",
- #endif
- #ifdef RT_DROPLETS2
-   "droplets2",
- #endif
- #ifdef RT_BOUNCYBALLS
-   "bouncyballs",
- #endif
- #ifdef RT_CIRC_LOADER
-   "circloader",
- #endif
- #ifdef RT_RIPPLE
-   "ripple",
- #endif
- #ifdef RT_RANDOMWALK
-   "randomwalk",
- #endif
- #ifdef RT_FASTLOOP3
-   "fastloop3",
- #endif
- #ifdef RT_POVPATTERNS
-   "povpatterns",
- #endif
- #ifdef RT_BLACK
-   "black",
- #endif
-
+ // One table for the names, intervals and draw calls, built from the board's
+ // RT_* defines: see RoutineCatalog.h
+ struct Routine
+ {
+   const char* name ;
+   uint32_t interval ;   // task interval after each frame, or OWN_INTERVAL
+   uint8_t flags ;       // STRETCHABLE, BATCHABLE
+   void (*draw)( LEDRoutines& ldr, Task& taskLedModeSelect ) ;
  };
 
- #define NUMROUTINES (sizeof(routines)/sizeof(char *)) //array size
+ #define OWN_INTERVAL 0xFFFFFFFF
+ #define STRETCHABLE 0x01
+ #define BATCHABLE 0x02
+ #define ROUTINE( name, interval, flags, ... ) { name, interval, flags, []( LEDRoutines& ldr, Task& taskLedModeSelect ) { __VA_ARGS__ ; } },
 
+ const Routine routineTable[] = {
+ #include <RoutineCatalog.h>
+ };
 
- void ledModeSelect() {
-   #ifdef ESP8266
-     yield();
-   #endif
+ #undef ROUTINE
 
-   if ( strcmp(routines[ledMode], "p_rb") == 0  ) {
-     ldr.FillLEDsFromPaletteColors(0) ;
+ #define NUMROUTINES (sizeof(routineTable)/sizeof(Routine)) //array size
 
- #ifdef RT_P_RB_STRIPE
-   } else if ( strcmp(routines[ledMode], "p_rb_stripe") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(1) ;
- #endif
 
- #ifdef RT_P_OCEAN
-   } else if ( strcmp(routines[ledMode], "p_ocean") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(2) ;
- #endif
+ void renderLedMode( LEDRoutines& ldr, byte ledMode, Task& taskLedModeSelect ) ;  // prototype method
 
- #ifdef RT_P_HEAT
-   } else if ( strcmp(routines[ledMode], "p_heat") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(3) ;
+ #ifdef FRAME_QUEUE_DEPTH
+ void frameOutput() {
+   frameQueue.showDue() ;
+ }
  #endif
 
- #ifdef RT_P_LAVA
-   } else if ( strcmp(routines[ledMode], "p_lava") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(4) ;
- #endif
+ #ifdef FRAME_CODEC_STATS
+ // Encode every rendered frame against the one before it, as the host would, and
+ // keep byte counts per routine. Let AUTOADVANCE run through the routines, then ask for "codec".
+ uint32_t codecRawBytes[NUMROUTINES] ;
+ uint32_t codecCodedBytes[NUMROUTINES] ;
+ uint8_t codecTypeCount[NUMROUTINES][4] ;
+ CRGB codecPrev[NUM_LEDS] ;
 
- #ifdef RT_P_PARTY
-   } else if ( strcmp(routines[ledMode], "p_party") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(5) ;
- #endif
+ void codecStats() {
+   static uint8_t out[1 + NUM_LEDS * 3] ;
+   static byte lastMode = 255 ;
 
- #ifdef RT_P_CLOUD
-   } else if ( strcmp(routines[ledMode], "p_cloud") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(6) ;
- #endif
+   // First frame of a routine has no delta base
+   uint16_t len = FrameCodec::encode( (uint8_t*) leds, ledMode == lastMode ? (uint8_t*) codecPrev : NULL, NUM_LEDS, out, sizeof(out) ) ;
+   codecRawBytes[ledMode] += NUM_LEDS * 3 ;
+   codecCodedBytes[ledMode] += len ;
+   codecTypeCount[ledMode][out[0]] = qadd8( codecTypeCount[ledMode][out[0]], 1 ) ;
 
- #ifdef RT_P_FOREST
-   } else if ( strcmp(routines[ledMode], "p_forest") == 0 ) {
-     ldr.FillLEDsFromPaletteColors(7) ;
- #endif
+   memcpy( codecPrev, leds, sizeof(codecPrev) ) ;
+   lastMode = ledMode ;
+ }
 
- #ifdef RT_TWIRL1
-   } else if ( strcmp(routines[ledMode], "twirl1") == 0 ) {
-     ldr.twirlers( 1, false ) ;
-     taskLedModeSelect.setInterval( TASK_IMMEDIATE ) ;
+ void printCodecStats() {
+   for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+     if ( ! codecRawBytes[i] ) continue ;
+     Serial.print( routineTable[i].name ) ;
+     Serial.print( F(" ") ) ;
+     Serial.print( codecCodedBytes[i] * 100 / codecRawBytes[i] ) ;
+     Serial.print( F("% raw/rle/delta/pal ") ) ;
+     for ( uint8_t t = 0 ; t < 4 ; t++ ) {
+       if ( t ) Serial.print( F("/") ) ;
+       Serial.print( codecTypeCount[i][t] ) ;
+     }
+     Serial.println() ;
+   }
+ }
  #endif
 
- #ifdef RT_TWIRL2
-   } else if ( strcmp(routines[ledMode], "twirl2") == 0 ) {
-     ldr.twirlers( 2, false ) ;
-     taskLedModeSelect.setInterval( TASK_IMMEDIATE ) ;
- #endif
 
- #ifdef RT_TWIRL4
-   } else if ( strcmp(routines[ledMode], "twirl4") == 0 ) {
-     ldr.twirlers( 4, false ) ;
- #endif
+ #ifdef IDLE_SLEEP
+ // Time awake and in total per routine, for "duty"
+ uint32_t dutyAwakeUs[NUMROUTINES] ;
+ uint32_t dutyTotalUs[NUMROUTINES] ;
 
- #ifdef RT_TWIRL6
-   } else if ( strcmp(routines[ledMode], "twirl6") == 0 ) {
-     ldr.twirlers( 6, false ) ;
- #endif
+ long earliest( long next, Task& task ) {
+   long t = runner.timeUntilNextIteration( task ) ;   // -1: disabled
+   return t >= 0 && ( next < 0 || t < next ) ? t : next ;
+ }
 
- #ifdef RT_TWIRL2_O
-   } else if ( strcmp(routines[ledMode], "twirl2o") == 0 ) {
-     ldr.twirlers( 2, true ) ;
+ // Every task setup() adds to the runner, under the same conditions
+ long untilNextTask() {
+   long next = earliest( -1, taskLedModeSelect ) ;
+ #ifdef STRIPS_SEGMENTS
+   for ( uint8_t i = 0 ; i < NUM_STRIPS - 1 ; i++ ) next = earliest( next, segmentTask[i] ) ;
+   next = earliest( next, taskStripFlush ) ;
  #endif
-
- #ifdef RT_TWIRL4_O
-   } else if ( strcmp(routines[ledMode], "twirl4o") == 0 ) {
-     ldr.twirlers( 4, true ) ;
+ #if defined(USE_PLAYLIST)
+   next = earliest( next, taskPlaylist ) ;
+   next = earliest( next, taskPlaylistFade ) ;
+ #elif defined(AUTOADVANCE)
+   next = earliest( next, taskAutoAdvanceLedMode ) ;
  #endif
-
- #ifdef RT_TWIRL6_O
-   } else if ( strcmp(routines[ledMode], "twirl6o") == 0 ) {
-     ldr.twirlers( 6, true ) ;
+ #ifdef FRAME_QUEUE_DEPTH
+   next = earliest( next, taskFrameOutput ) ;
  #endif
-
- #ifdef RT_FADE_GLITTER
-   } else if ( strcmp(routines[ledMode], "fglitter") == 0 ) {
-     ldr.fadeGlitter() ;
-     //taskLedModeSelect.setInterval( map( constrain( activityLevel(), 0, 4000), 0, 4000, 20, 5 ) * TASK_RES_MULTIPLIER ) ;
- #ifdef USING_MPU
-     taskLedModeSelect.setInterval( map( constrain( activityLevel(), 0, 2500), 0, 2500, 40, 2 ) * TASK_RES_MULTIPLIER ) ;
- #else
-     taskLedModeSelect.setInterval( 20 * TASK_RES_MULTIPLIER ) ;
+   next = earliest( next, taskStreamTimeout ) ;
+ #if defined(POWER_BUDGET_MA) && defined(POWER_BATTERY_PIN)
+   next = earliest( next, taskCheckBattery ) ;
  #endif
+ #ifdef TEMPORAL_DITHER
+   next = earliest( next, taskDitherRefresh ) ;
  #endif
-
- #ifdef RT_DISCO_GLITTER
-   } else if ( strcmp(routines[ledMode], "dglitter") == 0 ) {
-     ldr.discoGlitter() ;
  #ifdef USING_MPU
-     taskLedModeSelect.setInterval( map( constrain( activityLevel(), 0, 2500), 0, 2500, 40, 2 ) * TASK_RES_MULTIPLIER ) ;
- #else
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+   next = earliest( next, taskGetDMPData ) ;
  #endif
+   return next ;
+ }
 
- #ifdef RT_GLED
-     // Gravity LED
-   } else if ( strcmp(routines[ledMode], "gled") == 0 ) {
-     ldr.gLed() ;
-     taskLedModeSelect.setInterval( 5 * TASK_RES_MULTIPLIER ) ;
- #endif
+ void idleUntilNextTask() {
+   static uint32_t lastLoop = micros() ;
+   long next = untilNextTask() ;
+   uint32_t slept = idleSleep.sleep( next < 0 ? 0xFFFFFFFF : next ) ;
+
+   uint32_t now = micros() ;
+   dutyTotalUs[ledMode] += now - lastLoop ;
+   dutyAwakeUs[ledMode] += now - lastLoop - slept ;
+   lastLoop = now ;
+   if ( dutyTotalUs[ledMode] & 0x80000000 ) {   // keep the ratio, not the overflow
+     dutyTotalUs[ledMode] >>= 1 ;
+     dutyAwakeUs[ledMode] >>= 1 ;
+   }
+ }
 
- #ifdef RT_FIRE2012
-   } else if ( strcmp(routines[ledMode], "fire2012") == 0 ) {
-     ldr.Fire2012() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
+ void printDuty() {
+   for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+     if ( ! dutyTotalUs[i] ) continue ;
+     Serial.print( routineTable[i].name ) ;
+     Serial.print( F(" awake ") ) ;
+     Serial.print( (uint32_t) ( (uint64_t) dutyAwakeUs[i] * 100 / dutyTotalUs[i] ) ) ;
+     Serial.println( F("%") ) ;
+   }
+ }
  #endif
 
 
- #ifdef RT_RACERS
-   } else if ( strcmp(routines[ledMode], "racers") == 0 ) {
-     ldr.racingLeds() ;
-     taskLedModeSelect.setInterval( 8 * TASK_RES_MULTIPLIER) ;
- #endif
+ #ifdef FRAME_GOVERNOR
+ // Frames drawn, frames that would have been drawn at the routine's own rate but
+ // weren't, and frames sent, per routine, for "governor"
+ uint32_t governorDrawn[NUMROUTINES] ;
+ uint32_t governorSkipped[NUMROUTINES] ;
+ uint32_t governorSent[NUMROUTINES] ;
 
- #ifdef RT_WAVE
-   } else if ( strcmp(routines[ledMode], "wave") == 0 ) {
-     ldr.waveYourArms() ;
-     taskLedModeSelect.setInterval( 15 * TASK_RES_MULTIPLIER) ;
- #endif
+ void governFrame() {
+   governorDrawn[ledMode]++ ;
+   if ( governor.lastChanged() ) governorSent[ledMode]++ ;
 
- #ifdef RT_SHAKE_IT
-   } else if ( strcmp(routines[ledMode], "shakeit") == 0 ) {
-     ldr.shakeIt() ;
-     taskLedModeSelect.setInterval( 8 * 1000 ) ;
- #endif
+   uint32_t interval = taskLedModeSelect.getInterval() ;
+   if ( ! interval || ! ( routineTable[ledMode].flags & STRETCHABLE ) ) return ;
+   uint32_t stretched = governor.stretch( interval, FRAME_GOVERNOR_MAX_MS * TASK_RES_MULTIPLIER ) ;
+   taskLedModeSelect.setInterval( stretched ) ;
+   governorSkipped[ledMode] += stretched / interval - 1 ;
+ }
 
- #ifdef RT_STROBE1
-   } else if ( strcmp(routines[ledMode], "strobe1") == 0 ) {
-     ldr.strobe1() ;
-     taskLedModeSelect.setInterval( 5 * TASK_RES_MULTIPLIER ) ;
+ // Savings against drawing and sending every frame at the routine's own rate
+ void printGovernor() {
+   for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+     uint32_t full = governorDrawn[i] + governorSkipped[i] ;
+     if ( ! full ) continue ;
+     Serial.print( routineTable[i].name ) ;
+     Serial.print( F(" drawn ") ) ;
+     Serial.print( governorDrawn[i] ) ;
+     Serial.print( F(" sent ") ) ;
+     Serial.print( governorSent[i] ) ;
+     Serial.print( F(" of ") ) ;
+     Serial.print( full ) ;
+     Serial.print( F(": cpu -") ) ;
+     Serial.print( (uint32_t) ( (uint64_t) governorSkipped[i] * 100 / full ) ) ;
+     Serial.print( F("% spi -") ) ;
+     Serial.print( (uint32_t) ( (uint64_t) ( full - governorSent[i] ) * 100 / full ) ) ;
+     Serial.println( F("%") ) ;
+   }
+ }
  #endif
 
- #ifdef RT_STROBE2
-   } else if ( strcmp(routines[ledMode], "strobe2") == 0 ) {
-     ldr.strobe2() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
 
- #ifdef RT_HEARTBEAT
-   } else if ( strcmp(routines[ledMode], "heartbeat") == 0 ) {
-     ldr.heartbeat() ;
-     taskLedModeSelect.setInterval( 5 * TASK_RES_MULTIPLIER ) ;
+ #ifdef PARTICLE_BENCH
+ // update() + render() per frame, for 4 - 256 particles spread over the strip.
+ // Scribbles over leds[]; the routine draws over it again on its next frame.
+ void particleBench() {
+   static ParticlePool<256> pool( PARTICLE_BOUNCE ) ;
+   for ( uint16_t n = 4 ; n <= 256 ; n *= 2 ) {
+     pool.clear() ;
+     for ( uint16_t i = 0 ; i < n ; i++ ) {
+       pool.emit( random16( numLeds * 256 ), random16( 512 ) - 256, CHSV( random8(), 255, 255 ) ) ;
+     }
+     uint32_t start = micros() ;
+     for ( uint8_t f = 0 ; f < 100 ; f++ ) {
+       pool.update( numLeds ) ;
+       pool.render( leds, numLeds ) ;
+     }
+     Serial.print( n ) ;
+     Serial.print( F(" particles ") ) ;
+     Serial.print( ( micros() - start ) / 100 ) ;
+     Serial.println( F(" us") ) ;
+   }
+ }
  #endif
 
- #ifdef RT_VUMETER
-   } else if ( strcmp(routines[ledMode], "vumeter") == 0 ) {
-     ldr.vuMeter() ;
-     taskLedModeSelect.setInterval( 8 * TASK_RES_MULTIPLIER) ;
- #endif
 
- #ifdef RT_FASTLOOP
-   } else if ( strcmp(routines[ledMode], "fastloop") == 0 ) {
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER) ;
-     ldr.fastLoop( false ) ;
- #endif
+ void ledModeSelect() {
+   #ifdef ESP8266
+     yield();
+   #endif
 
- #ifdef RT_FASTLOOP2
-   } else if ( strcmp(routines[ledMode], "fastloop2") == 0 ) {
-     ldr.fastLoop( true ) ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER) ;
- #endif
+ #ifdef FRAME_QUEUE_DEPTH
+   // Anything that changes what the queued frames should look like invalidates them
+   static byte lastMode = 255 ;
+   static float lastBPM = 0 ;
+   static uint8_t lastBrightness = 0 ;
+   if ( ledMode != lastMode || tapTempo.getBPM() != lastBPM || currentBrightness != lastBrightness ) {
+     frameQueue.clear() ;
+     lastMode = ledMode ;
+     lastBPM = tapTempo.getBPM() ;
+     lastBrightness = currentBrightness ;
+   }
 
- #ifdef RT_PENDULUM
-   } else if ( strcmp(routines[ledMode], "pendulum") == 0 ) {
-     ldr.pendulum() ;
-     taskLedModeSelect.setInterval( 1500 ) ; // needs a fast refresh rate
- #endif
+   if ( routineTable[ledMode].flags & BATCHABLE ) {
+     if ( frameQueue.full() ) return ;       // taskFrameOutput will make room
+
+     // Let the routine see its own interval again, not the fast refill one below
+     taskLedModeSelect.setInterval( frameQueue.getFrameInterval() * TASK_RES_MULTIPLIER ) ;
+     frameQueue.beginCapture() ;
+     renderLedMode( ldr, ledMode, taskLedModeSelect ) ;
+     frameQueue.endCapture() ;
+   #ifdef FRAME_CODEC_STATS
+     codecStats() ;
+   #endif
 
- #ifdef RT_BOUNCEBLEND
-   } else if ( strcmp(routines[ledMode], "bounceblend") == 0 ) {
-     ldr.bounceBlend() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
+     // The routine set its own frame interval; use it to stamp the next frame,
+     // and come back straight away to keep filling the queue.
+     frameQueue.setFrameInterval( taskLedModeSelect.getInterval() / TASK_RES_MULTIPLIER ) ;
+     taskLedModeSelect.setInterval( frameQueue.full() ? taskLedModeSelect.getInterval() : 1 * TASK_RES_MULTIPLIER ) ;
+     return ;
+   }
  #endif
 
- #ifdef RT_JUGGLE_PAL
-   } else if ( strcmp(routines[ledMode], "jugglepal") == 0 ) {
-     ldr.jugglePal() ;
-     taskLedModeSelect.setInterval( 150 ) ; // fast refresh rate needed to not skip any LEDs
+ #ifdef FRAME_GOVERNOR
+   // A new routine's first frame always goes out, at the routine's own rate
+   static byte governedMode = 255 ;
+   if ( ledMode != governedMode ) {
+     governor.reset() ;
+     governedMode = ledMode ;
+   }
  #endif
 
- #ifdef RT_NOISE_LAVA
-   } else if ( strcmp(routines[ledMode], "noise_lava") == 0 ) {
-     if( tapTempo.getBPM() > 50 ) {
-       ldr.fillnoise8( 0, beatsin8( tapTempo.getBPM(), 1, 25), 30, 1); // pallette, speed, scale, loop
-     } else {
-       ldr.fillnoise8( 0, 1, 30, 1); // pallette, speed, scale, loop
-     }
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
+   renderLedMode( ldr, ledMode, taskLedModeSelect ) ;
+ #ifdef FRAME_CODEC_STATS
+   codecStats() ;
+ #endif
+ #ifdef FRAME_GOVERNOR
+   governFrame() ;
  #endif
+ }
+
+ #ifdef STRIPS_SEGMENTS
+ // Routines keep their state in function statics, which every LEDRoutines shares,
+ // so two segments drawing with one method would move it on twice a frame. The
+ // catalog gives such routines a common stem, the part of the name before the
+ // first '_' or digit ("twirl2o", "pulse5_1"); routineFamily[] is the first
+ // routine with each one's stem.
+ byte routineFamily[NUMROUTINES] ;
+
+ uint8_t stemLength( const char* name ) {
+   uint8_t n = 0 ;
+   while ( name[n] && name[n] != '_' && ( name[n] < '0' || name[n] > '9' ) ) n++ ;
+   return n ;
+ }
 
- #ifdef RT_NOISE_PARTY
-   } else if ( strcmp(routines[ledMode], "noise_party") == 0 ) {
-     if( tapTempo.getBPM() > 50 ) {
-       ldr.fillnoise8( 1, beatsin8( tapTempo.getBPM(), 1, 25), 30, 1); // pallette, speed, scale, loop
-     } else {
-       ldr.fillnoise8( 1, 1, 30, 1); // pallette, speed, scale, loop
+ void findRoutineFamilies() {
+   for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+     uint8_t n = stemLength( routineTable[i].name ) ;
+     routineFamily[i] = i ;
+     for ( uint8_t j = 0 ; j < i ; j++ ) {
+       if ( stemLength( routineTable[j].name ) == n && strncmp( routineTable[j].name, routineTable[i].name, n ) == 0 ) {
+         routineFamily[i] = j ;
+         break ;
+       }
      }
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+   }
+ }
 
- #ifdef RT_NOISE_OCEAN
-   } else if ( strcmp(routines[ledMode], "noise_ocean") == 0 ) {
-     ldr.fillnoise8( 2, beatsin8( tapTempo.getBPM(), 1, 25), 30, 1); // pallette, speed, scale, loop
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+ // The first segment other than 'seg' that shows 'mode' or a routine of its family, or NUM_STRIPS
+ uint8_t segmentShowing( byte mode, uint8_t seg ) {
+   if ( seg != 0 && routineFamily[ledMode] == routineFamily[mode] ) return 0 ;
+   for ( uint8_t i = 1 ; i < NUM_STRIPS ; i++ ) {
+     if ( i != seg && routineFamily[segmentMode[i - 1]] == routineFamily[mode] ) return i ;
+   }
+   return NUM_STRIPS ;
+ }
 
+ // The first routine after segment 0's that the segments before 'seg' leave free
+ byte segmentStartMode( uint8_t seg ) {
+   byte mode = ledMode ;
+   for ( uint8_t n = 0 ; n < NUMROUTINES ; n++ ) {
+     mode = ( mode + 1 ) % NUMROUTINES ;
+     if ( segmentShowing( mode, seg ) >= seg ) break ;
+   }
+   return mode ;
+ }
 
- #ifdef RT_QUAD_STROBE
-   } else if ( strcmp(routines[ledMode], "quadstrobe") == 0 ) {
-     ldr.quadStrobe();
-     taskLedModeSelect.setInterval( (60000 / (tapTempo.getBPM() * 4)) * TASK_RES_MULTIPLIER ) ;
- #endif
+ void segmentSelect() {
+   uint8_t i = &runner.currentTask() - segmentTask ;   // Task ids need _TASK_WDT_IDS
+   // "seg" won't double up a routine, but the button and playlist move segment 0
+   // wherever they like: the lower segment keeps the routine, this one goes dark
+   if ( segmentShowing( segmentMode[i], i + 1 ) <= i ) {
+     fill_solid( segmentLdr[i]._leds, segmentLdr[i]._numLeds, CRGB::Black ) ;
+     segmentLdr[i].show() ;
+     segmentTask[i].setInterval( LEDMODE_SELECT_DEFAULT_INTERVAL ) ;
+     return ;
+   }
+   renderLedMode( segmentLdr[i], segmentMode[i], segmentTask[i] ) ;
+ }
 
- #ifdef RT_PULSE_3
-   } else if ( strcmp(routines[ledMode], "pulse3") == 0 ) {
-     ldr.pulse3();
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
+ // Each segment goes out at the brightness its own routine drew it with, in its strip's
+ // correction, and all strips in one FastLED.show(). The power limit takes leds[] as if
+ // every segment were as bright as the brightest one, and scales them all down alike.
+ void stripFlush() {
+   uint8_t bright[NUM_STRIPS] ;
+   uint8_t top = 0 ;
+   for ( uint8_t s = 0 ; s < NUM_STRIPS ; s++ ) {
+     bright[s] = streaming ? FastLED.getBrightness() : s ? segmentLdr[s - 1]._brightness : ldr._brightness ;
+     top = max( top, bright[s] ) ;
+   }
+   uint8_t limited = top ;
+ #ifdef POWER_BUDGET_MA
+   limited = power.limit( leds, top ) ;
  #endif
-
- #ifdef RT_PULSE_5_1
-   } else if ( strcmp(routines[ledMode], "pulse5_1") == 0 ) {
-     ldr.pulse5(1, true);
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
+   for ( uint8_t s = 0 ; s < NUM_STRIPS ; s++ ) {
+     stripCorrection( s, scale8( stripBrightness[s], top ? bright[s] * limited / top : 0 ) ) ;
+   }
+   FastLED.show( 255 ) ;
+ }
  #endif
 
- #ifdef RT_PULSE_5_2
-   } else if ( strcmp(routines[ledMode], "pulse5_2") == 0 ) {
-     ldr.pulse5(2, true);
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
 
- #ifdef RT_PULSE_5_3
-   } else if ( strcmp(routines[ledMode], "pulse5_3") == 0 ) {
-     ldr.pulse5(3, true);
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+ // Draws one frame of 'ledMode' with 'ldr', and sets the frame interval on
+ // 'taskLedModeSelect'. Segment 0 passes the globals of the same names.
+ void renderLedMode( LEDRoutines& ldr, byte ledMode, Task& taskLedModeSelect ) {
+   const Routine& routine = routineTable[ledMode] ;
+   ldr.beginFrame() ;
+   routine.draw( ldr, taskLedModeSelect ) ;
+   if ( routine.interval != OWN_INTERVAL ) {
+     taskLedModeSelect.setInterval( routine.interval ) ;
+   }
+ }
 
- #ifdef RT_THREE_SIN_PAL
-   } else if ( strcmp(routines[ledMode], "tsp") == 0 ) {
-     ldr.threeSinPal() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
 
- #ifdef RT_COLOR_GLOW
-   } else if ( strcmp(routines[ledMode], "color_glow") == 0 ) {
-     ldr.colorGlow() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+// ==================================================================== //
+// ========================= Serial commands ========================== //
+// ==================================================================== //
 
- #ifdef RT_FAN_WIPE
-   } else if ( strcmp(routines[ledMode], "fan_wipe") == 0 ) {
-     ldr.fanWipe() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+void setBrightness( int brightness ) {
+  currentBrightness = constrain( brightness, 0, MAX_BRIGHTNESS ) ;
+  FastLED.setBrightness( currentBrightness ) ;
+}
 
- #ifdef RT_DROPLETS
- } else if ( strcmp(routines[ledMode], "droplets") == 0 ) {
-     ldr.droplets() ;
-     taskLedModeSelect.setInterval( 30 * TASK_RES_MULTIPLIER ) ;
+#if NUM_STRIPS > 1
+// Scales the strip's colour correction, so every strip still goes out in the same FastLED.show()
+void stripCorrection( uint8_t strip, uint8_t brightness ) {
+ #ifdef COLOR_LUT
+  CRGB correction = CRGB( UncorrectedColor ) ;   // white balance is in the LUT
+ #else
+  CRGB correction = CRGB( TypicalLEDStrip ) ;
  #endif
+  FastLED[strip].setCorrection( correction.nscale8( brightness ) ) ;
+}
 
- #ifdef RT_BOUNCYBALLS
- } else if ( strcmp(routines[ledMode], "bouncyballs") == 0 ) {
-     ldr.bouncyBalls() ;
-     taskLedModeSelect.setInterval( 30 * TASK_RES_MULTIPLIER ) ;
+void setStripBrightness( uint8_t strip, uint8_t brightness ) {
+  stripBrightness[strip] = brightness ;
+ #ifndef STRIPS_SEGMENTS
+  stripCorrection( strip, brightness ) ;   // with segments stripFlush() does, every frame
  #endif
+}
+#endif
 
- #ifdef RT_DROPLETS2
- } else if ( strcmp(routines[ledMode], "droplets2") == 0 ) {
-     ldr.droplets2() ;
-     taskLedModeSelect.setInterval( 10 * TASK_RES_MULTIPLIER ) ;
- #endif
+// Routine index from a name or a number, -1 if there is no such routine
+int findRoutine( const char* arg ) {
+  for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+    if ( strcmp(routineTable[i].name, arg) == 0 ) return i ;
+  }
+  if ( *arg < '0' || *arg > '9' || (uint8_t) atoi(arg) >= NUMROUTINES ) return -1 ;
+  return atoi(arg) ;
+}
 
- #ifdef RT_CIRC_LOADER
- } else if ( strcmp(routines[ledMode], "circloader") == 0 ) {
-     ldr.circularLoader() ;
-     taskLedModeSelect.setInterval( 50 * TASK_RES_MULTIPLIER ) ;
- #endif
+#ifdef FRAME_CHECK
+// Runs 'mode' for 'frames' frames on the check clock and prints "name hash";
+// with 'dump' every frame as hex as well, for tools/framecheck.py to compare
+// routines that are allowed to come out slightly different.
+void checkRoutine( uint8_t mode, uint32_t frames, bool dump ) {
+  float bpm = tapTempo.getBPM() ;
+  tapTempo.setBPM( DEFAULT_BPM ) ;
+
+  frameCheck.begin() ;
+  ldr._osc.reset( ldr.now() ) ;   // the oscillators' phases would differ between runs too
+  ldr._palettes.restart( ldr.now() ) ;   // and so would the point in the palette sequence
+  #ifdef ZONES
+  zoneRunner.restart( ldr.now() ) ;      // zones were due on the real clock
+  #endif
+  for ( uint32_t f = 0 ; f < frames ; f++ ) {
+  #ifdef ESP8266
+    yield() ; // Pat the ESP watchdog
+  #endif
+    renderLedMode( ldr, mode, taskLedModeSelect ) ;
+    frameCheck.frame( leds, NUM_LEDS, ldr._brightness, taskLedModeSelect.getInterval() / TASK_RES_MULTIPLIER ) ;
+    if ( dump ) {
+      for ( uint16_t i = 0 ; i < NUM_LEDS ; i++ ) {
+        for ( uint8_t c = 0 ; c < 3 ; c++ ) {
+          if ( leds[i][c] < 0x10 ) Serial.print( '0' ) ;
+          Serial.print( leds[i][c], HEX ) ;
+        }
+      }
+      Serial.println() ;
+    }
+  }
+  frameCheck.end() ;
+#ifdef FRAME_GOVERNOR
+  governor.reset() ;      // the check's frames went through show() too
+#endif
 
- #ifdef RT_RIPPLE
- } else if ( strcmp(routines[ledMode], "ripple") == 0 ) {
-     ldr.ripple() ;
-     taskLedModeSelect.setInterval( 100 * TASK_RES_MULTIPLIER ) ;
- #endif
+  tapTempo.setBPM( bpm ) ;
+  Serial.print( routineTable[mode].name ) ;
+  Serial.print( ' ' ) ;
+  Serial.println( frameCheck.hash(), HEX ) ;
+}
+#endif
 
- #ifdef RT_RANDOMWALK
- } else if ( strcmp(routines[ledMode], "randomwalk") == 0 ) {
-     ldr.randomWalk() ;
-     taskLedModeSelect.setInterval( 5 * TASK_RES_MULTIPLIER ) ;
- #endif
+// "2 fire2012" -> 2, and 'arg' moved on to "fire2012"
+uint8_t splitIndex( const char*& arg ) {
+  uint8_t index = atoi(arg) ;
+  while ( *arg && *arg != ' ' ) arg++ ;
+  while ( *arg == ' ' ) arg++ ;
+  return index ;
+}
 
- #ifdef RT_FASTLOOP3
- } else if ( strcmp(routines[ledMode], "fastloop3") == 0 ) {
-     ldr.fastLoop3() ;
-     taskLedModeSelect.setInterval( 15 * TASK_RES_MULTIPLIER ) ;
- #endif
+void startStreaming() {
+  if ( ! streaming ) {
+    streaming = true ;
+    taskLedModeSelect.disable() ;   // stop the local routine drawing into leds[]
+    #ifdef STRIPS_SEGMENTS
+    for ( uint8_t i = 0 ; i < NUM_STRIPS - 1 ; i++ ) segmentTask[i].disable() ;
+    #endif
+    #ifdef FRAME_QUEUE_DEPTH
+    frameQueue.clear() ;
+    #endif
+  }
+  taskStreamTimeout.restartDelayed() ;
+}
 
+void stopStreaming() {
+  streaming = false ;
+  taskLedModeSelect.enable() ;      // host went quiet: back to the local routine
+  #ifdef STRIPS_SEGMENTS
+  for ( uint8_t i = 0 ; i < NUM_STRIPS - 1 ; i++ ) segmentTask[i].enable() ;
+  #endif
+  #ifdef FRAME_GOVERNOR
+  governor.reset() ;                // its first frame must replace the streamed one
+  #endif
+}
+
+// Frames are received into streamBuffer, not leds[]: the dither task re-sends leds[]
+// between frames, so anything written there would be shown half received, or failing
+// its CRC. onSerialCommand() copies or decodes a frame into leds[] once it checks out,
+// and only then starts streaming; this just says where the bytes go.
+uint8_t* serialPayloadSink( uint8_t cmd, uint16_t len ) {
+  if ( cmd == SC_CMD_FRAME && len == NUM_LEDS * sizeof(CRGB) ) return streamBuffer ;
+  if ( cmd == SC_CMD_FRAME_CODED && len <= FRAME_CODEC_BUFFER ) return streamBuffer ;
+  return NULL ;
+}
 
- #ifdef RT_POVPATTERNS
- } else if ( strcmp(routines[ledMode], "povpatterns") == 0 ) {
-   #define width(array) sizeof(array) / sizeof(array[0])
-   DEBUG_PRINTLN( "." ) ;
+// If a newer frame of about the same size is already waiting we're behind: skip show() and catch up
+uint8_t showStreamFrame( uint16_t len ) {
+  if ( Serial.available() >= (int) len ) {
+    streamFramesLate++ ;
+    return SC_OK ;
+  }
+  ldr._brightness = FastLED.getBrightness() ;   // not whatever the last routine drew with
+  ldr.show() ;      // through the power limiter like everything else
+  streamFramesShown++ ;
+  return SC_OK ;
+}
 
-     ldr.povPatterns(30, Image, width(Image));
-     taskLedModeSelect.setInterval( 30000 ) ; // microseconds ; fast needed for POV patterns
+uint8_t onSerialCommand( uint8_t cmd, const uint8_t* payload, uint16_t len ) {
+  switch ( cmd ) {
+    case SC_CMD_SET_MODE:
+      if ( len != 1 ) return SC_ERR_LENGTH ;
+      if ( payload[0] >= NUMROUTINES ) return SC_ERR_ARGUMENT ;
+      ledMode = payload[0] ;
+      return SC_OK ;
+
+    case SC_CMD_SET_BPM:
+      if ( len != 2 ) return SC_ERR_LENGTH ;
+      tapTempo.setBPM( ( payload[0] | ( payload[1] << 8 ) ) / 10.0 ) ;
+      return SC_OK ;
+
+    case SC_CMD_SET_BRIGHTNESS:
+      if ( len != 1 ) return SC_ERR_LENGTH ;
+      setBrightness( payload[0] ) ;
+      return SC_OK ;
+
+    case SC_CMD_PALETTE:
+      if ( len != 16 * 3 ) return SC_ERR_LENGTH ;
+      ldr.setUserPalette( payload ) ;
+      #ifdef FRAME_QUEUE_DEPTH
+      frameQueue.clear() ;
+      #endif
+      return SC_OK ;
+
+    case SC_CMD_FRAME:
+      if ( len != NUM_LEDS * sizeof(CRGB) ) return SC_ERR_LENGTH ;
+      startStreaming() ;
+      memcpy( leds, payload, len ) ;
+      return showStreamFrame( len ) ;
+
+    case SC_CMD_FRAME_CODED:
+      if ( len > FRAME_CODEC_BUFFER ) return SC_ERR_LENGTH ;
+      // On error leds[] is untouched; the host should follow up with a frame that isn't a delta
+      if ( ! FrameCodec::decode( payload, len, (uint8_t*) leds, NUM_LEDS ) ) return SC_ERR_ARGUMENT ;
+      startStreaming() ;
+      return showStreamFrame( len ) ;
+
+ #ifdef PLAYLIST_EEPROM
+    case SC_CMD_PLAYLIST:
+      if ( len < 2 ) return SC_ERR_LENGTH ;
+      if ( ! playlist.writeEeprom( payload[0] | ( payload[1] << 8 ), payload + 2, len - 2 ) ) return SC_ERR_ARGUMENT ;
+      startPlaylist() ;   // plays as soon as the last chunk makes the crc match
+      return SC_OK ;
  #endif
+  }
+  return SC_ERR_COMMAND ;
+}
 
- #ifdef RT_BLACK
-   } else if ( strcmp(routines[ledMode], "black") == 0 ) {
-     ldr.fill_solid(leds, NUM_LEDS, CRGB::Black);
-     FastLED.show();
-     taskLedModeSelect.setInterval( 500 * TASK_RES_MULTIPLIER ) ;  // long because nothing is going on anyways.
+bool onSerialText( const char* name, const char* arg ) {
+  if ( strcmp(name, "mode") == 0 ) {
+    int mode = findRoutine( arg ) ;
+    if ( mode < 0 ) return false ;
+    ledMode = mode ;
+    return true ;
+
+ #ifdef STRIPS_SEGMENTS
+  } else if ( strcmp(name, "seg") == 0 ) {
+    // "seg 2 fire2012"; "seg 0 ..." is the same as "mode"
+    uint8_t seg = splitIndex( arg ) ;
+    int mode = findRoutine( arg ) ;
+    if ( seg >= NUM_STRIPS || mode < 0 ) return false ;
+    if ( segmentShowing( mode, seg ) < NUM_STRIPS ) return false ;   // one segment per routine family
+    if ( seg == 0 ) ledMode = mode ;
+    else segmentMode[seg - 1] = mode ;
+    return true ;
+ #endif
+
+ #if NUM_STRIPS > 1
+  } else if ( strcmp(name, "strip") == 0 ) {
+    // "strip 1 128": half as bright as the others; "strip 1" prints it
+    uint8_t strip = splitIndex( arg ) ;
+    if ( strip >= NUM_STRIPS ) return false ;
+    if ( *arg ) setStripBrightness( strip, constrain( atoi(arg), 0, 255 ) ) ;
+    Serial.println( stripBrightness[strip] ) ;
+    return true ;
+ #endif
+
+  } else if ( strcmp(name, "bpm") == 0 && *arg ) {
+    tapTempo.setBPM( atof(arg) ) ;
+    return true ;
+
+  } else if ( strcmp(name, "bright") == 0 && *arg ) {
+    setBrightness( atoi(arg) ) ;
+    return true ;
+
+  } else if ( strcmp(name, "stats") == 0 ) {
+    Serial.print( F("shown ") ) ;
+    Serial.print( streamFramesShown ) ;
+    Serial.print( F(" late ") ) ;
+    Serial.print( streamFramesLate ) ;
+    Serial.print( F(" crc ") ) ;
+    Serial.print( serialCmd.getCrcErrors() ) ;
+    Serial.print( F(" timeout ") ) ;
+    Serial.println( serialCmd.getTimeouts() ) ;
+  #ifdef TEMPORAL_DITHER
+    Serial.print( F("dither ") ) ;
+    Serial.print( dither.lastMicros() ) ;
+    Serial.println( F(" us") ) ;
+  #endif
+    return true ;
+
+ #ifdef POWER_BUDGET_MA
+  } else if ( strcmp(name, "power") == 0 ) {
+    if ( *arg ) power.setBudget( atoi(arg) / POWER_COPIES ) ;
+    Serial.print( power.lastMa() * POWER_COPIES ) ;
+    Serial.print( F(" mA of ") ) ;
+    Serial.println( power.getBudget() * POWER_COPIES ) ;
+  #ifdef POWER_BATTERY_PIN
+    Serial.print( F("battery ") ) ;
+    Serial.print( power.batteryMv() ) ;
+    Serial.println( F(" mV") ) ;
+  #endif
+    return true ;
+ #endif
+
+ #ifdef IDLE_SLEEP
+  } else if ( strcmp(name, "duty") == 0 ) {
+    printDuty() ;
+    return true ;
+ #endif
+
+ #ifdef FRAME_GOVERNOR
+  } else if ( strcmp(name, "governor") == 0 ) {
+    printGovernor() ;
+    return true ;
+ #endif
+
+ #ifdef FRAME_CHECK
+  } else if ( strcmp(name, "check") == 0 ) {
+    // "check 100": every routine for 100 frames; "check fire2012 100"; "check fire2012 100 dump".
+    // The clock is virtual, so "check tsp 2880000" is 8 hours of 10 ms frames in as long as it takes to draw them.
+    int mode = -1 ;   // all of them
+    if ( *arg && ( *arg < '0' || *arg > '9' ) ) {
+      char routine[SC_MAX_LINE] ;
+      uint8_t len = 0 ;
+      while ( arg[len] && arg[len] != ' ' ) { routine[len] = arg[len] ; len++ ; }
+      routine[len] = 0 ;
+      mode = findRoutine( routine ) ;
+      if ( mode < 0 ) return false ;
+      arg += len ;
+      while ( *arg == ' ' ) arg++ ;
+    }
+    uint32_t frames = *arg ? strtoul( arg, NULL, 10 ) : 100 ;
+    bool dump = strstr( arg, "dump" ) != NULL ;
+    if ( ! frames ) return false ;
+    for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+      if ( mode < 0 || mode == i ) checkRoutine( i, frames, dump ) ;
+    }
+    return true ;
+ #endif
+
+ #ifdef FRAME_CODEC_STATS
+  } else if ( strcmp(name, "codec") == 0 ) {
+    printCodecStats() ;
+    return true ;
+ #endif
+
+ #ifdef AUDIO_PIN
+  } else if ( strcmp(name, "audio") == 0 ) {
+    for ( uint8_t b = 0 ; b < AUDIO_BANDS ; b++ ) {
+      Serial.print( audio.level(b) ) ;
+      Serial.print( ' ' ) ;
+    }
+    Serial.print( F("vol ") ) ;
+    Serial.println( audio.volume() ) ;
+    Serial.print( audio.lastMicros() ) ;
+    Serial.print( F(" us/block, ") ) ;
+    Serial.print( audio.lastMicros() * ( F_CPU / 1000000 ) ) ;
+    Serial.print( F(" cycles, dropped ") ) ;
+    Serial.println( audio.droppedBlocks() ) ;
+    return true ;
+ #endif
+
+ #ifdef PARTICLE_BENCH
+  } else if ( strcmp(name, "particles") == 0 ) {
+    particleBench() ;
+    return true ;
  #endif
+  }
+  return false ;
+}
 
-   }
- }
+
+#ifdef TEMPORAL_DITHER
+void ditherRefresh() {
+  dither.refresh() ;
+}
+#endif
+
+#if defined(POWER_BUDGET_MA) && defined(POWER_BATTERY_PIN)
+void checkBattery() {
+  power.updateBattery() ;
+}
+#endif
+
+#ifdef USE_PLAYLIST
+// ==================================================================== //
+// ============================= Playlist ============================= //
+// ==================================================================== //
+
+// Indexed by PLAYLIST_PALETTE_*
+const TProgmemRGBPalette16* const playlistPalettes[PLAYLIST_NUM_PALETTES] = {
+  &RainbowColors_p, &RainbowStripeColors_p, &CloudColors_p, &PartyColors_p,
+  &OceanColors_p, &LavaColors_p, &ForestColors_p, &HeatColors_p
+} ;
+
+// CRC-16 over the routine names in table order, as tools/playlist.py works it out
+// from the board header: lists compiled for another catalog aren't played
+uint16_t catalogHash() {
+  uint16_t crc = 0xFFFF ;
+  for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+    const char* c = routineTable[i].name ;
+    do crc = SerialCommand::crc16( crc, *c ) ; while ( *c++ ) ;
+  }
+  return crc ;
+}
+
+// An EEPROM list (uploaded over serial) wins over the one compiled in
+void startPlaylist() {
+  bool ok = false ;
+#ifdef PLAYLIST_EEPROM
+  ok = playlist.beginEeprom( catalogHash() ) ;
+#endif
+#ifdef PLAYLIST
+  if ( ! ok ) ok = playlist.beginFlash( PlaylistData, catalogHash() ) ;
+#endif
+  playlistRemaining = 0 ;   // start at the top on the next tick
+  DEBUG_PRINT( F("Playlist entries: ") ) ;
+  DEBUG_PRINTLN( playlist.count() ) ;
+}
+
+void applyPlaylistEntry( const PlaylistEntry& entry ) {
+  if ( entry.routine < NUMROUTINES ) ledMode = entry.routine ;
+  if ( entry.bpm ) tapTempo.setBPM( entry.bpm / 10.0 ) ;
+  if ( entry.palette < PLAYLIST_NUM_PALETTES ) ldr.setUserPalette( *playlistPalettes[entry.palette] ) ;
+  if ( entry.brightness ) setBrightness( entry.brightness ) ;
+}
+
+// Runs every second; moves on when the current entry has had its time
+void playlistTick() {
+  if ( playlistRemaining && --playlistRemaining ) return ;
+  if ( ! playlist.next( playlistNext ) ) return ;   // no (valid) list: leave things as they are
+
+  playlistRemaining = playlistNext.duration ;
+  if ( playlistNext.transition ) {
+    // Half the transition time down to black, half back up; 20ms steps
+    playlistFadeStep = max( 1, 102 / playlistNext.transition ) ;
+    playlistFadingOut = true ;
+    taskPlaylistFade.enable() ;
+  } else {
+    applyPlaylistEntry( playlistNext ) ;
+  }
+}
+
+void playlistFadeTick() {
+  if ( playlistFadingOut ) {
+    playlistFade = qsub8( playlistFade, playlistFadeStep ) ;
+    if ( ! playlistFade ) {
+      applyPlaylistEntry( playlistNext ) ;
+      playlistFadingOut = false ;
+    }
+  } else {
+    playlistFade = qadd8( playlistFade, playlistFadeStep ) ;
+    if ( playlistFade == 255 ) taskPlaylistFade.disable() ;
+  }
+  ldr.setFade( playlistFade ) ;
+}
+#elif defined(AUTOADVANCE)
+void autoAdvanceLedMode() {
+  ledMode = ( ledMode + 1 ) % NUMROUTINES ;
+}
+#endif
+
+#ifdef BUTTON_PIN
+// Long press: a quarter of MAX_BRIGHTNESS brighter, back to the first step after full
+void cycleBrightness() {
+  uint8_t step = MAX_BRIGHTNESS / 4 ;
+  setBrightness( currentBrightness + step > MAX_BRIGHTNESS ? step : currentBrightness + step ) ;
+}
+
+// Mode button: short = next routine, double = previous one, long = brightness.
+// BPM button: tap tempo.
+void onButton( ButtonEvent event, uint32_t atMicros ) {
+  static uint32_t chainStart ;   // micros() of the first tap of this chain
+  static uint8_t chainTaps ;
+
+  switch ( event ) {
+    case BUTTON_SHORT:
+      ledMode = ( ledMode + 1 ) % NUMROUTINES ;
+      break ;
+    case BUTTON_DOUBLE:
+      ledMode = ( ledMode + NUMROUTINES - 1 ) % NUMROUTINES ;
+      break ;
+    case BUTTON_LONG:
+      cycleBrightness() ;
+      break ;
+    case BUTTON_TAP: {
+      // ArduinoTapTempo takes the tap as happening now, which sets the beat
+      // phase to within one loop(); the beat length comes from the edge times.
+      bool chained = tapTempo.isChainActive() ;
+      tapTempo.update( true ) ;
+      tapTempo.update( false ) ;
+      if ( ! chained ) {
+        chainStart = atMicros ;
+        chainTaps = 0 ;
+      } else if ( chainTaps < 255 ) {
+        chainTaps++ ;
+        tapTempo.setBeatLength( ( atMicros - chainStart ) / chainTaps / 1000 ) ;
+      }
+      break ;
+    }
+  }
+}
+#endif
@@ -16,6 +16,8 @@
 #define DEFAULT_BPM 120
 #define USING_MPU
 // #define AUTOADVANCE
+//#define IDLE_SLEEP   // ARM only: delay() on the ESP8266 doesn't stop the CPU, so it would save nothing
+#define FRAME_GOVERNOR // don't redraw and resend frames nobody can tell apart; "governor" over serial shows the savings
 
 // ---- Patterns ----
 #define RT_P_RB_STRIPE
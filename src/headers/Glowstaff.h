@@ -5,9 +5,17 @@
 #define APA_102
 #define MY_DATA_PIN 11
 #define MY_CLOCK_PIN 13
+//#define APA102_HD  // instead of TEMPORAL_DITHER: more resolution at low brightness, no refresh cost
 #define NUM_LEDS 139
+#define LAYOUT_STAFF
 #define DEFAULT_BRIGHTNESS 10
 #define MAX_BRIGHTNESS 100  // 278 LEDs use a LOT of power (measured max 5A)
+//#define NUM_STRIPS 2                // each side of the staff on its own data line...
+//#define STRIPS_MIRROR               // ...both showing leds[]
+//#define STRIP2_DATA_PIN 21
+//#define STRIP2_CLOCK_PIN 20
+//#define POWER_BUDGET_MA 2000        // counts NUM_LEDS; both sides of the staff show leds[], so this is half the supply (the whole supply with STRIPS_MIRROR)
+//#define POWER_BATTERY_PIN A0        // scale the budget down as the battery runs flat
 
 // ---- Buttons ----
 #define BUTTON_PIN 14
@@ -18,6 +26,13 @@
 #define DEFAULT_BPM 60
 // #define USING_MPU
 //#define AUTOADVANCE
+//#define FRAME_QUEUE_DEPTH 3          // render palette/tsp frames ahead for smoother output; RAM: 3 * NUM_LEDS * 3 bytes
+//#define USE_GET_MILLISECOND_TIMER    // needed with FRAME_QUEUE_DEPTH and FRAME_CHECK
+//#define FRAME_CHECK                  // "check" serial command: hashes of every routine's frames, see tools/framecheck.py
+//#define TEMPORAL_DITHER              // smooth fades at DEFAULT_BRIGHTNESS 10; not tried on the staff yet
+//#define COLOR_LUT                    // gamma 2.2 + white balance at output, see ColorLut.h
+//#define COLOR_LUT_FUSED              // ...with brightness folded into a RAM copy (plain FastLED output only)
+//#define AUDIO_PIN A1                 // electret mic + amp biased at half supply; with RT_VUMETER, "audio" over serial for levels
 
 // ---- MPU Calibration ----
 #define X_ACCEL_OFFSET  -235
@@ -30,11 +45,13 @@
 
 // ---- Patterns ----
 #define RT_P_RB_STRIPE
+#define RT_P_USER        // palette uploaded over serial
 #define RT_P_OCEAN
 #define RT_P_HEAT
 #define RT_P_LAVA
 #define RT_P_PARTY
 #define RT_P_FOREST
+//#define RT_P_SEQUENCE    // the palettes tsp cycles through, fading into each other
 #define RT_TWIRL1
 #define RT_TWIRL2
 #define RT_TWIRL4
@@ -52,6 +69,7 @@
 #define RT_JUGGLE_PAL
 #define RT_NOISE_LAVA
 #define RT_NOISE_PARTY
+//#define RT_NOISE_SEQUENCE
 #define RT_PULSE_5_1
 #define RT_PULSE_5_2
 #define RT_PULSE_5_3
@@ -4,6 +4,7 @@
 // ---- LED stuff ----
 #define APA_102
 #define NUM_LEDS 87
+#define LAYOUT_RING
 #define MY_DATA_PIN PIN_SPI_MOSI
 #define MY_CLOCK_PIN PIN_SPI_SCK
 // #define MY_DATA_PIN 7
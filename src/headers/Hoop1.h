@@ -4,6 +4,7 @@
 // ---- LED stuff ----
 #define APA_102_SLOW
 #define NUM_LEDS 87
+#define LAYOUT_RING
 #define MY_DATA_PIN PIN_SPI_MOSI
 #define MY_CLOCK_PIN PIN_SPI_SCK
 // #define MY_DATA_PIN 7
@@ -21,6 +22,18 @@
 // ---- Misc ----
 #define DEFAULT_BPM 120
 #define AUTOADVANCE
+// A playlist replaces AUTOADVANCE; regenerate with
+// tools/playlist.py compile playlists/Hoop1.txt --board src/headers/Hoop1.h -o src/headers/playlists/Hoop1.h
+//#define PLAYLIST "playlists/Hoop1.h"
+
+// Two fires from the bottom of the hoop up both sides, with lava scrolling along the top
+// (#if 1 to use them; commented out with // the backslashes would continue the comment):
+#if 0
+#define ZONES \
+  ZONE( left,  FireEffect<30>, ( 60, 90 ),  0, 30,  1 ) \
+  ZONE( right, FireEffect<30>, ( 60, 90 ), 86, 30, -1 ) \
+  ZONE( top,   PaletteEffect,  ( LavaColors_p, 3, 1, 30 ), 30, 27, 1 )
+#endif
 
 // ---- Patterns ----
 #define RT_P_RB_STRIPE
@@ -4,8 +4,10 @@
 // ---- LED stuff ----
 #define APA_102
 #define NUM_LEDS 45
+#define LAYOUT_RING
 #define MY_DATA_PIN 11
 #define MY_CLOCK_PIN 13
+//#define APA102_HD  // brightness through the per-pixel current field, see Apa102Hd.h; not tried on the prop yet
 
 #define DEFAULT_BRIGHTNESS 150
 #define MAX_BRIGHTNESS 150
@@ -17,6 +17,20 @@
 #define DEFAULT_BPM 30
 #define AUTOADVANCE
 
+// ---- Zones ----
+// 8 ribs of 8 LEDs, wired from the centre out; the outer LED of each rib is the rim.
+// The "zones" routine burns fire up every rib and sparkles the rim, see Effects.h
+#define ZONES \
+  ZONE( rib0, FireEffect<7>, ( 75, 70 ),  0, 7, 1 ) \
+  ZONE( rib1, FireEffect<7>, ( 75, 70 ),  8, 7, 1 ) \
+  ZONE( rib2, FireEffect<7>, ( 75, 70 ), 16, 7, 1 ) \
+  ZONE( rib3, FireEffect<7>, ( 75, 70 ), 24, 7, 1 ) \
+  ZONE( rib4, FireEffect<7>, ( 75, 70 ), 32, 7, 1 ) \
+  ZONE( rib5, FireEffect<7>, ( 75, 70 ), 40, 7, 1 ) \
+  ZONE( rib6, FireEffect<7>, ( 75, 70 ), 48, 7, 1 ) \
+  ZONE( rib7, FireEffect<7>, ( 75, 70 ), 56, 7, 1 ) \
+  ZONE( rim,  GlitterEffect, ( 80, 40 ),  7, 8, 8 )
+
 
 
 // ---- Patterns ----
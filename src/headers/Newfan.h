@@ -5,9 +5,13 @@
 #define APA_102
 #define MY_DATA_PIN 11  /// DATA_PIN and CLOCK_PIN are reserved.
 #define MY_CLOCK_PIN 13
+//#define APA102_HD  // brightness through the per-pixel current field, see Apa102Hd.h; not tried on the prop yet
 #define NUM_LEDS 72
 #define DEFAULT_BRIGHTNESS 40
 #define MAX_BRIGHTNESS 70
+#define LAYOUT_FAN
+#define NUM_BLADES 12      // 72 LEDs = 12 blades of 6
+#define LEDS_PER_BLADE 6
 
 // ---- Buttons ----
 #define BUTTON_PIN 9
@@ -17,6 +21,7 @@
 // ---- Misc ----
 #define DEFAULT_BPM 120
 //#define USING_MPU
+//#define TEMPORAL_DITHER             // smoother fades at low brightness, see DitherOutput.h
 
 // ---- MPU Calibration ----
 #define X_ACCEL_OFFSET  410
@@ -29,6 +34,7 @@
 
 // ---- Patterns ----
 #define RT_P_RB_STRIPE
+#define RT_P_USER        // palette uploaded over serial
 #define RT_P_OCEAN
 #define RT_P_HEAT
 #define RT_P_LAVA
@@ -57,7 +63,7 @@
 #define RT_THREE_SIN_PAL
 #define RT_COLOR_GLOW
 #define RT_FAN_WIPE
-#define NUM_BLADES 14
+#define NOISE_OCTAVES 2  // noise_* patterns: each octave adds detail and one more pass over the LEDs
 // --- MPU Patterns ----
 #ifdef USING_MPU
 #define RT_SHAKE_IT
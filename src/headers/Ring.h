@@ -5,6 +5,7 @@
 #define NEO_PIXEL
 #define LED_PIN     17   // which pin your Neopixels are connected to
 #define NUM_LEDS 64
+#define LAYOUT_RING
 #define DEFAULT_BRIGHTNESS 50
 #define MAX_BRIGHTNESS 60
 
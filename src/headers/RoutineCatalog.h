@@ -0,0 +1,213 @@
+// The routines, in mode order: one entry per routine gives its name (for the
+// serial "mode" command and tools/playlist.py), the task interval to use
+// after each frame, flags, and the call that draws the frame.
+//
+//   ROUTINE( name, interval, flags, draw )
+//
+// The interval is in scheduler units (see TASK_RES_MULTIPLIER); OWN_INTERVAL
+// means the routine sets it itself, or keeps whatever the previous one left.
+// Flags: STRETCHABLE means the frames follow the clock alone, so the
+// FRAME_GOVERNOR may draw fewer of them while nothing changes. BATCHABLE means
+// they depend on nothing but the time (no MPU, no buttons), so FRAME_QUEUE_DEPTH
+// may render them ahead.
+// 'ldr' and 'taskLedModeSelect' are the renderer and task of the strip or
+// segment being drawn.
+// Routines drawn by the same LEDRoutines method share its state, and their
+// names share a stem: the part before the first '_' or digit (p_*, noise_*,
+// twirl*, pulse5_*). STRIPS_SEGMENTS keeps each stem to one segment.
+//
+// Included by the sketch with ROUTINE defined; no include guard on purpose.
+// Only the entries enabled by the board's RT_* defines end up in the tables,
+// and the routines nothing points to are dropped by the linker.
+
+// The palette routines flow with the MPU when there is one
+#ifdef USING_MPU
+#define PALETTE_FLAGS 0
+#else
+#define PALETTE_FLAGS BATCHABLE
+#endif
+
+// Palette Rainbow is always included - a safe routine
+ROUTINE( "p_rb",          OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(0) )
+#ifdef RT_P_USER
+ROUTINE( "p_user",        OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(PALETTE_USER) )
+#endif
+#ifdef RT_P_RB_STRIPE
+ROUTINE( "p_rb_stripe",   OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(1) )
+#endif
+#ifdef RT_P_OCEAN
+ROUTINE( "p_ocean",       OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(2) )
+#endif
+#ifdef RT_P_HEAT
+ROUTINE( "p_heat",        OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(3) )
+#endif
+#ifdef RT_P_LAVA
+ROUTINE( "p_lava",        OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(4) )
+#endif
+#ifdef RT_P_PARTY
+ROUTINE( "p_party",       OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(5) )
+#endif
+#ifdef RT_P_CLOUD
+ROUTINE( "p_cloud",       OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(6) )
+#endif
+#ifdef RT_P_FOREST
+ROUTINE( "p_forest",      OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(7) )
+#endif
+#ifdef RT_P_SEQUENCE
+ROUTINE( "p_seq",         OWN_INTERVAL, PALETTE_FLAGS, ldr.FillLEDsFromPaletteColors(PALETTE_SEQUENCE) )
+#endif
+#ifdef RT_TWIRL1
+ROUTINE( "twirl1",        TASK_IMMEDIATE, 0, ldr.twirlers( 1, false ) )
+#endif
+#ifdef RT_TWIRL2
+ROUTINE( "twirl2",        TASK_IMMEDIATE, 0, ldr.twirlers( 2, false ) )
+#endif
+#ifdef RT_TWIRL4
+ROUTINE( "twirl4",        OWN_INTERVAL, 0, ldr.twirlers( 4, false ) )
+#endif
+#ifdef RT_TWIRL6
+ROUTINE( "twirl6",        OWN_INTERVAL, 0, ldr.twirlers( 6, false ) )
+#endif
+#ifdef RT_TWIRL2_O
+ROUTINE( "twirl2o",       OWN_INTERVAL, 0, ldr.twirlers( 2, true ) )
+#endif
+#ifdef RT_TWIRL4_O
+ROUTINE( "twirl4o",       OWN_INTERVAL, 0, ldr.twirlers( 4, true ) )
+#endif
+#ifdef RT_TWIRL6_O
+ROUTINE( "twirl6o",       OWN_INTERVAL, 0, ldr.twirlers( 6, true ) )
+#endif
+#ifdef RT_FADE_GLITTER
+#ifdef USING_MPU
+ROUTINE( "fglitter",      OWN_INTERVAL, 0, ldr.fadeGlitter() ;
+         taskLedModeSelect.setInterval( map( constrain( activityLevel(), 0, 2500), 0, 2500, 40, 2 ) * TASK_RES_MULTIPLIER ) )
+#else
+ROUTINE( "fglitter",      20 * TASK_RES_MULTIPLIER, 0, ldr.fadeGlitter() )
+#endif
+#endif
+#ifdef RT_DISCO_GLITTER
+#ifdef USING_MPU
+ROUTINE( "dglitter",      OWN_INTERVAL, 0, ldr.discoGlitter() ;
+         taskLedModeSelect.setInterval( map( constrain( activityLevel(), 0, 2500), 0, 2500, 40, 2 ) * TASK_RES_MULTIPLIER ) )
+#else
+ROUTINE( "dglitter",      10 * TASK_RES_MULTIPLIER, 0, ldr.discoGlitter() )
+#endif
+#endif
+#ifdef RT_FIRE2012
+ROUTINE( "fire2012",      10 * TASK_RES_MULTIPLIER, 0, ldr.Fire2012() )
+#endif
+#ifdef RT_RACERS
+ROUTINE( "racers",        8 * TASK_RES_MULTIPLIER, 0, ldr.racingLeds() )
+#endif
+#ifdef RT_WAVE
+ROUTINE( "wave",          15 * TASK_RES_MULTIPLIER, 0, ldr.waveYourArms() )
+#endif
+#ifdef RT_SHAKE_IT
+ROUTINE( "shakeit",       8 * TASK_RES_MULTIPLIER, 0, ldr.shakeIt() )
+#endif
+#ifdef RT_STROBE1
+ROUTINE( "strobe1",       5 * TASK_RES_MULTIPLIER, 0, ldr.strobe1() )
+#endif
+#ifdef RT_STROBE2
+ROUTINE( "strobe2",       10 * TASK_RES_MULTIPLIER, 0, ldr.strobe2() )
+#endif
+#ifdef RT_GLED
+// Gravity LED
+ROUTINE( "gled",          5 * TASK_RES_MULTIPLIER, 0, ldr.gLed() )
+#endif
+#ifdef RT_HEARTBEAT
+ROUTINE( "heartbeat",     5 * TASK_RES_MULTIPLIER, STRETCHABLE, ldr.heartbeat() )
+#endif
+#ifdef RT_FASTLOOP
+ROUTINE( "fastloop",      10 * TASK_RES_MULTIPLIER, 0, ldr.fastLoop( false ) )
+#endif
+#ifdef RT_FASTLOOP2
+ROUTINE( "fastloop2",     10 * TASK_RES_MULTIPLIER, 0, ldr.fastLoop( true ) )
+#endif
+#ifdef RT_PENDULUM
+ROUTINE( "pendulum",      1500, 0, ldr.pendulum() )   // needs a fast refresh rate
+#endif
+#ifdef RT_VUMETER
+ROUTINE( "vumeter",       8 * TASK_RES_MULTIPLIER, 0, ldr.vuMeter() )
+#endif
+#ifdef RT_NOISE_LAVA
+ROUTINE( "noise_lava",    10 * TASK_RES_MULTIPLIER, 0,
+         uint8_t bpm = ldr._tapTempo->getBPM() ;
+         ldr.fillnoise8( 0, bpm > 50 ? beatsin8( bpm, 1, 25 ) : 1, 30, 1 ) )   // palette, speed, scale, loop
+#endif
+#ifdef RT_NOISE_PARTY
+ROUTINE( "noise_party",   10 * TASK_RES_MULTIPLIER, 0,
+         uint8_t bpm = ldr._tapTempo->getBPM() ;
+         ldr.fillnoise8( 1, bpm > 50 ? beatsin8( bpm, 1, 25 ) : 1, 30, 1 ) )
+#endif
+#ifdef RT_NOISE_OCEAN
+ROUTINE( "noise_ocean",   10 * TASK_RES_MULTIPLIER, 0, ldr.fillnoise8( 2, beatsin8( ldr._tapTempo->getBPM(), 1, 25 ), 30, 1 ) )
+#endif
+#ifdef RT_NOISE_SEQUENCE
+ROUTINE( "noise_seq",     10 * TASK_RES_MULTIPLIER, 0, ldr.fillnoise8( PALETTE_SEQUENCE, beatsin8( ldr._tapTempo->getBPM(), 1, 25 ), 30, 1 ) )
+#endif
+#ifdef RT_BOUNCEBLEND
+ROUTINE( "bounceblend",   10 * TASK_RES_MULTIPLIER, 0, ldr.bounceBlend() )
+#endif
+#ifdef RT_JUGGLE_PAL
+ROUTINE( "jugglepal",     150, 0, ldr.jugglePal() )   // fast refresh rate needed to not skip any LEDs
+#endif
+#ifdef RT_QUAD_STROBE
+ROUTINE( "quadstrobe",    OWN_INTERVAL, 0, ldr.quadStrobe() ;
+         taskLedModeSelect.setInterval( (60000 / (ldr._tapTempo->getBPM() * 4)) * TASK_RES_MULTIPLIER ) )
+#endif
+#ifdef RT_PULSE_3
+ROUTINE( "pulse3",        10 * TASK_RES_MULTIPLIER, 0, ldr.pulse3() )
+#endif
+#ifdef RT_PULSE_5_1
+ROUTINE( "pulse5_1",      10 * TASK_RES_MULTIPLIER, 0, ldr.pulse5( 1, true ) )
+#endif
+#ifdef RT_PULSE_5_2
+ROUTINE( "pulse5_2",      10 * TASK_RES_MULTIPLIER, 0, ldr.pulse5( 2, true ) )
+#endif
+#ifdef RT_PULSE_5_3
+ROUTINE( "pulse5_3",      10 * TASK_RES_MULTIPLIER, 0, ldr.pulse5( 3, true ) )
+#endif
+#ifdef RT_THREE_SIN_PAL
+ROUTINE( "tsp",           10 * TASK_RES_MULTIPLIER, BATCHABLE, ldr.threeSinPal() )
+#endif
+#ifdef RT_COLOR_GLOW
+ROUTINE( "color_glow",    10 * TASK_RES_MULTIPLIER, 0, ldr.colorGlow() )
+#endif
+#ifdef RT_FAN_WIPE
+ROUTINE( "fan_wipe",      10 * TASK_RES_MULTIPLIER, 0, ldr.fanWipe() )
+#endif
+#ifdef RT_DROPLETS
+ROUTINE( "droplets",      30 * TASK_RES_MULTIPLIER, 0, ldr.droplets() )
+#endif
+#ifdef RT_DROPLETS2
+ROUTINE( "droplets2",     10 * TASK_RES_MULTIPLIER, 0, ldr.droplets2() )
+#endif
+#ifdef RT_BOUNCYBALLS
+ROUTINE( "bouncyballs",   30 * TASK_RES_MULTIPLIER, 0, ldr.bouncyBalls() )
+#endif
+#ifdef RT_CIRC_LOADER
+ROUTINE( "circloader",    50 * TASK_RES_MULTIPLIER, BATCHABLE, ldr.circularLoader() )
+#endif
+#ifdef RT_RIPPLE
+ROUTINE( "ripple",        100 * TASK_RES_MULTIPLIER, 0, ldr.ripple() )
+#endif
+#ifdef RT_RANDOMWALK
+ROUTINE( "randomwalk",    5 * TASK_RES_MULTIPLIER, 0, ldr.randomWalk() )
+#endif
+#ifdef RT_FASTLOOP3
+ROUTINE( "fastloop3",     15 * TASK_RES_MULTIPLIER, BATCHABLE, ldr.fastLoop3() )
+#endif
+#ifdef RT_POVPATTERNS
+// microseconds ; fast needed for POV patterns
+ROUTINE( "povpatterns",   30000, 0, ldr.povPatterns( 30, Image, sizeof(Image) / sizeof(Image[0]) ) )
+#endif
+#ifdef RT_BLACK
+// long because nothing is going on anyways.
+ROUTINE( "black",         500 * TASK_RES_MULTIPLIER, 0, fill_solid( ldr._leds, ldr._numLeds, CRGB::Black ) ; ldr.show() )
+#endif
+#ifdef ZONES
+// Each zone keeps its own frame rate; send when any of them drew
+ROUTINE( "zones",         ZONE_TICK_MS * TASK_RES_MULTIPLIER, 0,
+         if ( zoneRunner.draw( ldr.now() ) ) ldr.show() )
+#endif
@@ -0,0 +1,11 @@
+// Made by tools/playlist.py from Hoop1.txt for Hoop1.h. Don't edit, recompile.
+const uint8_t PlaylistData[] PROGMEM = {
+  0x50, 0x4c, 0x02, 0x0a, 0x92, 0x19, 0xbc, 0x24, 0x00, 0x3c, 0x00, 0xe8,
+  0x03, 0xff, 0x32, 0x00, 0x02, 0x2d, 0x00, 0x00, 0x00, 0xff, 0x00, 0x14,
+  0x0b, 0x1e, 0x00, 0xb0, 0x04, 0xff, 0x00, 0x0a, 0x12, 0x1e, 0x00, 0x00,
+  0x00, 0xff, 0x00, 0x0a, 0x13, 0x2d, 0x00, 0x00, 0x00, 0xff, 0x00, 0x14,
+  0x18, 0x1e, 0x00, 0x00, 0x05, 0xff, 0x00, 0x0a, 0x1a, 0x2d, 0x00, 0x00,
+  0x00, 0xff, 0x00, 0x14, 0x0f, 0x1e, 0x00, 0x00, 0x00, 0xff, 0x46, 0x0a,
+  0x15, 0x1e, 0x00, 0x00, 0x00, 0xff, 0x00, 0x0a, 0x1e, 0x14, 0x00, 0x00,
+  0x00, 0xff, 0x32, 0x14
+} ;
@@ -0,0 +1,17 @@
+// Included after the board header by tools/golden.py, for every file of a host run.
+
+// Routines run on the FrameCheck clock, as for the "check" serial command
+#ifndef FRAME_CHECK
+#define FRAME_CHECK
+#endif
+#ifndef USE_GET_MILLISECOND_TIMER
+#define USE_GET_MILLISECOND_TIMER
+#endif
+
+// The MPU routines read the sketch's MPU globals, and would draw differently every run
+// anyway (see FrameCheck.h); on the host they draw as on a board without the MPU, and
+// the ones that only exist with it are left out.
+#undef USING_MPU
+#undef RT_STROBE2
+#undef RT_SHAKE_IT
+#undef RT_GLED
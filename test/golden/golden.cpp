@@ -0,0 +1,120 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <TaskScheduler.h>
+#include <ArduinoTapTempo.h>
+#include <LEDRoutines.h>
+#include <PixelLayout.h>
+#include <FrameCheck.h>
+#include <Effects.h>
+
+/*
+   Runs every routine of a board for N frames the way the "check" serial
+   command does, and prints "name hash" per routine. Built once per board
+   header by tools/golden.py, which compares the output with golden/host/.
+
+     golden [frames] [name]
+
+   With a name, that routine's frames are printed as hex before its hash;
+   with "*" every routine's are (tools/codec_bench.py feeds them to frameenc).
+   All routines still run, in order, since they keep state in statics.
+*/
+
+#define TASK_RES_MULTIPLIER 1000
+
+CRGB leds[NUM_LEDS];
+uint8_t currentBrightness = DEFAULT_BRIGHTNESS ;
+ArduinoTapTempo tapTempo;
+LEDRoutines ldr;
+PixelLayout layout;
+Task taskLedModeSelect;
+FrameCheck frameCheck;
+
+#ifdef ZONES
+#ifndef ZONE_TICK_MS
+#define ZONE_TICK_MS 5
+#endif
+#define ZONE( name, type, args, first, length, stride ) type name args ;
+ZONES
+#undef ZONE
+#define ZONE( name, type, args, first, length, stride ) { { leds + (first), (length), (stride) }, &name, 0 },
+Zone zones[] = { ZONES } ;
+#undef ZONE
+ZoneRunner zoneRunner;
+#endif
+
+// The sketch's routine table, see RoutineCatalog.h
+struct Routine
+{
+  const char* name ;
+  uint32_t interval ;
+  uint8_t flags ;
+  void (*draw)( LEDRoutines& ldr, Task& taskLedModeSelect ) ;
+};
+
+#define OWN_INTERVAL 0xFFFFFFFF
+#define STRETCHABLE 0x01
+#define BATCHABLE 0x02
+#define ROUTINE( name, interval, flags, ... ) { name, interval, flags, []( LEDRoutines& ldr, Task& taskLedModeSelect ) { __VA_ARGS__ ; } },
+
+const Routine routineTable[] = {
+#include <RoutineCatalog.h>
+};
+
+#undef ROUTINE
+
+#define NUMROUTINES (sizeof(routineTable)/sizeof(Routine))
+
+
+// renderLedMode() and checkRoutine() of the sketch, with the scheduler's run count
+// and millis() moved along too, since nothing else does here
+void checkRoutine( uint8_t mode, uint32_t frames, bool dump ) {
+  const Routine& routine = routineTable[mode] ;
+  tapTempo.setBPM( DEFAULT_BPM ) ;
+
+  frameCheck.begin() ;
+  ldr._osc.reset( ldr.now() ) ;
+  ldr._palettes.restart( ldr.now() ) ;
+#ifdef ZONES
+  zoneRunner.restart( ldr.now() ) ;
+#endif
+  for ( uint32_t f = 0 ; f < frames ; f++ ) {
+    hostMillis = FrameCheck::now() ;
+    ldr.beginFrame() ;
+    routine.draw( ldr, taskLedModeSelect ) ;
+    if ( routine.interval != OWN_INTERVAL ) {
+      taskLedModeSelect.setInterval( routine.interval ) ;
+    }
+    taskLedModeSelect.runCounter++ ;
+    frameCheck.frame( leds, NUM_LEDS, ldr._brightness, taskLedModeSelect.getInterval() / TASK_RES_MULTIPLIER ) ;
+    if ( dump ) {
+      for ( uint16_t i = 0 ; i < NUM_LEDS ; i++ ) {
+        printf( "%02x%02x%02x", leds[i].r, leds[i].g, leds[i].b ) ;
+      }
+      printf( "\n" ) ;
+    }
+  }
+  frameCheck.end() ;
+
+  printf( "%s %X\n", routine.name, frameCheck.hash() ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  uint32_t frames = argc > 1 ? strtoul( argv[1], NULL, 10 ) : 100 ;
+  const char* dump = argc > 2 ? argv[2] : NULL ;
+
+  FastLED.setBrightness( currentBrightness ) ;
+  layout.begin( NUM_LEDS ) ;
+  ldr.setLeds( leds, NUM_LEDS, &tapTempo, &taskLedModeSelect, &currentBrightness ) ;
+  ldr.setLayout( &layout ) ;
+  ldr.setClock( get_millisecond_timer ) ;
+#ifdef ZONES
+  zoneRunner.begin( zones, sizeof(zones) / sizeof(zones[0]) ) ;
+#endif
+  taskLedModeSelect.setInterval( 50000 ) ;
+
+  for ( uint8_t i = 0 ; i < NUMROUTINES ; i++ ) {
+    checkRoutine( i, frames, dump && ( strcmp( dump, "*" ) == 0 || strcmp( dump, routineTable[i].name ) == 0 ) ) ;
+  }
+  return 0 ;
+}
@@ -0,0 +1,21 @@
+#include "Arduino.h"
+
+uint32_t hostMillis = 0 ;
+HardwareSerial Serial ;
+
+static uint32_t randomState = 1 ;
+
+long random( long howbig ) {
+  if ( howbig <= 0 ) return 0 ;
+  randomState = randomState * 1103515245 + 12345 ;
+  return ( randomState >> 8 ) % howbig ;
+}
+
+long random( long howsmall, long howbig ) {
+  if ( howsmall >= howbig ) return howsmall ;
+  return random( howbig - howsmall ) + howsmall ;
+}
+
+void randomSeed( unsigned long seed ) {
+  randomState = seed ;
+}
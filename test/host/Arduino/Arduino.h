@@ -0,0 +1,94 @@
+#ifndef Arduino_H
+#define Arduino_H
+
+/*
+   Host stand-in for the bits of the Arduino core the libraries use, so they
+   build and run natively (pio test -e native). Flash is plain memory here.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdio.h>
+
+typedef bool boolean ;
+typedef uint8_t byte ;
+
+#define PROGMEM
+#define pgm_read_byte( p )   ( *(const uint8_t*) (p) )
+#define pgm_read_word( p )   ( *(const uint16_t*) (p) )
+#define pgm_read_dword( p )  ( *(const uint32_t*) (p) )
+
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define LOW           0
+#define HIGH          1
+
+// Macros, as in the cores the firmware builds with, so mixed argument types work
+#ifndef min
+#define min( a, b ) ( (a) < (b) ? (a) : (b) )
+#endif
+#ifndef max
+#define max( a, b ) ( (a) > (b) ? (a) : (b) )
+#endif
+#define constrain( x, lo, hi ) ( (x) < (lo) ? (lo) : ( (x) > (hi) ? (hi) : (x) ) )
+
+inline long map( long x, long inMin, long inMax, long outMin, long outMax ) {
+  return ( x - inMin ) * ( outMax - outMin ) / ( inMax - inMin ) + outMin ;
+}
+
+// A clock the tests set by hand, so timing is the same on every run
+extern uint32_t hostMillis ;
+inline uint32_t millis() { return hostMillis ; }
+inline uint32_t micros() { return hostMillis * 1000 ; }
+inline void delay( uint32_t ms ) { hostMillis += ms ; }
+
+// Its own generator, so runs come out the same on every host
+long random( long howbig ) ;
+long random( long howsmall, long howbig ) ;
+void randomSeed( unsigned long seed ) ;
+
+#define F( s ) s
+
+#define DEC 10
+#define HEX 16
+
+// Just what the libraries call; a test derives from it to feed or catch bytes
+class Stream {
+  public:
+    virtual ~Stream() {}
+    virtual int available() = 0 ;
+    virtual int read() = 0 ;
+    virtual size_t write( const uint8_t* buf, size_t len ) = 0 ;
+    size_t write( uint8_t c ) { return write( &c, 1 ) ; }
+    size_t print( const char* s ) { return write( (const uint8_t*) s, strlen( s ) ) ; }
+    size_t println( const char* s ) { return print( s ) + print( "\r\n" ) ; }
+    size_t println() { return print( "\r\n" ) ; }
+    size_t print( long n, int base = DEC ) {
+      char buf[24] ;
+      snprintf( buf, sizeof(buf), base == HEX ? "%lX" : "%ld", n ) ;
+      return print( buf ) ;
+    }
+    size_t println( long n, int base = DEC ) { return print( n, base ) + println() ; }
+} ;
+
+// Where the libraries' debug output goes: nowhere
+class HardwareSerial : public Stream {
+  public:
+    int available() { return 0 ; }
+    int read() { return -1 ; }
+    size_t write( const uint8_t* buf, size_t len ) { return len ; }
+} ;
+
+extern HardwareSerial Serial ;
+
+// Pins read low and nothing is driven
+inline void pinMode( uint8_t, uint8_t ) {}
+inline int digitalRead( uint8_t ) { return LOW ; }
+inline void digitalWrite( uint8_t, uint8_t ) {}
+inline int analogRead( uint8_t ) { return 0 ; }
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef ArduinoTapTempo_H
+#define ArduinoTapTempo_H
+
+/*
+   Host stand-in for ArduinoTapTempo: a set tempo and the beat it is in,
+   on millis(). Nobody taps.
+*/
+
+#include <Arduino.h>
+
+class ArduinoTapTempo
+{
+  public:
+    float getBPM() { return 60000.0 / _beatLength ; }
+    void setBPM( float bpm ) { _beatLength = 60000.0 / bpm ; }
+    unsigned long getBeatLength() { return _beatLength ; }
+    void setBeatLength( unsigned long ms ) { _beatLength = ms ; }
+    float beatProgress() { return (float) ( ( millis() - _beatStart ) % _beatLength ) / _beatLength ; }
+    void resetTapChain() { _beatStart = millis() ; }
+    void update( bool ) {}
+    bool isChainActive() { return false ; }
+
+  private:
+    unsigned long _beatLength = 500 ;
+    unsigned long _beatStart = 0 ;
+};
+
+#endif
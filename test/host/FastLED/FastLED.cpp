@@ -0,0 +1,423 @@
+#include "FastLED.h"
+
+CFastLED FastLED ;
+
+
+// sin16_C(): eight linear segments per quarter wave
+int16_t sin16( uint16_t theta ) {
+  static const uint16_t base[] = { 0, 6393, 12539, 18204, 23170, 27245, 30273, 32137 } ;
+  static const uint8_t slope[] = { 49, 48, 44, 38, 31, 23, 14, 4 } ;
+
+  uint16_t offset = ( theta & 0x3FFF ) >> 3 ;   // 0 - 2047
+  if ( theta & 0x4000 ) offset = 2047 - offset ;
+
+  uint8_t section = offset / 256 ;
+  uint8_t secoffset8 = (uint8_t) offset / 2 ;
+  int16_t y = slope[section] * secoffset8 + base[section] ;
+  if ( theta & 0x8000 ) y = -y ;
+  return y ;
+}
+
+
+// sin8_C()
+uint8_t sin8( uint8_t theta ) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 } ;
+
+  uint8_t offset = theta ;
+  if ( theta & 0x40 ) offset = 255 - offset ;
+  offset &= 0x3F ;
+
+  uint8_t secoffset = offset & 0x0F ;
+  if ( theta & 0x40 ) secoffset++ ;
+
+  uint8_t section = offset >> 4 ;
+  uint8_t b = b_m16_interleave[section * 2] ;
+  uint8_t m16 = b_m16_interleave[section * 2 + 1] ;
+  uint8_t mx = ( m16 * secoffset ) >> 4 ;
+  int8_t y = mx + b ;
+  if ( theta & 0x80 ) y = -y ;
+  return y + 128 ;
+}
+
+
+// ---- random ----
+
+static uint16_t rand16seed = 1337 ;
+
+uint16_t random16() {
+  rand16seed = rand16seed * 2053 + 13849 ;
+  return rand16seed ;
+}
+
+uint16_t random16( uint16_t lim ) {
+  return ( (uint32_t) random16() * lim ) >> 16 ;
+}
+
+uint16_t random16( uint16_t min, uint16_t lim ) {
+  return random16( lim - min ) + min ;
+}
+
+uint8_t random8() {
+  random16() ;
+  return (uint8_t) ( rand16seed & 0xFF ) + (uint8_t) ( rand16seed >> 8 ) ;
+}
+
+uint8_t random8( uint8_t lim ) {
+  return ( random8() * lim ) >> 8 ;
+}
+
+uint8_t random8( uint8_t min, uint8_t lim ) {
+  return random8( lim - min ) + min ;
+}
+
+void random16_set_seed( uint16_t seed ) { rand16seed = seed ; }
+uint16_t random16_get_seed() { return rand16seed ; }
+void random16_add_entropy( uint16_t entropy ) { rand16seed += entropy ; }
+
+
+// ---- CRGB ----
+
+CRGB& CRGB::operator+=( const CRGB& rhs ) {
+  r = qadd8( r, rhs.r ) ;
+  g = qadd8( g, rhs.g ) ;
+  b = qadd8( b, rhs.b ) ;
+  return *this ;
+}
+
+CRGB& CRGB::operator-=( const CRGB& rhs ) {
+  r = qsub8( r, rhs.r ) ;
+  g = qsub8( g, rhs.g ) ;
+  b = qsub8( b, rhs.b ) ;
+  return *this ;
+}
+
+CRGB& CRGB::operator|=( const CRGB& rhs ) {
+  if ( rhs.r > r ) r = rhs.r ;
+  if ( rhs.g > g ) g = rhs.g ;
+  if ( rhs.b > b ) b = rhs.b ;
+  return *this ;
+}
+
+CRGB& CRGB::nscale8( uint8_t scaledown ) {
+  r = scale8( r, scaledown ) ;
+  g = scale8( g, scaledown ) ;
+  b = scale8( b, scaledown ) ;
+  return *this ;
+}
+
+CRGB& CRGB::nscale8_video( uint8_t scaledown ) {
+  r = scale8_video( r, scaledown ) ;
+  g = scale8_video( g, scaledown ) ;
+  b = scale8_video( b, scaledown ) ;
+  return *this ;
+}
+
+
+// hsv2rgb_rainbow(), the C version
+void hsv2rgb_rainbow( const CHSV& hsv, CRGB& rgb ) {
+  uint8_t hue = hsv.hue ;
+  uint8_t sat = hsv.sat ;
+  uint8_t val = hsv.val ;
+
+  uint8_t offset8 = ( hue & 0x1F ) << 3 ;
+  uint8_t third = scale8( offset8, 256 / 3 ) ;
+  uint8_t twothirds = scale8( offset8, 256 * 2 / 3 ) ;
+  uint8_t r, g, b ;
+
+  switch ( hue >> 5 ) {
+    case 0: r = 255 - third ; g = third ;             b = 0 ;               break ;   // R -> O
+    case 1: r = 171 ;         g = 85 + third ;        b = 0 ;               break ;   // O -> Y
+    case 2: r = 171 - twothirds ; g = 170 + third ;   b = 0 ;               break ;   // Y -> G
+    case 3: r = 0 ;           g = 255 - third ;       b = third ;           break ;   // G -> A
+    case 4: r = 0 ;           g = 171 - twothirds ;   b = 85 + twothirds ;  break ;   // A -> B
+    case 5: r = third ;       g = 0 ;                 b = 255 - third ;     break ;   // B -> P
+    case 6: r = 85 + third ;  g = 0 ;                 b = 171 - third ;     break ;   // P -> K
+    default: r = 170 + third ; g = 0 ;                b = 85 - third ;      break ;   // K -> R
+  }
+
+  if ( sat != 255 ) {
+    if ( sat == 0 ) {
+      r = g = b = 255 ;
+    } else {
+      uint8_t desat = 255 - sat ;
+      desat = scale8_video( desat, desat ) ;
+      uint8_t satscale = 255 - desat ;
+      if ( r ) r = scale8( r, satscale ) + 1 ;
+      if ( g ) g = scale8( g, satscale ) + 1 ;
+      if ( b ) b = scale8( b, satscale ) + 1 ;
+      r += desat ;
+      g += desat ;
+      b += desat ;
+    }
+  }
+
+  if ( val != 255 ) {
+    val = scale8_video( val, val ) ;
+    if ( val == 0 ) {
+      r = g = b = 0 ;
+    } else {
+      if ( r ) r = scale8( r, val ) + 1 ;
+      if ( g ) g = scale8( g, val ) + 1 ;
+      if ( b ) b = scale8( b, val ) + 1 ;
+    }
+  }
+
+  rgb.setRGB( r, g, b ) ;
+}
+
+
+// ---- colorutils ----
+
+void fill_solid( CRGB* leds, int numToFill, const CRGB& color ) {
+  for ( int i = 0 ; i < numToFill ; i++ ) leds[i] = color ;
+}
+
+void fill_gradient( CRGB* leds, uint16_t startpos, CHSV startcolor, uint16_t endpos, CHSV endcolor,
+                    TGradientDirectionCode directionCode ) {
+  if ( endpos < startpos ) {
+    uint16_t t = endpos ; endpos = startpos ; startpos = t ;
+    CHSV tc = endcolor ; endcolor = startcolor ; startcolor = tc ;
+  }
+
+  // A black or white end takes the other end's hue
+  if ( endcolor.value == 0 || endcolor.saturation == 0 ) endcolor.hue = startcolor.hue ;
+  if ( startcolor.value == 0 || startcolor.saturation == 0 ) startcolor.hue = endcolor.hue ;
+
+  int16_t satdistance87 = ( endcolor.sat - startcolor.sat ) << 7 ;
+  int16_t valdistance87 = ( endcolor.val - startcolor.val ) << 7 ;
+
+  uint8_t huedelta8 = endcolor.hue - startcolor.hue ;
+  if ( directionCode == SHORTEST_HUES ) directionCode = huedelta8 > 127 ? BACKWARD_HUES : FORWARD_HUES ;
+  if ( directionCode == LONGEST_HUES ) directionCode = huedelta8 < 128 ? BACKWARD_HUES : FORWARD_HUES ;
+
+  int16_t huedistance87 ;
+  if ( directionCode == FORWARD_HUES ) {
+    huedistance87 = huedelta8 << 7 ;
+  } else {
+    huedistance87 = (uint8_t) ( 256 - huedelta8 ) << 7 ;
+    huedistance87 = -huedistance87 ;
+  }
+
+  uint16_t pixeldistance = endpos - startpos ;
+  int16_t divisor = pixeldistance ? pixeldistance : 1 ;
+  int16_t huedelta87 = huedistance87 / divisor * 2 ;
+  int16_t satdelta87 = satdistance87 / divisor * 2 ;
+  int16_t valdelta87 = valdistance87 / divisor * 2 ;
+
+  uint16_t hue88 = startcolor.hue << 8 ;
+  uint16_t sat88 = startcolor.sat << 8 ;
+  uint16_t val88 = startcolor.val << 8 ;
+  for ( uint16_t i = startpos ; i <= endpos ; i++ ) {
+    leds[i] = CHSV( hue88 >> 8, sat88 >> 8, val88 >> 8 ) ;
+    hue88 += huedelta87 ;
+    sat88 += satdelta87 ;
+    val88 += valdelta87 ;
+  }
+}
+
+void nscale8( CRGB* leds, uint16_t numLeds, uint8_t scale ) {
+  for ( uint16_t i = 0 ; i < numLeds ; i++ ) leds[i].nscale8( scale ) ;
+}
+
+void fadeToBlackBy( CRGB* leds, uint16_t numLeds, uint8_t fadeBy ) {
+  nscale8( leds, numLeds, 255 - fadeBy ) ;
+}
+
+CRGB blend( const CRGB& p1, const CRGB& p2, fract8 amountOfP2 ) {
+  if ( amountOfP2 == 0 ) return p1 ;
+  if ( amountOfP2 == 255 ) return p2 ;
+  return CRGB( blend8( p1.r, p2.r, amountOfP2 ), blend8( p1.g, p2.g, amountOfP2 ), blend8( p1.b, p2.b, amountOfP2 ) ) ;
+}
+
+CHSV blend( const CHSV& p1, const CHSV& p2, fract8 amountOfP2, TGradientDirectionCode directionCode ) {
+  if ( amountOfP2 == 0 ) return p1 ;
+  if ( amountOfP2 == 255 ) return p2 ;
+  CHSV out = p1 ;
+  fract8 amountOfKeep = 255 - amountOfP2 ;
+
+  uint8_t huedelta8 = p2.hue - p1.hue ;
+  if ( directionCode == SHORTEST_HUES ) directionCode = huedelta8 > 127 ? BACKWARD_HUES : FORWARD_HUES ;
+  if ( directionCode == LONGEST_HUES ) directionCode = huedelta8 < 128 ? BACKWARD_HUES : FORWARD_HUES ;
+  if ( directionCode == FORWARD_HUES ) {
+    out.hue = p1.hue + scale8( huedelta8, amountOfP2 ) ;
+  } else {
+    huedelta8 = -huedelta8 ;
+    out.hue = p1.hue - scale8( huedelta8, amountOfP2 ) ;
+  }
+  out.sat = scale8( p1.sat, amountOfKeep ) + scale8( p2.sat, amountOfP2 ) ;
+  out.val = scale8( p1.val, amountOfKeep ) + scale8( p2.val, amountOfP2 ) ;
+  return out ;
+}
+
+CRGB HeatColor( uint8_t temperature ) {
+  uint8_t t192 = scale8_video( temperature, 191 ) ;
+  uint8_t heatramp = ( t192 & 0x3F ) << 2 ;
+  if ( t192 & 0x80 ) return CRGB( 255, 255, heatramp ) ;   // hottest
+  if ( t192 & 0x40 ) return CRGB( 255, heatramp, 0 ) ;     // middle
+  return CRGB( heatramp, 0, 0 ) ;                          // coolest
+}
+
+CRGB ColorFromPalette( const CRGBPalette16& pal, uint8_t index, uint8_t brightness, TBlendType blendType ) {
+  uint8_t hi4 = index >> 4 ;
+  uint8_t lo4 = index & 0x0F ;
+  CRGB c = pal[hi4] ;
+
+  if ( lo4 && blendType != NOBLEND ) {
+    const CRGB& next = pal[( hi4 + 1 ) & 0x0F] ;
+    uint8_t f2 = lo4 << 4 ;
+    uint8_t f1 = 255 - f2 ;
+    c = CRGB( scale8( c.r, f1 ) + scale8( next.r, f2 ),
+              scale8( c.g, f1 ) + scale8( next.g, f2 ),
+              scale8( c.b, f1 ) + scale8( next.b, f2 ) ) ;
+  }
+
+  if ( brightness != 255 ) {
+    if ( brightness ) {
+      brightness++ ;   // adjust for rounding
+      c.nscale8( brightness ) ;
+    } else {
+      c = CRGB( 0, 0, 0 ) ;
+    }
+  }
+  return c ;
+}
+
+
+// ---- colorpalettes.cpp ----
+
+const TProgmemRGBPalette16 CloudColors_p PROGMEM = {
+  CRGB::Blue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+  CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue, CRGB::DarkBlue,
+  CRGB::Blue, CRGB::DarkBlue, CRGB::SkyBlue, CRGB::SkyBlue,
+  CRGB::LightBlue, CRGB::White, CRGB::LightBlue, CRGB::SkyBlue
+} ;
+
+// 15 entries in FastLED too; the last one is black
+const TProgmemRGBPalette16 LavaColors_p PROGMEM = {
+  CRGB::Black, CRGB::Maroon, CRGB::Black, CRGB::Maroon,
+  CRGB::DarkRed, CRGB::Maroon, CRGB::DarkRed,
+  CRGB::DarkRed, CRGB::DarkRed, CRGB::Red, CRGB::Orange,
+  CRGB::White, CRGB::Orange, CRGB::Red, CRGB::DarkRed
+} ;
+
+const TProgmemRGBPalette16 OceanColors_p PROGMEM = {
+  CRGB::MidnightBlue, CRGB::DarkBlue, CRGB::MidnightBlue, CRGB::Navy,
+  CRGB::DarkBlue, CRGB::MediumBlue, CRGB::SeaGreen, CRGB::Teal,
+  CRGB::CadetBlue, CRGB::Blue, CRGB::DarkCyan, CRGB::CornflowerBlue,
+  CRGB::Aquamarine, CRGB::SeaGreen, CRGB::Aqua, CRGB::LightSkyBlue
+} ;
+
+const TProgmemRGBPalette16 ForestColors_p PROGMEM = {
+  CRGB::DarkGreen, CRGB::DarkGreen, CRGB::DarkOliveGreen, CRGB::DarkGreen,
+  CRGB::Green, CRGB::ForestGreen, CRGB::OliveDrab, CRGB::Green,
+  CRGB::SeaGreen, CRGB::MediumAquamarine, CRGB::LimeGreen, CRGB::YellowGreen,
+  CRGB::LightGreen, CRGB::LawnGreen, CRGB::MediumAquamarine, CRGB::ForestGreen
+} ;
+
+const TProgmemRGBPalette16 RainbowColors_p PROGMEM = {
+  0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00,
+  0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+  0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5,
+  0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+} ;
+
+const TProgmemRGBPalette16 RainbowStripeColors_p PROGMEM = {
+  0xFF0000, 0x000000, 0xAB5500, 0x000000,
+  0xABAB00, 0x000000, 0x00FF00, 0x000000,
+  0x00AB55, 0x000000, 0x0000FF, 0x000000,
+  0x5500AB, 0x000000, 0xAB0055, 0x000000
+} ;
+
+const TProgmemRGBPalette16 PartyColors_p PROGMEM = {
+  0x5500AB, 0x84007C, 0xB5004B, 0xE5001B,
+  0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+  0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E,
+  0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9
+} ;
+
+const TProgmemRGBPalette16 HeatColors_p PROGMEM = {
+  0x000000,
+  0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000,
+  0xFF3300, 0xFF6600, 0xFF9900, 0xFFCC00, 0xFFFF00,
+  0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF
+} ;
+
+
+// Ken Perlin's permutation table, 257 entries so P(n + 1) never needs a wrap
+static const uint8_t p[257] = {
+  151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,
+  140,36,103,30,69,142,8,99,37,240,21,10,23,190,6,148,
+  247,120,234,75,0,26,197,62,94,252,219,203,117,35,11,32,
+  57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,
+  74,165,71,134,139,48,27,166,77,146,158,231,83,111,229,122,
+  60,211,133,230,220,105,92,41,55,46,245,40,244,102,143,54,
+  65,25,63,161,1,216,80,73,209,76,132,187,208,89,18,169,
+  200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,
+  52,217,226,250,124,123,5,202,38,147,118,126,255,82,85,212,
+  207,206,59,227,47,16,58,17,182,189,28,42,223,183,170,213,
+  119,248,152,2,44,154,163,70,221,153,101,155,167,43,172,9,
+  129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,
+  218,246,97,228,251,34,242,193,238,210,144,12,191,179,162,241,
+  81,51,145,235,249,14,239,107,49,192,214,31,181,199,106,157,
+  184,84,204,176,115,121,50,45,127,4,150,254,138,236,205,93,
+  222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180,
+  151
+};
+
+#define P(x) p[(x)]
+
+static int8_t grad8( uint8_t hash, int8_t x, int8_t y, int8_t z ) {
+  hash = hash & 0xF ;
+  int8_t u = ( hash & 8 ) ? y : x ;
+  int8_t v = hash < 4 ? y : ( hash == 12 || hash == 14 ) ? x : z ;
+  if ( hash & 1 ) u = -u ;
+  if ( hash & 2 ) v = -v ;
+  return avg7( u, v ) ;
+}
+
+static int8_t lerp7by8( int8_t a, int8_t b, fract8 frac ) {
+  if ( b > a ) {
+    uint8_t delta = b - a ;
+    return a + scale8( delta, frac ) ;
+  }
+  uint8_t delta = a - b ;
+  return a - scale8( delta, frac ) ;
+}
+
+// Hashes the lattice cube for every point; test_noise_field checks NoiseField against it
+int8_t inoise8_raw( uint16_t x, uint16_t y, uint16_t z ) {
+  uint8_t X = x >> 8 ;
+  uint8_t Y = y >> 8 ;
+  uint8_t Z = z >> 8 ;
+
+  uint8_t A = P(X) + Y ;
+  uint8_t AA = P(A) + Z ;
+  uint8_t AB = P(A + 1) + Z ;
+  uint8_t B = P(X + 1) + Y ;
+  uint8_t BA = P(B) + Z ;
+  uint8_t BB = P(B + 1) + Z ;
+
+  uint8_t u = ease8InOutQuad( (uint8_t) x ) ;
+  uint8_t v = ease8InOutQuad( (uint8_t) y ) ;
+  uint8_t w = ease8InOutQuad( (uint8_t) z ) ;
+
+  int8_t xx = ( (uint8_t) x >> 1 ) & 0x7F ;
+  int8_t yy = ( (uint8_t) y >> 1 ) & 0x7F ;
+  int8_t zz = ( (uint8_t) z >> 1 ) & 0x7F ;
+  const uint8_t N = 0x80 ;
+
+  int8_t X1 = lerp7by8( grad8( P(AA), xx, yy, zz ), grad8( P(BA), xx - N, yy, zz ), u ) ;
+  int8_t X2 = lerp7by8( grad8( P(AB), xx, yy - N, zz ), grad8( P(BB), xx - N, yy - N, zz ), u ) ;
+  int8_t X3 = lerp7by8( grad8( P(AA + 1), xx, yy, zz - N ), grad8( P(BA + 1), xx - N, yy, zz - N ), u ) ;
+  int8_t X4 = lerp7by8( grad8( P(AB + 1), xx, yy - N, zz - N ), grad8( P(BB + 1), xx - N, yy - N, zz - N ), u ) ;
+
+  int8_t Y1 = lerp7by8( X1, X2, v ) ;
+  int8_t Y2 = lerp7by8( X3, X4, v ) ;
+  return lerp7by8( Y1, Y2, w ) ;
+}
+
+uint8_t inoise8( uint16_t x, uint16_t y, uint16_t z ) {
+  int8_t n = inoise8_raw( x, y, z ) ;
+  n += 64 ;
+  return qadd8( n, n ) ;
+}
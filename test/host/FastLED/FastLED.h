@@ -0,0 +1,353 @@
+#ifndef FastLED_H
+#define FastLED_H
+
+/*
+   Host stand-in for the parts of FastLED the libraries use, so they build
+   and run natively (pio test -e native). The maths follows FastLED's
+   portable C code (lib8tion, hsv2rgb, colorutils, noise.cpp) so results
+   match the firmware's; controllers only keep their LEDs, nothing is shown.
+*/
+
+#include <Arduino.h>
+
+typedef uint8_t fract8 ;
+typedef uint16_t fract16 ;
+
+enum LEDColorCorrection
+{
+  TypicalSMD5050 = 0xFFB0F0,
+  TypicalLEDStrip = 0xFFB0F0,
+  UncorrectedColor = 0xFFFFFF
+};
+
+typedef uint16_t accum88 ;
+
+// FastLED reads its clock through get_millisecond_timer() when asked to
+#ifdef USE_GET_MILLISECOND_TIMER
+uint32_t get_millisecond_timer() ;
+#define GET_MILLIS get_millisecond_timer
+#else
+#define GET_MILLIS millis
+#endif
+
+struct CHSV
+{
+  union {
+    struct {
+      union { uint8_t hue ; uint8_t h ; } ;
+      union { uint8_t sat ; uint8_t saturation ; uint8_t s ; } ;
+      union { uint8_t val ; uint8_t value ; uint8_t v ; } ;
+    };
+    uint8_t raw[3] ;
+  };
+
+  CHSV() {}
+  CHSV( uint8_t ih, uint8_t is, uint8_t iv ) : hue( ih ), sat( is ), val( iv ) {}
+};
+
+struct CRGB ;
+void hsv2rgb_rainbow( const CHSV& hsv, CRGB& rgb ) ;
+
+struct CRGB
+{
+  union {
+    struct {
+      union { uint8_t r ; uint8_t red ; } ;
+      union { uint8_t g ; uint8_t green ; } ;
+      union { uint8_t b ; uint8_t blue ; } ;
+    };
+    uint8_t raw[3] ;
+  };
+
+  CRGB() {}
+  CRGB( uint8_t ir, uint8_t ig, uint8_t ib ) : r( ir ), g( ig ), b( ib ) {}
+  CRGB( uint32_t colorcode ) : r( colorcode >> 16 ), g( colorcode >> 8 ), b( colorcode ) {}
+  CRGB( LEDColorCorrection colorcode ) : r( colorcode >> 16 ), g( colorcode >> 8 ), b( colorcode ) {}
+  CRGB( const CHSV& rhs ) { hsv2rgb_rainbow( rhs, *this ) ; }
+
+  CRGB& operator=( const CHSV& rhs ) { hsv2rgb_rainbow( rhs, *this ) ; return *this ; }
+  CRGB& operator=( uint32_t colorcode ) { r = colorcode >> 16 ; g = colorcode >> 8 ; b = colorcode ; return *this ; }
+  CRGB& setRGB( uint8_t nr, uint8_t ng, uint8_t nb ) { r = nr ; g = ng ; b = nb ; return *this ; }
+  CRGB& setHSV( uint8_t hue, uint8_t sat, uint8_t val ) { hsv2rgb_rainbow( CHSV( hue, sat, val ), *this ) ; return *this ; }
+
+  CRGB& operator+=( const CRGB& rhs ) ;
+  CRGB& operator-=( const CRGB& rhs ) ;
+  CRGB& operator|=( const CRGB& rhs ) ;
+  CRGB& nscale8( uint8_t scaledown ) ;
+  CRGB& nscale8_video( uint8_t scaledown ) ;
+  CRGB& fadeToBlackBy( uint8_t fadefactor ) { return nscale8( 255 - fadefactor ) ; }
+
+  uint8_t& operator[]( uint8_t x ) { return raw[x] ; }
+  const uint8_t& operator[]( uint8_t x ) const { return raw[x] ; }
+
+  bool operator==( const CRGB& rhs ) const { return r == rhs.r && g == rhs.g && b == rhs.b ; }
+  bool operator!=( const CRGB& rhs ) const { return ! ( *this == rhs ) ; }
+  operator bool() const { return r || g || b ; }
+
+  enum HTMLColorCode
+  {
+    Aqua = 0x00FFFF,
+    Aquamarine = 0x7FFFD4,
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    CadetBlue = 0x5F9EA0,
+    CornflowerBlue = 0x6495ED,
+    DarkBlue = 0x00008B,
+    DarkCyan = 0x008B8B,
+    DarkGreen = 0x006400,
+    DarkOliveGreen = 0x556B2F,
+    DarkRed = 0x8B0000,
+    ForestGreen = 0x228B22,
+    Green = 0x008000,
+    LawnGreen = 0x7CFC00,
+    LightBlue = 0xADD8E6,
+    LightGreen = 0x90EE90,
+    LightSkyBlue = 0x87CEFA,
+    LimeGreen = 0x32CD32,
+    Maroon = 0x800000,
+    MediumAquamarine = 0x66CDAA,
+    MediumBlue = 0x0000CD,
+    MidnightBlue = 0x191970,
+    Navy = 0x000080,
+    OliveDrab = 0x6B8E23,
+    Orange = 0xFFA500,
+    Red = 0xFF0000,
+    SeaGreen = 0x2E8B57,
+    SkyBlue = 0x87CEEB,
+    Teal = 0x008080,
+    White = 0xFFFFFF,
+    YellowGreen = 0x9ACD32
+  };
+};
+
+#define HUE_RED     0
+#define HUE_ORANGE  32
+#define HUE_YELLOW  64
+#define HUE_GREEN   96
+#define HUE_AQUA    128
+#define HUE_BLUE    160
+#define HUE_PURPLE  192
+#define HUE_PINK    224
+
+
+// ---- lib8tion, FASTLED_SCALE8_FIXED ----
+
+inline uint8_t scale8( uint8_t i, fract8 scale ) {
+  return ( (uint16_t) i * ( 1 + (uint16_t) scale ) ) >> 8 ;
+}
+
+inline uint8_t scale8_video( uint8_t i, fract8 scale ) {
+  return ( ( (int) i * (int) scale ) >> 8 ) + ( ( i && scale ) ? 1 : 0 ) ;
+}
+
+inline uint16_t scale16( uint16_t i, fract16 scale ) {
+  return ( (uint32_t) i * ( 1 + (uint32_t) scale ) ) >> 16 ;
+}
+
+inline uint8_t qadd8( uint8_t i, uint8_t j ) {
+  unsigned int t = i + j ;
+  return t > 255 ? 255 : t ;
+}
+
+inline uint8_t qsub8( uint8_t i, uint8_t j ) {
+  int t = i - j ;
+  return t < 0 ? 0 : t ;
+}
+
+inline uint8_t dim8_raw( uint8_t x ) {
+  return scale8( x, x ) ;
+}
+
+inline uint8_t triwave8( uint8_t in ) {
+  if ( in & 0x80 ) in = 255 - in ;
+  return in << 1 ;
+}
+
+inline uint8_t blend8( uint8_t a, uint8_t b, uint8_t amountOfB ) {
+  uint16_t partial = ( a << 8 ) | b ;
+  partial += b * amountOfB ;
+  partial -= a * amountOfB ;
+  return partial >> 8 ;
+}
+
+inline int8_t avg7( int8_t i, int8_t j ) {
+  return ( i >> 1 ) + ( j >> 1 ) + ( i & 0x1 ) ;
+}
+
+inline uint8_t lerp8by8( uint8_t a, uint8_t b, fract8 frac ) {
+  if ( b > a ) return a + scale8( b - a, frac ) ;
+  return a - scale8( a - b, frac ) ;
+}
+
+inline uint8_t ease8InOutQuad( uint8_t i ) {
+  uint8_t j = i ;
+  if ( j & 0x80 ) j = 255 - j ;
+  uint8_t jj2 = scale8( j, j ) << 1 ;
+  if ( i & 0x80 ) jj2 = 255 - jj2 ;
+  return jj2 ;
+}
+
+inline uint16_t ease16InOutQuad( uint16_t i ) {
+  uint16_t j = i ;
+  if ( j & 0x8000 ) j = 65535 - j ;
+  uint16_t jj2 = scale16( j, j ) << 1 ;
+  if ( i & 0x8000 ) jj2 = 65535 - jj2 ;
+  return jj2 ;
+}
+
+int16_t sin16( uint16_t theta ) ;
+uint8_t sin8( uint8_t theta ) ;
+inline int16_t cos16( uint16_t theta ) { return sin16( theta + 16384 ) ; }
+inline uint8_t cos8( uint8_t theta ) { return sin8( theta + 64 ) ; }
+
+
+// ---- random: FastLED's 16-bit LCG ----
+
+uint8_t random8() ;
+uint8_t random8( uint8_t lim ) ;
+uint8_t random8( uint8_t min, uint8_t lim ) ;
+uint16_t random16() ;
+uint16_t random16( uint16_t lim ) ;
+uint16_t random16( uint16_t min, uint16_t lim ) ;
+void random16_set_seed( uint16_t seed ) ;
+uint16_t random16_get_seed() ;
+void random16_add_entropy( uint16_t entropy ) ;
+
+
+// ---- beats, on GET_MILLIS() ----
+
+inline uint16_t beat88( accum88 beatsPerMinute88, uint32_t timebase = 0 ) {
+  return ( ( GET_MILLIS() - timebase ) * beatsPerMinute88 * 280 ) >> 16 ;
+}
+
+inline uint16_t beat16( accum88 beatsPerMinute, uint32_t timebase = 0 ) {
+  if ( beatsPerMinute < 256 ) beatsPerMinute <<= 8 ;
+  return beat88( beatsPerMinute, timebase ) ;
+}
+
+inline uint8_t beat8( accum88 beatsPerMinute, uint32_t timebase = 0 ) {
+  return beat16( beatsPerMinute, timebase ) >> 8 ;
+}
+
+inline uint16_t beatsin16( accum88 beatsPerMinute, uint16_t lowest = 0, uint16_t highest = 65535,
+                           uint32_t timebase = 0, uint16_t phaseOffset = 0 ) {
+  uint16_t beatsin = sin16( beat16( beatsPerMinute, timebase ) + phaseOffset ) + 32768 ;
+  return lowest + scale16( beatsin, highest - lowest ) ;
+}
+
+inline uint8_t beatsin8( accum88 beatsPerMinute, uint8_t lowest = 0, uint8_t highest = 255,
+                         uint32_t timebase = 0, uint8_t phaseOffset = 0 ) {
+  uint8_t beatsin = sin8( beat8( beatsPerMinute, timebase ) + phaseOffset ) ;
+  return lowest + scale8( beatsin, highest - lowest ) ;
+}
+
+
+// ---- colors ----
+
+typedef const uint32_t TProgmemRGBPalette16[16] ;
+
+enum TBlendType { NOBLEND = 0, LINEARBLEND = 1 } ;
+enum TGradientDirectionCode { FORWARD_HUES, BACKWARD_HUES, SHORTEST_HUES, LONGEST_HUES } ;
+
+struct CRGBPalette16
+{
+  CRGB entries[16] ;
+
+  CRGBPalette16() { for ( uint8_t i = 0 ; i < 16 ; i++ ) entries[i] = CRGB( 0, 0, 0 ) ; }
+  CRGBPalette16( const CRGB& c ) { for ( uint8_t i = 0 ; i < 16 ; i++ ) entries[i] = c ; }
+  CRGBPalette16( const TProgmemRGBPalette16& rhs ) { *this = rhs ; }
+  CRGBPalette16( const CRGB& c00, const CRGB& c01, const CRGB& c02, const CRGB& c03,
+                 const CRGB& c04, const CRGB& c05, const CRGB& c06, const CRGB& c07,
+                 const CRGB& c08, const CRGB& c09, const CRGB& c10, const CRGB& c11,
+                 const CRGB& c12, const CRGB& c13, const CRGB& c14, const CRGB& c15 ) {
+    const CRGB* c[16] = { &c00, &c01, &c02, &c03, &c04, &c05, &c06, &c07, &c08, &c09, &c10, &c11, &c12, &c13, &c14, &c15 } ;
+    for ( uint8_t i = 0 ; i < 16 ; i++ ) entries[i] = *c[i] ;
+  }
+
+  CRGBPalette16& operator=( const TProgmemRGBPalette16& rhs ) {
+    for ( uint8_t i = 0 ; i < 16 ; i++ ) entries[i] = CRGB( rhs[i] ) ;
+    return *this ;
+  }
+
+  bool operator==( const CRGBPalette16& rhs ) const { return memcmp( entries, rhs.entries, sizeof(entries) ) == 0 ; }
+  bool operator!=( const CRGBPalette16& rhs ) const { return ! ( *this == rhs ) ; }
+
+  CRGB& operator[]( uint8_t x ) { return entries[x] ; }
+  const CRGB& operator[]( uint8_t x ) const { return entries[x] ; }
+};
+
+extern const TProgmemRGBPalette16 CloudColors_p ;
+extern const TProgmemRGBPalette16 LavaColors_p ;
+extern const TProgmemRGBPalette16 OceanColors_p ;
+extern const TProgmemRGBPalette16 ForestColors_p ;
+extern const TProgmemRGBPalette16 RainbowColors_p ;
+extern const TProgmemRGBPalette16 RainbowStripeColors_p ;
+extern const TProgmemRGBPalette16 PartyColors_p ;
+extern const TProgmemRGBPalette16 HeatColors_p ;
+
+CRGB ColorFromPalette( const CRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND ) ;
+inline CRGB ColorFromPalette( const TProgmemRGBPalette16& pal, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND ) {
+  return ColorFromPalette( CRGBPalette16( pal ), index, brightness, blendType ) ;
+}
+
+CRGB HeatColor( uint8_t temperature ) ;
+CRGB blend( const CRGB& p1, const CRGB& p2, fract8 amountOfP2 ) ;
+CHSV blend( const CHSV& p1, const CHSV& p2, fract8 amountOfP2, TGradientDirectionCode directionCode = SHORTEST_HUES ) ;
+
+void fill_solid( CRGB* leds, int numToFill, const CRGB& color ) ;
+void fill_gradient( CRGB* leds, uint16_t startpos, CHSV startcolor, uint16_t endpos, CHSV endcolor,
+                    TGradientDirectionCode directionCode = SHORTEST_HUES ) ;
+void nscale8( CRGB* leds, uint16_t numLeds, uint8_t scale ) ;
+void fadeToBlackBy( CRGB* leds, uint16_t numLeds, uint8_t fadeBy ) ;
+
+
+// ---- controllers: they keep what they're given, nothing is sent ----
+
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER  0x01
+
+class CLEDController
+{
+  public:
+    CLEDController& setLeds( CRGB* leds, int numLeds ) { _leds = leds ; _numLeds = numLeds ; return *this ; }
+    CLEDController& setCorrection( CRGB correction ) { _correction = correction ; return *this ; }
+    CLEDController& setDither( uint8_t ) { return *this ; }
+    CLEDController* next() { return NULL ; }
+    CRGB* leds() { return _leds ; }
+    int size() { return _numLeds ; }
+    void showLeds( uint8_t brightness = 255 ) {}
+
+  private:
+    CRGB* _leds = NULL ;
+    int _numLeds = 0 ;
+    CRGB _correction = CRGB( UncorrectedColor ) ;
+};
+
+class CFastLED
+{
+  public:
+    void setBrightness( uint8_t scale ) { _brightness = scale ; }
+    uint8_t getBrightness() { return _brightness ; }
+    void show() { show( _brightness ) ; }
+    void show( uint8_t brightness ) { _shown++ ; }
+    void setDither( uint8_t ) {}
+    int count() { return 1 ; }
+    CLEDController& operator[]( int x ) { return _controller ; }
+    uint32_t shown() { return _shown ; }
+
+  private:
+    uint8_t _brightness = 255 ;
+    uint32_t _shown = 0 ;
+    CLEDController _controller ;
+};
+
+extern CFastLED FastLED ;
+
+
+// ---- noise.cpp ----
+
+// -64 .. 64
+int8_t inoise8_raw( uint16_t x, uint16_t y, uint16_t z ) ;
+uint8_t inoise8( uint16_t x, uint16_t y, uint16_t z ) ;
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <Arduino.h>
+
+// Host stand-in for the SPI library: keeps the last transfer for the tests to look at
+
+#define MSBFIRST   1
+#define SPI_MODE0  0
+
+struct SPISettings
+{
+  SPISettings( uint32_t, uint8_t, uint8_t ) {}
+};
+
+class SPIClass
+{
+  public:
+    void begin() {}
+    void beginTransaction( SPISettings ) {}
+    void endTransaction() {}
+    void transfer( void* buf, size_t count ) {
+      sent = (const uint8_t*) buf ;
+      sentCount = count ;
+    }
+
+    const uint8_t* sent = NULL ;
+    size_t sentCount = 0 ;
+};
+
+extern SPIClass SPI ;
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef TaskScheduler_H
+#define TaskScheduler_H
+
+/*
+   Host stand-in for the parts of TaskScheduler the routines use: a Task
+   only keeps its interval and run count. Nothing is scheduled; whoever
+   drives the routines (test/golden) runs them and counts the runs.
+*/
+
+#include <Arduino.h>
+
+#define TASK_IMMEDIATE   0
+#define TASK_FOREVER     ( -1 )
+#define TASK_ONCE        1
+#define TASK_MILLISECOND 1UL
+#define TASK_SECOND      1000UL
+
+class Task
+{
+  public:
+    Task( unsigned long interval = 0, long iterations = 0, void (*callback)() = NULL ) : _interval( interval ) {}
+
+    void setInterval( unsigned long interval ) { _interval = interval ; _delay = interval ; }
+    unsigned long getInterval() { return _interval ; }
+    unsigned long getStartDelay() { return _delay ; }
+    void delay( unsigned long delay = 0 ) { _delay = delay ? delay : _interval ; }
+    unsigned long getRunCounter() { return runCounter ; }
+
+    void enable() { _enabled = true ; }
+    void restart() { _enabled = true ; }
+    void disable() { _enabled = false ; }
+    bool isEnabled() { return _enabled ; }
+
+    unsigned long runCounter = 0 ;
+
+  private:
+    unsigned long _interval ;
+    unsigned long _delay = 0 ;
+    bool _enabled = false ;
+};
+
+#endif
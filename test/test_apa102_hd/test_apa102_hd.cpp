@@ -0,0 +1,104 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <SPI.h>
+#include <Apa102Hd.h>
+
+void setUp() {}
+void tearDown() {}
+
+// What the LED puts out for one channel, on the 16-bit scale split() was given
+uint32_t shown( uint8_t pwm, uint8_t current ) {
+  return (uint32_t) pwm * current * 256 / 31 ;
+}
+
+// How far off that may be: a PWM step at this current for rounding down, and
+// most of another for currentScale[] being rounded reciprocals
+uint32_t slack( uint8_t current ) {
+  return 2 * ( current * 256 / 31 + 1 ) ;
+}
+
+
+void test_split_every_level_fits_and_comes_back() {
+  for ( uint32_t v = 0 ; v <= 65535 ; v++ ) {
+    uint8_t pwm[3] ;
+    uint8_t current = Apa102Hd::split( v, 0, 0, pwm ) ;
+    TEST_ASSERT_TRUE( current >= 1 && current <= 31 ) ;
+    // An overflowing PWM byte would wrap and come back far too low
+    TEST_ASSERT_UINT32_WITHIN( slack( current ), v, shown( pwm[0], current ) ) ;
+    TEST_ASSERT_EQUAL_UINT8( 0, pwm[1] ) ;
+    TEST_ASSERT_EQUAL_UINT8( 0, pwm[2] ) ;
+  }
+}
+
+void test_split_uses_the_smallest_current() {
+  for ( uint16_t hi = 0 ; hi < 256 ; hi++ ) {
+    uint8_t pwm[3] ;
+    uint8_t current = Apa102Hd::split( hi << 8 | 0xFF, 0, 0, pwm ) ;
+    TEST_ASSERT_TRUE( ( hi + 1 ) * 31 <= 256 * current ) ;
+    if ( current > 1 ) TEST_ASSERT_TRUE( ( hi + 1 ) * 31 > 256 * ( current - 1 ) ) ;
+  }
+}
+
+void test_split_keeps_the_channels_in_ratio() {
+  uint32_t seed = 1 ;
+  for ( uint16_t n = 0 ; n < 10000 ; n++ ) {
+    uint16_t c[3] ;
+    for ( uint8_t i = 0 ; i < 3 ; i++ ) {
+      seed = seed * 1103515245 + 12345 ;
+      c[i] = seed >> 16 ;
+    }
+    uint8_t pwm[3] ;
+    uint8_t current = Apa102Hd::split( c[0], c[1], c[2], pwm ) ;
+    for ( uint8_t i = 0 ; i < 3 ; i++ ) {
+      TEST_ASSERT_UINT32_WITHIN( slack( current ), c[i], shown( pwm[i], current ) ) ;
+    }
+  }
+}
+
+void test_split_dim_pixels_keep_their_pwm_range() {
+  // 8-bit value 3 at brightness 10: a plain scale would leave 0 steps of PWM
+  uint8_t pwm[3] ;
+  uint8_t current = Apa102Hd::split( 3 * 11, 0, 0, pwm ) ;
+  TEST_ASSERT_EQUAL_UINT8( 1, current ) ;
+  TEST_ASSERT_UINT8_WITHIN( 1, 3 * 11 * 31 / 256, pwm[0] ) ;
+}
+
+void test_show_packs_frames_in_bgr() {
+  static Apa102Hd hd ;
+  CRGB leds[3] = { CRGB( 255, 0, 0 ), CRGB( 0, 255, 0 ), CRGB( 0, 0, 0 ) } ;
+  hd.begin( 3 ) ;
+  hd.show( leds, 255 ) ;
+
+  TEST_ASSERT_EQUAL( 4 + 3 * 4 + 1, SPI.sentCount ) ;
+  const uint8_t* p = SPI.sent ;
+  for ( uint8_t i = 0 ; i < 4 ; i++ ) TEST_ASSERT_EQUAL_UINT8( 0, p[i] ) ;   // start frame
+
+  const uint8_t* red = p + 4 ;
+  TEST_ASSERT_EQUAL_UINT8( 0xE0 | 31, red[0] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, red[1] ) ;   // blue
+  TEST_ASSERT_EQUAL_UINT8( 0, red[2] ) ;   // green
+  TEST_ASSERT_UINT8_WITHIN( 1, 255, red[3] ) ;
+
+  const uint8_t* green = p + 8 ;
+  TEST_ASSERT_EQUAL_UINT8( 0, green[1] ) ;
+  TEST_ASSERT_TRUE( green[2] > 0 ) ;   // TypicalLEDStrip takes green down to 0xB0
+  TEST_ASSERT_EQUAL_UINT8( 0, green[3] ) ;
+
+  const uint8_t* black = p + 12 ;
+  TEST_ASSERT_EQUAL_UINT8( 0xE0 | 1, black[0] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, black[1] | black[2] | black[3] ) ;
+
+  TEST_ASSERT_EQUAL_UINT8( 0, p[16] ) ;    // end frame
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_split_every_level_fits_and_comes_back ) ;
+  RUN_TEST( test_split_uses_the_smallest_current ) ;
+  RUN_TEST( test_split_keeps_the_channels_in_ratio ) ;
+  RUN_TEST( test_split_dim_pixels_keep_their_pwm_range ) ;
+  RUN_TEST( test_show_packs_frames_in_bgr ) ;
+  return UNITY_END() ;
+}
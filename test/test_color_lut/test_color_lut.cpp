@@ -0,0 +1,77 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <ColorLut.h>
+
+// Built with COLOR_LUT_FUSED (see env:native), so show() goes through the fused tables
+
+#define LEDS 2
+
+CRGB leds[LEDS] ;
+CLEDController controller ;
+ColorLut lut ;
+
+void setUp() {
+  lut = ColorLut() ;
+  lut.begin( &controller, leds, LEDS ) ;
+}
+
+void tearDown() {}
+
+// What the controller is sent for one channel of leds[0]
+uint8_t shown( uint8_t channel ) {
+  return controller.leds()[0][channel] ;
+}
+
+
+void test_full_scale_at_full_brightness() {
+  leds[0] = CRGB( 255, 255, 255 ) ;
+  lut.show( 255 ) ;
+  TEST_ASSERT_EQUAL_UINT8( COLOR_LUT_WB_R, shown( 0 ) ) ;   // 255: rounded up, this wrapped to 0
+  TEST_ASSERT_EQUAL_UINT8( COLOR_LUT_WB_G, shown( 1 ) ) ;
+  TEST_ASSERT_EQUAL_UINT8( COLOR_LUT_WB_B, shown( 2 ) ) ;
+}
+
+void test_fused_is_the_table_times_brightness() {
+  for ( uint16_t b = 0 ; b < 256 ; b += 17 ) {
+    for ( uint16_t v = 0 ; v < 256 ; v++ ) {
+      leds[0] = CRGB( v, v, v ) ;
+      lut.show( b ) ;
+      for ( uint8_t c = 0 ; c < 3 ; c++ ) {
+        uint32_t expected = b ? ( (uint32_t) ColorLut::value16( c, v ) * ( b + 1 ) ) >> 16 : 0 ;
+        TEST_ASSERT_EQUAL_UINT8( expected, shown( c ) ) ;
+      }
+    }
+  }
+}
+
+void test_never_gets_darker_going_up() {
+  for ( uint16_t b = 0 ; b < 256 ; b++ ) {
+    uint8_t last = 0 ;
+    for ( uint16_t v = 0 ; v < 256 ; v++ ) {
+      leds[0] = CRGB( v, 0, 0 ) ;
+      lut.show( b ) ;
+      TEST_ASSERT_TRUE( shown( 0 ) >= last ) ;
+      last = shown( 0 ) ;
+    }
+  }
+}
+
+void test_black_stays_black() {
+  leds[0] = CRGB( 0, 0, 0 ) ;
+  leds[1] = CRGB( 255, 255, 255 ) ;
+  lut.show( 255 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, shown( 0 ) | shown( 1 ) | shown( 2 ) ) ;
+  lut.show( 0 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, controller.leds()[1].r ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_full_scale_at_full_brightness ) ;
+  RUN_TEST( test_fused_is_the_table_times_brightness ) ;
+  RUN_TEST( test_never_gets_darker_going_up ) ;
+  RUN_TEST( test_black_stays_black ) ;
+  return UNITY_END() ;
+}
@@ -0,0 +1,144 @@
+#include <unity.h>
+#include <FrameCodec.h>
+
+#define LEDS 300   // more than FC_MAX_RUN, so runs and literals get split
+
+uint8_t frame[LEDS * 3] ;
+uint8_t prev[LEDS * 3] ;
+uint8_t packet[1 + LEDS * 3 + 16] ;
+uint8_t out[LEDS * 3] ;
+
+void setUp() {
+  memset( frame, 0, sizeof(frame) ) ;
+  memset( prev, 0, sizeof(prev) ) ;
+  memset( out, 0, sizeof(out) ) ;
+}
+
+void tearDown() {}
+
+void setPixel( uint8_t* f, uint16_t i, uint8_t r, uint8_t g, uint8_t b ) {
+  f[3 * i] = r ;
+  f[3 * i + 1] = g ;
+  f[3 * i + 2] = b ;
+}
+
+void fillNoise( uint8_t* f, uint32_t seed ) {
+  for ( uint16_t i = 0 ; i < LEDS * 3 ; i++ ) {
+    seed = seed * 1103515245 + 12345 ;
+    f[i] = seed >> 16 ;
+  }
+}
+
+// Encode as 'type' into packet, decode on top of 'base', and expect frame back
+void roundTrip( uint8_t type, const uint8_t* base ) {
+  uint16_t len = FrameCodec::encodeAs( type, frame, base, LEDS, packet, sizeof(packet) ) ;
+  TEST_ASSERT_TRUE( len > 0 ) ;
+  TEST_ASSERT_EQUAL_UINT8( type, packet[0] ) ;
+  // Measuring only gives the same size
+  TEST_ASSERT_EQUAL_UINT16( len, FrameCodec::encodeAs( type, frame, base, LEDS, NULL, 0 ) ) ;
+
+  if ( base ) memcpy( out, base, sizeof(out) ) ;
+  TEST_ASSERT_TRUE( FrameCodec::decode( packet, len, out, LEDS ) ) ;
+  TEST_ASSERT_EQUAL_UINT8_ARRAY( frame, out, LEDS * 3 ) ;
+}
+
+
+void test_raw_round_trip() {
+  fillNoise( frame, 1 ) ;
+  roundTrip( FC_RAW, NULL ) ;
+}
+
+void test_rle_round_trip() {
+  // Short runs between literals
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, i < 20 ? 10 : i / 2, 0, i % 5 == 0 ? 200 : 0 ) ;
+  roundTrip( FC_RLE, NULL ) ;
+
+  fillNoise( frame, 2 ) ;   // all literals, in blocks of FC_MAX_RUN
+  roundTrip( FC_RLE, NULL ) ;
+}
+
+void test_rle_solid_frame_is_a_few_runs() {
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, 1, 2, 3 ) ;
+  TEST_ASSERT_EQUAL_UINT16( 1 + 4 * ( ( LEDS + FC_MAX_RUN - 1 ) / FC_MAX_RUN ), FrameCodec::encodeAs( FC_RLE, frame, NULL, LEDS, NULL, 0 ) ) ;
+  roundTrip( FC_RLE, NULL ) ;
+}
+
+void test_delta_round_trip() {
+  fillNoise( prev, 3 ) ;
+  memcpy( frame, prev, sizeof(frame) ) ;
+  setPixel( frame, 0, 1, 1, 1 ) ;
+  setPixel( frame, 131, 2, 2, 2 ) ;
+  setPixel( frame, LEDS - 1, 3, 3, 3 ) ;
+  roundTrip( FC_DELTA, prev ) ;
+}
+
+void test_delta_needs_a_previous_frame() {
+  TEST_ASSERT_EQUAL_UINT16( 0, FrameCodec::encodeAs( FC_DELTA, frame, NULL, LEDS, packet, sizeof(packet) ) ) ;
+}
+
+void test_palette_round_trip() {
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, ( i % 16 ) * 16, i % 2 ? 255 : 0, 7 ) ;
+  roundTrip( FC_PALETTE, NULL ) ;
+}
+
+void test_palette_gives_up_past_16_colours() {
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, i % 17, 0, 0 ) ;
+  TEST_ASSERT_EQUAL_UINT16( 0, FrameCodec::encodeAs( FC_PALETTE, frame, NULL, LEDS, NULL, 0 ) ) ;
+}
+
+void test_encode_picks_the_smallest() {
+  fillNoise( prev, 4 ) ;
+  memcpy( frame, prev, sizeof(frame) ) ;
+  setPixel( frame, 10, 0, 0, 0 ) ;
+
+  uint16_t len = FrameCodec::encode( frame, prev, LEDS, packet, sizeof(packet) ) ;
+  const uint8_t types[] = { FC_RAW, FC_RLE, FC_DELTA, FC_PALETTE } ;
+  for ( uint8_t t = 0 ; t < sizeof(types) ; t++ ) {
+    uint16_t size = FrameCodec::encodeAs( types[t], frame, prev, LEDS, NULL, 0 ) ;
+    if ( size ) TEST_ASSERT_LESS_OR_EQUAL( size, len ) ;
+  }
+  TEST_ASSERT_EQUAL_UINT8( FC_DELTA, packet[0] ) ;
+}
+
+void test_encode_fails_when_out_is_too_small() {
+  fillNoise( frame, 5 ) ;
+  TEST_ASSERT_EQUAL_UINT16( 0, FrameCodec::encodeAs( FC_RAW, frame, NULL, LEDS, packet, LEDS * 3 ) ) ;
+}
+
+void test_bad_packets_leave_the_frame_alone() {
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, i, i, i ) ;
+  fillNoise( out, 6 ) ;
+  uint8_t before[LEDS * 3] ;
+  memcpy( before, out, sizeof(before) ) ;
+
+  uint16_t len = FrameCodec::encodeAs( FC_RLE, frame, NULL, LEDS, packet, sizeof(packet) ) ;
+  TEST_ASSERT_FALSE( FrameCodec::decode( packet, len - 1, out, LEDS ) ) ;   // truncated
+  TEST_ASSERT_FALSE( FrameCodec::decode( packet, len, out, LEDS - 1 ) ) ;   // too many LEDs
+  packet[0] = 0x7F ;
+  TEST_ASSERT_FALSE( FrameCodec::decode( packet, len, out, LEDS ) ) ;       // unknown type
+  TEST_ASSERT_FALSE( FrameCodec::decode( packet, 0, out, LEDS ) ) ;
+
+  // A palette index past the palette
+  for ( uint16_t i = 0 ; i < LEDS ; i++ ) setPixel( frame, i, i % 2, 0, 0 ) ;
+  len = FrameCodec::encodeAs( FC_PALETTE, frame, NULL, LEDS, packet, sizeof(packet) ) ;
+  packet[len - 1] = 0xFF ;
+  TEST_ASSERT_FALSE( FrameCodec::decode( packet, len, out, LEDS ) ) ;
+
+  TEST_ASSERT_EQUAL_UINT8_ARRAY( before, out, LEDS * 3 ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_raw_round_trip ) ;
+  RUN_TEST( test_rle_round_trip ) ;
+  RUN_TEST( test_rle_solid_frame_is_a_few_runs ) ;
+  RUN_TEST( test_delta_round_trip ) ;
+  RUN_TEST( test_delta_needs_a_previous_frame ) ;
+  RUN_TEST( test_palette_round_trip ) ;
+  RUN_TEST( test_palette_gives_up_past_16_colours ) ;
+  RUN_TEST( test_encode_picks_the_smallest ) ;
+  RUN_TEST( test_encode_fails_when_out_is_too_small ) ;
+  RUN_TEST( test_bad_packets_leave_the_frame_alone ) ;
+  return UNITY_END() ;
+}
@@ -0,0 +1,86 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <KeyframeCurve.h>
+
+static constexpr Keyframe peakKeys[] = { { 0, 0, EASE_LINEAR }, { 128, 255, EASE_LINEAR }, { 256, 0, EASE_LINEAR } } ;
+static constexpr uint8_t peak[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( peakKeys ) ;
+
+static constexpr Keyframe easeInKeys[] = { { 0, 0, EASE_IN }, { 256, 255, EASE_LINEAR } } ;
+static constexpr uint8_t easeIn[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( easeInKeys ) ;
+
+static constexpr Keyframe easeOutKeys[] = { { 0, 0, EASE_OUT }, { 256, 255, EASE_LINEAR } } ;
+static constexpr uint8_t easeOut[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( easeOutKeys ) ;
+
+static constexpr Keyframe fallKeys[] = { { 0, 200, EASE_IN_OUT }, { 256, 10, EASE_LINEAR } } ;
+static constexpr uint8_t fall[KEYFRAME_STEPS + 1] PROGMEM = KEYFRAME_TABLE( fallKeys ) ;
+
+void setUp() {}
+void tearDown() {}
+
+
+void test_table_hits_the_keyframes() {
+  TEST_ASSERT_EQUAL_UINT8( 0, peak[0] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 255, peak[KEYFRAME_STEPS / 2] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, peak[KEYFRAME_STEPS] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 200, fall[0] ) ;
+  TEST_ASSERT_EQUAL_UINT8( 10, fall[KEYFRAME_STEPS] ) ;
+}
+
+void test_linear_segments_are_straight() {
+  for ( uint8_t i = 0 ; i <= KEYFRAME_STEPS / 2 ; i++ ) {
+    TEST_ASSERT_UINT8_WITHIN( 1, i * 255 / ( KEYFRAME_STEPS / 2 ), peak[i] ) ;
+    TEST_ASSERT_UINT8_WITHIN( 1, peak[i], peak[KEYFRAME_STEPS - i] ) ;   // mirrored, to rounding
+  }
+}
+
+void test_eases_bend_the_right_way() {
+  uint8_t mid = KEYFRAME_STEPS / 2 ;
+  TEST_ASSERT_LESS_THAN( 128 - 32, easeIn[mid] ) ;
+  TEST_ASSERT_GREATER_THAN( 128 + 32, easeOut[mid] ) ;
+  TEST_ASSERT_UINT8_WITHIN( 2, 105, fall[mid] ) ;   // in-out passes the middle on the straight line
+  for ( uint8_t i = 0 ; i < KEYFRAME_STEPS ; i++ ) {
+    TEST_ASSERT_TRUE( easeIn[i] <= easeIn[i + 1] ) ;
+    TEST_ASSERT_TRUE( easeOut[i] <= easeOut[i + 1] ) ;
+    TEST_ASSERT_TRUE( fall[i] >= fall[i + 1] ) ;
+  }
+}
+
+void test_phase_splits_into_step_and_fraction() {
+  CurvePhase p = curvePhase( 0 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, p.step ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, p.frac ) ;
+
+  p = curvePhase( 512 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, p.step ) ;
+  TEST_ASSERT_EQUAL_UINT8( 128, p.frac ) ;
+
+  p = curvePhase( 3 * 1024 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 3, p.step ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, p.frac ) ;
+
+  p = curvePhase( 65535 ) ;
+  TEST_ASSERT_EQUAL_UINT8( KEYFRAME_STEPS - 1, p.step ) ;
+  TEST_ASSERT_EQUAL_UINT8( 255, p.frac ) ;
+}
+
+void test_sample_interpolates_between_steps() {
+  for ( uint8_t i = 0 ; i < KEYFRAME_STEPS ; i++ ) {
+    TEST_ASSERT_EQUAL_UINT8( peak[i], curveSample( peak, curvePhase( i * 1024 ) ) ) ;
+    uint8_t half = curveSample( peak, curvePhase( i * 1024 + 512 ) ) ;
+    TEST_ASSERT_UINT8_WITHIN( 1, ( peak[i] + peak[i + 1] ) / 2, half ) ;
+  }
+  // The last step runs up to, but not past, the end of the table
+  TEST_ASSERT_UINT8_WITHIN( 1, peak[KEYFRAME_STEPS], curveSample( peak, curvePhase( 65535 ) ) ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_table_hits_the_keyframes ) ;
+  RUN_TEST( test_linear_segments_are_straight ) ;
+  RUN_TEST( test_eases_bend_the_right_way ) ;
+  RUN_TEST( test_phase_splits_into_step_and_fraction ) ;
+  RUN_TEST( test_sample_interpolates_between_steps ) ;
+  return UNITY_END() ;
+}
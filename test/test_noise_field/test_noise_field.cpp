@@ -0,0 +1,134 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <NoiseField.h>
+
+#include <stdio.h>
+#include <time.h>
+
+uint8_t out[255] ;
+uint32_t seed = 1 ;
+
+void setUp() {}
+void tearDown() {}
+
+uint16_t nextRandom() {
+  seed = seed * 1103515245 + 12345 ;
+  return seed >> 16 ;
+}
+
+// inoise8(), spelled out from the raw -64..64 value
+uint8_t expected( uint16_t x, uint16_t y, uint16_t z ) {
+  int8_t n = inoise8_raw( x, y, z ) + 64 ;
+  return qadd8( n, n ) ;
+}
+
+
+void test_strip_matches_inoise8_raw() {
+  NoiseField field ;
+  field.setOctaves( 1 ) ;
+  for ( uint16_t n = 0 ; n < 500 ; n++ ) {
+    uint16_t x = nextRandom(), y = nextRandom(), z = nextRandom() ;
+    // From within one lattice cell to several cells per LED
+    uint16_t scale = n % 4 == 0 ? nextRandom() : nextRandom() % 300 ;
+    uint8_t numLeds = 1 + nextRandom() % 255 ;
+    field.fillStrip( out, numLeds, x, scale, y, z ) ;
+    for ( uint8_t i = 0 ; i < numLeds ; i++ ) {
+      TEST_ASSERT_EQUAL_UINT8( expected( x + scale * i, y, z ), out[i] ) ;
+    }
+  }
+}
+
+void test_strip_across_the_wrap() {
+  NoiseField field ;
+  field.setOctaves( 1 ) ;
+  field.fillStrip( out, 100, 65535 - 40 * 20, 20, 0xFF80, 0xFFFF ) ;
+  for ( uint8_t i = 0 ; i < 100 ; i++ ) {
+    TEST_ASSERT_EQUAL_UINT8( expected( 65535 - 40 * 20 + 20 * i, 0xFF80, 0xFFFF ), out[i] ) ;
+  }
+}
+
+void test_octaves_add_at_half_the_weight() {
+  NoiseField field ;
+  field.setOctaves( 3 ) ;
+  uint16_t x = 1234, y = 5678, z = 9012, scale = 37 ;
+  field.fillStrip( out, 60, x, scale, y, z ) ;
+  for ( uint8_t i = 0 ; i < 60 ; i++ ) {
+    uint8_t sum = expected( x + scale * i, y, z ) ;
+    for ( uint8_t o = 1 ; o < 3 ; o++ ) {
+      uint16_t xo = x << o, so = scale << o ;
+      sum = qadd8( sum, expected( xo + so * i, y << o, z ) >> o ) ;
+    }
+    TEST_ASSERT_EQUAL_UINT8( sum, out[i] ) ;
+  }
+}
+
+void test_field_rows_step_in_y() {
+  NoiseField field ;
+  field.setOctaves( 1 ) ;
+  uint8_t width = 17, height = 5 ;
+  field.fillField( out, width, height, 300, 90, 4000, 700, 123 ) ;
+  for ( uint8_t row = 0 ; row < height ; row++ ) {
+    for ( uint8_t i = 0 ; i < width ; i++ ) {
+      TEST_ASSERT_EQUAL_UINT8( expected( 300 + 90 * i, 4000 + 700 * row, 123 ), out[row * width + i] ) ;
+    }
+  }
+}
+
+void test_octaves_are_clamped() {
+  NoiseField field ;
+  field.setOctaves( 0 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 1, field.getOctaves() ) ;
+  field.setOctaves( 12 ) ;
+  TEST_ASSERT_EQUAL_UINT8( 8, field.getOctaves() ) ;
+}
+
+double seconds() {
+  struct timespec t ;
+  clock_gettime( CLOCK_MONOTONIC, &t ) ;
+  return t.tv_sec + t.tv_nsec / 1e9 ;
+}
+
+// A hoop's worth of LEDs at the noise routines' scale, as fillnoise8() draws
+// them each frame; the host's numbers only say how the two compare
+#define TIMED_LEDS 139
+#define TIMED_FRAMES 2000
+
+void test_strip_timing_against_inoise8() {
+  NoiseField field ;
+  field.setOctaves( 1 ) ;
+  uint16_t x = 1000, y = 2000, z = 3000, scale = 30 ;
+  uint32_t sum = 0 ;
+
+  double start = seconds() ;
+  for ( uint16_t f = 0 ; f < TIMED_FRAMES ; f++ ) {
+    for ( uint8_t i = 0 ; i < TIMED_LEDS ; i++ ) out[i] = inoise8( x + f + scale * i, y, z + f ) ;
+    sum += out[TIMED_LEDS - 1] ;
+  }
+  double perPixel = ( seconds() - start ) / TIMED_FRAMES ;
+
+  start = seconds() ;
+  for ( uint16_t f = 0 ; f < TIMED_FRAMES ; f++ ) {
+    field.fillStrip( out, TIMED_LEDS, x + f, scale, y, z + f ) ;
+    sum -= out[TIMED_LEDS - 1] ;
+  }
+  double strip = ( seconds() - start ) / TIMED_FRAMES ;
+
+  char msg[80] ;
+  snprintf( msg, sizeof(msg), "%d LEDs: inoise8 %.1f us, fillStrip %.1f us a frame (%.1fx)",
+            TIMED_LEDS, perPixel * 1e6, strip * 1e6, perPixel / strip ) ;
+  TEST_MESSAGE( msg ) ;
+  TEST_ASSERT_EQUAL_UINT32( 0, sum ) ;   // same last pixel every frame, and nothing optimised away
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_strip_matches_inoise8_raw ) ;
+  RUN_TEST( test_strip_across_the_wrap ) ;
+  RUN_TEST( test_octaves_add_at_half_the_weight ) ;
+  RUN_TEST( test_field_rows_step_in_y ) ;
+  RUN_TEST( test_octaves_are_clamped ) ;
+  RUN_TEST( test_strip_timing_against_inoise8 ) ;
+  return UNITY_END() ;
+}
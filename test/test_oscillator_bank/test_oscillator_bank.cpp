@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <OscillatorBank.h>
+
+// beat88()'s 280 is a touch over 2^32 / 60000 / 256, so a beat comes out 0.14% long
+#define PHASE_SLACK 200
+
+OscillatorBank osc ;
+
+void setUp() {
+  osc = OscillatorBank() ;
+}
+
+void tearDown() {}
+
+// Distance between two phases, the short way round
+uint16_t apart( uint16_t a, uint16_t b ) {
+  uint16_t d = a - b ;
+  return d < 32768 ? d : -d ;
+}
+
+
+void test_saw_runs_once_a_beat() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW ) ;
+  osc.advance( 250, 120 * 256 ) ;      // half a beat at 120 BPM
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 32768, osc.value16( 0 ) ) ;
+  osc.advance( 500, 120 * 256 ) ;
+  TEST_ASSERT_LESS_OR_EQUAL( PHASE_SLACK, apart( osc.value16( 0 ), 0 ) ) ;
+}
+
+void test_rate_is_num_over_den() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 2, WAVE_SAW ) ;
+  osc.set( 1, 3, 1, WAVE_SAW ) ;
+  osc.advance( 100, 120 * 256 ) ;      // a fifth of a beat
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 65536 / 10, osc.value16( 0 ) ) ;
+  TEST_ASSERT_LESS_OR_EQUAL( PHASE_SLACK, apart( osc.value16( 1 ), 65536 * 3 / 5 ) ) ;
+}
+
+void test_set_starts_at_the_phase_asked_for() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW, 16384 ) ;
+  TEST_ASSERT_EQUAL_UINT16( 16384, osc.value16( 0 ) ) ;
+
+  // Setting it again every frame doesn't restart it
+  osc.advance( 125, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW, 16384 ) ;
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 32768, osc.value16( 0 ) ) ;
+}
+
+void test_new_tempo_doesnt_jump() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW ) ;
+  osc.advance( 250, 120 * 256 ) ;
+  uint16_t before = osc.value16( 0 ) ;
+
+  osc.advance( 250, 60 * 256 ) ;       // tapped, no time passed
+  TEST_ASSERT_EQUAL_UINT16( before, osc.value16( 0 ) ) ;
+
+  osc.advance( 750, 60 * 256 ) ;       // half a beat at the new tempo
+  TEST_ASSERT_LESS_OR_EQUAL( PHASE_SLACK, apart( osc.value16( 0 ), before + 32768 ) ) ;
+}
+
+void test_new_rate_on_a_set_slot() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW ) ;
+  osc.advance( 125, 120 * 256 ) ;      // a quarter of a beat
+  osc.set( 0, 1, 1, WAVE_SAW ) ;       // same again: nothing changes
+  osc.set( 0, 2, 1, WAVE_SAW ) ;       // twice as fast from here
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 16384, osc.value16( 0 ) ) ;
+  osc.advance( 250, 120 * 256 ) ;      // another quarter, at double rate
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 49152, osc.value16( 0 ) ) ;
+}
+
+void test_fast_tempos_dont_wrap() {
+  osc.advance( 0, 300 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW ) ;
+  osc.advance( 100, 300 * 256 ) ;      // half a beat at 300 BPM
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 32768, osc.value16( 0 ) ) ;
+}
+
+void test_reset_goes_back_to_the_start() {
+  osc.advance( 0, 120 * 256 ) ;
+  osc.set( 0, 1, 1, WAVE_SAW, 1000 ) ;
+  osc.set( 1, 1, 4, WAVE_TRIANGLE ) ;
+  osc.advance( 333, 120 * 256 ) ;
+  osc.reset( 1000 ) ;
+  TEST_ASSERT_EQUAL_UINT16( 1000, osc.value16( 0 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( 0, osc.value16( 1 ) ) ;
+
+  osc.advance( 1250, 120 * 256 ) ;     // counts from the reset, not from 333
+  TEST_ASSERT_UINT16_WITHIN( PHASE_SLACK, 1000 + 32768, osc.value16( 0 ) ) ;
+}
+
+void test_waveforms() {
+  osc.set( 0, 1, 1, WAVE_SINE, 16384 ) ;
+  osc.set( 1, 1, 1, WAVE_TRIANGLE, 16384 ) ;
+  osc.set( 2, 1, 1, WAVE_SQUARE, 16384 ) ;
+  osc.set( 3, 1, 1, WAVE_SQUARE, 49152 ) ;
+  osc.set( 4, 1, 1, WAVE_SINE ) ;
+  TEST_ASSERT_GREATER_THAN( 65000, osc.value16( 0 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( 32768, osc.value16( 1 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( 65535, osc.value16( 2 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( 0, osc.value16( 3 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( 32768, osc.value16( 4 ) ) ;
+
+  TEST_ASSERT_EQUAL_UINT8( 10 + scale8( osc.value8( 1 ), 10 ), osc.range8( 1, 10, 20 ) ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_saw_runs_once_a_beat ) ;
+  RUN_TEST( test_rate_is_num_over_den ) ;
+  RUN_TEST( test_set_starts_at_the_phase_asked_for ) ;
+  RUN_TEST( test_new_tempo_doesnt_jump ) ;
+  RUN_TEST( test_new_rate_on_a_set_slot ) ;
+  RUN_TEST( test_fast_tempos_dont_wrap ) ;
+  RUN_TEST( test_reset_goes_back_to_the_start ) ;
+  RUN_TEST( test_waveforms ) ;
+  return UNITY_END() ;
+}
@@ -0,0 +1,110 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <FastLED.h>
+#include <PowerLimiter.h>
+
+#define LEDS 60
+
+CRGB leds[LEDS] ;
+CRGB black[LEDS] ;
+
+// mA * 255 of one white LED at full brightness
+#define WHITE_WEIGHT ( 255 * ( POWER_MA_RED + POWER_MA_GREEN + POWER_MA_BLUE ) )
+
+void fill( CRGB* l, const CRGB& c ) {
+  for ( uint8_t i = 0 ; i < LEDS ; i++ ) l[i] = c ;
+}
+
+void setUp() {
+  fill( leds, CRGB( 0, 0, 0 ) ) ;
+  fill( black, CRGB( 0, 0, 0 ) ) ;
+}
+
+void tearDown() {}
+
+
+void test_estimate_weighs_each_channel() {
+  TEST_ASSERT_EQUAL_UINT32( 0, PowerLimiter::estimate( leds, LEDS ) ) ;
+
+  leds[0] = CRGB( 255, 0, 0 ) ;
+  TEST_ASSERT_EQUAL_UINT32( 255 * POWER_MA_RED, PowerLimiter::estimate( leds, LEDS ) ) ;
+  leds[1] = CRGB( 0, 255, 0 ) ;
+  leds[2] = CRGB( 0, 0, 128 ) ;
+  TEST_ASSERT_EQUAL_UINT32( 255 * POWER_MA_RED + 255 * POWER_MA_GREEN + 128 * POWER_MA_BLUE, PowerLimiter::estimate( leds, LEDS ) ) ;
+
+  fill( leds, CRGB( 255, 255, 255 ) ) ;
+  TEST_ASSERT_EQUAL_UINT32( (uint32_t) LEDS * WHITE_WEIGHT, PowerLimiter::estimate( leds, LEDS ) ) ;
+  TEST_ASSERT_EQUAL_UINT32( 10 * WHITE_WEIGHT, PowerLimiter::estimate( leds, 10 ) ) ;
+}
+
+void test_under_budget_keeps_the_brightness() {
+  PowerLimiter power ;
+  power.begin( LEDS, 5000 ) ;
+  fill( leds, CRGB( 255, 0, 0 ) ) ;
+  TEST_ASSERT_EQUAL_UINT8( 200, power.limit( leds, 200 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( LEDS * POWER_MA_IDLE + (uint32_t) LEDS * 255 * POWER_MA_RED * 200 / 65025, power.lastMa() ) ;
+}
+
+void test_over_budget_drops_at_once() {
+  PowerLimiter power ;
+  power.begin( LEDS, 1000 ) ;
+  fill( leds, CRGB( 255, 255, 255 ) ) ;
+  uint8_t b = power.limit( leds, 255 ) ;
+  TEST_ASSERT_LESS_THAN( 255, b ) ;
+  TEST_ASSERT_LESS_OR_EQUAL( 1000, power.lastMa() ) ;
+  // and not by much more than it has to
+  TEST_ASSERT_GREATER_THAN( 1000 - 20, power.lastMa() ) ;
+}
+
+void test_comes_back_up_gently() {
+  PowerLimiter power ;
+  power.begin( LEDS, 1000 ) ;
+  fill( leds, CRGB( 255, 255, 255 ) ) ;
+  uint8_t low = power.limit( leds, 255 ) ;
+
+  uint8_t last = low ;
+  uint8_t frames = 0 ;
+  while ( last < 255 ) {
+    uint8_t b = power.limit( black, 255 ) ;
+    TEST_ASSERT_GREATER_THAN( last, b ) ;
+    TEST_ASSERT_LESS_OR_EQUAL( ( 255 - last + 7 ) / 8, b - last ) ;
+    last = b ;
+    frames++ ;
+  }
+  TEST_ASSERT_GREATER_THAN( 4, frames ) ;
+}
+
+void test_budget_below_idle_goes_dark() {
+  PowerLimiter power ;
+  power.begin( LEDS, LEDS * POWER_MA_IDLE / 2 ) ;
+  fill( leds, CRGB( 10, 10, 10 ) ) ;
+  TEST_ASSERT_EQUAL_UINT8( 0, power.limit( leds, 255 ) ) ;
+}
+
+void test_solid_frame_matches_the_full_pass() {
+  PowerLimiter full, solid ;
+  full.begin( LEDS, 800 ) ;
+  solid.begin( LEDS, 800 ) ;
+  CRGB c( 200, 100, 50 ) ;
+  fill( leds, c ) ;
+
+  solid.solidFrame( c ) ;
+  TEST_ASSERT_EQUAL_UINT8( full.limit( leds, 255 ), solid.limit( black, 255 ) ) ;
+  TEST_ASSERT_EQUAL_UINT16( full.lastMa(), solid.lastMa() ) ;
+
+  // Only for the one frame
+  solid.limit( black, 255 ) ;
+  TEST_ASSERT_EQUAL_UINT16( LEDS * POWER_MA_IDLE, solid.lastMa() ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_estimate_weighs_each_channel ) ;
+  RUN_TEST( test_under_budget_keeps_the_brightness ) ;
+  RUN_TEST( test_over_budget_drops_at_once ) ;
+  RUN_TEST( test_comes_back_up_gently ) ;
+  RUN_TEST( test_budget_below_idle_goes_dark ) ;
+  RUN_TEST( test_solid_frame_matches_the_full_pass ) ;
+  return UNITY_END() ;
+}
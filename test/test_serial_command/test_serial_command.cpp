@@ -0,0 +1,326 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <SerialCommand.h>
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <time.h>
+
+#define FRAME_LEDS 139                   // a hoop's worth: 417 bytes of payload
+#define FRAME_BYTES ( FRAME_LEDS * 3 )
+
+// What the host side of the link needs: 60 fps of full frames
+#define MIN_FPS 60
+
+// Bytes in from a buffer, bytes out to another
+class BufferStream : public Stream {
+  public:
+    uint8_t in[2048] ;
+    uint16_t inLen = 0, inPos = 0 ;
+    uint8_t out[2048] ;
+    uint16_t outLen = 0 ;
+
+    int available() { return inLen - inPos ; }
+    int read() { return inPos < inLen ? in[inPos++] : -1 ; }
+    size_t write( const uint8_t* buf, size_t len ) {
+      memcpy( out + outLen, buf, len ) ;
+      outLen += len ;
+      return len ;
+    }
+} ;
+
+// The device end of a pseudo terminal, in raw mode like a USB serial port
+class FdStream : public Stream {
+  public:
+    int fd = -1 ;
+
+    int available() {
+      int n = 0 ;
+      ioctl( fd, FIONREAD, &n ) ;
+      return n ;
+    }
+    int read() {
+      uint8_t c ;
+      return ::read( fd, &c, 1 ) == 1 ? c : -1 ;
+    }
+    size_t write( const uint8_t* buf, size_t len ) {
+      size_t done = 0 ;
+      while ( done < len ) {
+        ssize_t n = ::write( fd, buf + done, len - done ) ;
+        if ( n > 0 ) done += n ;
+      }
+      return len ;
+    }
+} ;
+
+SerialCommand cmd ;
+BufferStream buffer ;
+
+uint8_t sinkBuffer[FRAME_BYTES] ;
+uint16_t executed ;
+uint8_t lastCmd ;
+uint16_t lastLen ;
+uint8_t payloadErrors ;
+uint8_t frameSeq ;                       // seq of the next SC_CMD_FRAME, which run in order
+
+// Every payload byte is a function of seq and position, so a frame can be checked on arrival
+uint8_t pattern( uint8_t seq, uint16_t i ) {
+  return seq * 31 + i * 7 + ( i >> 8 ) ;
+}
+
+uint8_t onCommand( uint8_t c, const uint8_t* payload, uint16_t len ) {
+  executed++ ;
+  lastCmd = c ;
+  lastLen = len ;
+  if ( c == SC_CMD_FRAME ) {
+    for ( uint16_t i = 0 ; i < len ; i++ ) {
+      if ( payload[i] != pattern( frameSeq, i ) ) payloadErrors++ ;
+    }
+    frameSeq++ ;
+  }
+  return c == 0x7F ? SC_ERR_COMMAND : SC_OK ;
+}
+
+bool onText( const char* name, const char* arg ) {
+  return strcmp( name, "mode" ) == 0 && strcmp( arg, "3" ) == 0 ;
+}
+
+uint8_t* sink( uint8_t c, uint16_t len ) {
+  return c == SC_CMD_FRAME && len == FRAME_BYTES ? sinkBuffer : NULL ;
+}
+
+// Build a frame into buf, return its length
+uint16_t frame( uint8_t* buf, uint8_t seq, uint8_t c, const uint8_t* payload, uint16_t len ) {
+  uint16_t n = 0 ;
+  buf[n++] = SC_SOF ;
+  buf[n++] = seq ;
+  buf[n++] = c ;
+  buf[n++] = len & 0xFF ;
+  buf[n++] = len >> 8 ;
+  memcpy( buf + n, payload, len ) ;
+  n += len ;
+  uint16_t crc = 0xFFFF ;
+  for ( uint16_t i = 1 ; i < n ; i++ ) crc = SerialCommand::crc16( crc, buf[i] ) ;
+  buf[n++] = crc & 0xFF ;
+  buf[n++] = crc >> 8 ;
+  return n ;
+}
+
+uint16_t patternFrame( uint8_t* buf, uint8_t seq ) {
+  uint8_t payload[FRAME_BYTES] ;
+  for ( uint16_t i = 0 ; i < FRAME_BYTES ; i++ ) payload[i] = pattern( seq, i ) ;
+  return frame( buf, seq, SC_CMD_FRAME, payload, FRAME_BYTES ) ;
+}
+
+void send( const uint8_t* buf, uint16_t len ) {
+  memcpy( buffer.in + buffer.inLen, buf, len ) ;
+  buffer.inLen += len ;
+  cmd.poll() ;
+}
+
+void sendFrame( uint8_t seq, uint8_t c, const uint8_t* payload, uint16_t len ) {
+  uint8_t buf[64] ;
+  send( buf, frame( buf, seq, c, payload, len ) ) ;
+}
+
+// Is there an ack at 'at' in the output, for seq/cmd, with this status?
+bool isAck( const uint8_t* at, uint8_t seq, uint8_t c, uint8_t status ) {
+  uint16_t crc = 0xFFFF ;
+  for ( uint8_t i = 1 ; i < 6 ; i++ ) crc = SerialCommand::crc16( crc, at[i] ) ;
+  return at[0] == SC_SOF && at[1] == seq && at[2] == ( c | SC_REPLY ) && at[3] == 1 && at[4] == 0
+      && at[5] == status && at[6] == ( crc & 0xFF ) && at[7] == crc >> 8 ;
+}
+
+void setUp() {
+  cmd = SerialCommand() ;
+  buffer = BufferStream() ;
+  cmd.begin( &buffer, onCommand, onText, sink ) ;
+  hostMillis = 1000 ;
+  executed = 0 ;
+  payloadErrors = 0 ;
+  frameSeq = 0 ;
+}
+
+void tearDown() {}
+
+
+void test_frame_is_executed_and_acked() {
+  uint8_t b = 40 ;
+  sendFrame( 1, SC_CMD_SET_BRIGHTNESS, &b, 1 ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+  TEST_ASSERT_EQUAL_UINT8( SC_CMD_SET_BRIGHTNESS, lastCmd ) ;
+  TEST_ASSERT_EQUAL( 8, buffer.outLen ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out, 1, SC_CMD_SET_BRIGHTNESS, SC_OK ) ) ;
+
+  sendFrame( 2, 0x7F, NULL, 0 ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out + 8, 2, 0x7F, SC_ERR_COMMAND ) ) ;
+}
+
+void test_bad_crc_is_not_executed() {
+  uint8_t buf[16], b = 40 ;
+  uint16_t n = frame( buf, 1, SC_CMD_SET_BRIGHTNESS, &b, 1 ) ;
+  buf[5] ^= 1 ;
+  send( buf, n ) ;
+  TEST_ASSERT_EQUAL( 0, executed ) ;
+  TEST_ASSERT_EQUAL( 1, cmd.getCrcErrors() ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out, 1, SC_CMD_SET_BRIGHTNESS, SC_ERR_CRC ) ) ;
+}
+
+void test_retransmit_is_acked_not_executed() {
+  sendFrame( 7, 0x7F, NULL, 0 ) ;
+  sendFrame( 7, 0x7F, NULL, 0 ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+  // Answered with what the first one answered
+  TEST_ASSERT_TRUE( isAck( buffer.out + 8, 7, 0x7F, SC_ERR_COMMAND ) ) ;
+}
+
+void test_same_seq_new_frame_is_executed() {
+  uint8_t a = 10, b = 20 ;
+  sendFrame( 9, SC_CMD_SET_BRIGHTNESS, &a, 1 ) ;
+  sendFrame( 9, SC_CMD_SET_MODE, &a, 1 ) ;           // other command
+  sendFrame( 9, SC_CMD_SET_MODE, &b, 1 ) ;           // other payload
+  TEST_ASSERT_EQUAL( 3, executed ) ;
+}
+
+void test_stalled_frame_is_dropped() {
+  uint8_t buf[16], b = 40 ;
+  uint16_t n = frame( buf, 3, SC_CMD_SET_BRIGHTNESS, &b, 1 ) ;
+  send( buf, 4 ) ;                                   // host gives up half way
+  hostMillis += SC_TIMEOUT_MS + 1 ;
+
+  send( buf, n ) ;                                   // and starts over
+  TEST_ASSERT_EQUAL( 1, cmd.getTimeouts() ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+  TEST_ASSERT_EQUAL( 8, buffer.outLen ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out, 3, SC_CMD_SET_BRIGHTNESS, SC_OK ) ) ;
+}
+
+void test_slow_frame_within_the_timeout_is_kept() {
+  uint8_t buf[16], b = 40 ;
+  uint16_t n = frame( buf, 3, SC_CMD_SET_BRIGHTNESS, &b, 1 ) ;
+  for ( uint16_t i = 0 ; i < n ; i++ ) {
+    send( buf + i, 1 ) ;
+    hostMillis += SC_TIMEOUT_MS ;
+  }
+  TEST_ASSERT_EQUAL( 0, cmd.getTimeouts() ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+}
+
+void test_sink_takes_large_payloads() {
+  uint8_t buf[FRAME_BYTES + 7] ;
+  frameSeq = 5 ;
+  send( buf, patternFrame( buf, 5 ) ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+  TEST_ASSERT_EQUAL( FRAME_BYTES, lastLen ) ;
+  TEST_ASSERT_EQUAL( 0, payloadErrors ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out, 5, SC_CMD_FRAME, SC_OK ) ) ;
+
+  // Too long for the internal buffer and not taken by the sink
+  uint8_t big[SC_MAX_PAYLOAD + 1] = { 0 } ;
+  send( buf, frame( buf, 6, SC_CMD_PALETTE, big, sizeof(big) ) ) ;
+  TEST_ASSERT_EQUAL( 1, executed ) ;
+  TEST_ASSERT_TRUE( isAck( buffer.out + 8, 6, SC_CMD_PALETTE, SC_ERR_LENGTH ) ) ;
+}
+
+void test_text_commands() {
+  send( (const uint8_t*) "mode 3\n", 7 ) ;
+  send( (const uint8_t*) "mode 4\r\n", 8 ) ;
+  buffer.out[buffer.outLen] = 0 ;
+  TEST_ASSERT_EQUAL_STRING( "ok\r\nerr\r\n", (const char*) buffer.out ) ;
+}
+
+
+double seconds() {
+  struct timespec t ;
+  clock_gettime( CLOCK_MONOTONIC, &t ) ;
+  return t.tv_sec + t.tv_nsec / 1e9 ;
+}
+
+// Full frames through a pty, up to 'window' of them in flight; returns frames per second
+double loopback( uint16_t frames, uint8_t window ) {
+  int host = posix_openpt( O_RDWR | O_NOCTTY ) ;
+  if ( host < 0 || grantpt( host ) || unlockpt( host ) ) return 0 ;
+  FdStream device ;
+  device.fd = open( ptsname( host ), O_RDWR | O_NOCTTY ) ;
+  struct termios tio ;
+  tcgetattr( device.fd, &tio ) ;
+  cfmakeraw( &tio ) ;
+  tcsetattr( device.fd, TCSANOW, &tio ) ;
+  fcntl( host, F_SETFL, O_NONBLOCK ) ;
+
+  cmd.begin( &device, onCommand, onText, sink ) ;
+  frameSeq = 0 ;
+
+  static uint8_t buf[FRAME_BYTES + 7] ;
+  uint16_t sent = 0, acked = 0, len = 0, pos = 0 ;
+  uint8_t ack[8] ;
+  uint8_t ackPos = 0 ;
+  double start = seconds() ;
+
+  while ( acked < frames && seconds() - start < 10 ) {
+    // Host: start the next frame when the window allows, push what fits
+    if ( pos == len && sent < frames && sent - acked < window ) {
+      len = patternFrame( buf, sent ) ;
+      pos = 0 ;
+      sent++ ;
+    }
+    if ( pos < len ) {
+      ssize_t n = write( host, buf + pos, len - pos ) ;
+      if ( n > 0 ) pos += n ;
+    }
+
+    // Device
+    cmd.poll() ;
+
+    // Host: collect acks, in order
+    ssize_t n = read( host, ack + ackPos, 8 - ackPos ) ;
+    if ( n > 0 ) ackPos += n ;
+    if ( ackPos == 8 ) {
+      if ( ! isAck( ack, acked, SC_CMD_FRAME, SC_OK ) ) break ;
+      acked++ ;
+      ackPos = 0 ;
+    }
+  }
+  double elapsed = seconds() - start ;
+
+  close( device.fd ) ;
+  close( host ) ;
+  return acked == frames ? frames / elapsed : 0 ;
+}
+
+void test_pty_loopback_throughput() {
+  char msg[80] ;
+
+  double fps = loopback( 200, 1 ) ;
+  snprintf( msg, sizeof(msg), "stop and wait: %.0f fps, %.0f KB/s", fps, fps * ( FRAME_BYTES + 7 ) / 1024 ) ;
+  TEST_MESSAGE( msg ) ;
+  TEST_ASSERT_EQUAL( 200, executed ) ;
+  TEST_ASSERT_EQUAL( 0, payloadErrors ) ;
+  TEST_ASSERT_GREATER_OR_EQUAL( MIN_FPS, fps ) ;
+
+  fps = loopback( 200, 4 ) ;
+  snprintf( msg, sizeof(msg), "4 in flight: %.0f fps, %.0f KB/s", fps, fps * ( FRAME_BYTES + 7 ) / 1024 ) ;
+  TEST_MESSAGE( msg ) ;
+  TEST_ASSERT_EQUAL( 400, executed ) ;
+  TEST_ASSERT_EQUAL( 0, payloadErrors ) ;
+  TEST_ASSERT_EQUAL( 0, cmd.getCrcErrors() ) ;
+  TEST_ASSERT_GREATER_OR_EQUAL( MIN_FPS, fps ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  UNITY_BEGIN() ;
+  RUN_TEST( test_frame_is_executed_and_acked ) ;
+  RUN_TEST( test_bad_crc_is_not_executed ) ;
+  RUN_TEST( test_retransmit_is_acked_not_executed ) ;
+  RUN_TEST( test_same_seq_new_frame_is_executed ) ;
+  RUN_TEST( test_stalled_frame_is_dropped ) ;
+  RUN_TEST( test_slow_frame_within_the_timeout_is_kept ) ;
+  RUN_TEST( test_sink_takes_large_payloads ) ;
+  RUN_TEST( test_text_commands ) ;
+  RUN_TEST( test_pty_loopback_throughput ) ;
+  return UNITY_END() ;
+}
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+Compression of FrameCodec on frames from every routine on every board.
+
+Each board's routines are run on the host as in golden.py, every frame is
+dumped, and tools/frameenc encodes them in order, each frame against the one
+before as a host streaming over SC_CMD_FRAME_CODED would. Per routine:
+
+    ratio    SC_CMD_FRAME bytes (NUM_LEDS x 3) over coded bytes
+    avg max  packet size, average and largest
+    kB/s     link rate at 60 fps, SerialCommand's 7 bytes a frame included
+    formats  how often RAW, RLE, DELTA and PALETTE came out smallest
+
+    codec_bench.py                            every header in src/headers
+    codec_bench.py --board src/headers/Glowstaff.h --frames 300
+
+The ESP8266 UART at 230400 baud moves about 23 kB/s.
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+
+from framecheck import CheckError
+from golden import ROOT, board_name, boards, build, link
+
+CODEC = os.path.join(ROOT, "lib", "FrameCodec", "src")
+FRAMEENC = os.path.join(ROOT, "tools", "frameenc.cpp")
+
+FPS = 60
+LINK_OVERHEAD = 7   # SOF, seq, cmd, length, crc
+
+
+def build_frameenc(out, pool):
+    flags = [os.environ.get("CXX", "c++"), "-std=gnu++11", "-O1", "-w", "-I" + CODEC]
+    link(flags, [FRAMEENC, os.path.join(CODEC, "FrameCodec.cpp")], out, pool)
+
+
+def bench(exe, frameenc, frames):
+    """(name, frames, raw, coded, largest, formats) per routine, from frameenc -s."""
+    harness = subprocess.Popen([exe, str(frames), "*"], stdout=subprocess.PIPE)
+    try:
+        output = subprocess.check_output([frameenc, "-s"], stdin=harness.stdout, universal_newlines=True)
+    finally:
+        harness.stdout.close()
+        if harness.wait():
+            raise CheckError("harness exited with %d" % harness.returncode)
+    rows = []
+    for line in output.splitlines():
+        fields = line.split()
+        rows.append((fields[0],) + tuple(int(f) for f in fields[1:5]) + (" ".join(fields[5:]),))
+    return rows
+
+
+def row(name, frames, raw, coded, largest, formats=""):
+    return "%-14s %6.1f %6d %6d %6.1f  %s" % (name, float(raw) / coded, coded // frames, largest,
+                                             (coded / float(frames) + LINK_OVERHEAD) * FPS / 1000, formats)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--board", action="append", help="board header, e.g. src/headers/Hoop1.h (default: all)")
+    parser.add_argument("--frames", type=int, default=100, help="frames per routine (default 100)")
+    args = parser.parse_args(argv)
+
+    tmp = tempfile.mkdtemp(prefix="codec")
+    frameenc = os.path.join(tmp, "frameenc")
+
+    def one(board):
+        name = board_name(board)
+        exe = os.path.join(tmp, name)
+        try:
+            build(board, exe, compiler)
+            return name, bench(exe, frameenc, args.frames), None
+        except (CheckError, IOError, subprocess.CalledProcessError) as e:
+            return name, [], "%s" % e
+
+    try:
+        with ThreadPoolExecutor(os.cpu_count() or 4) as compiler, ThreadPoolExecutor(os.cpu_count() or 4) as pool:
+            build_frameenc(frameenc, compiler)
+            results = list(pool.map(one, args.board or boards()))
+    except CheckError as e:
+        print(e)
+        return 1
+    finally:
+        shutil.rmtree(tmp)
+
+    status = 0
+    total = [0, 0, 0, 0]
+    print("%-18s %-14s %6s %6s %6s %6s  %s" % ("", "", "ratio", "avg", "max", "kB/s", "formats"))
+    for name, rows, error in results:
+        if error:
+            print("%-18s %s" % (name, error))
+            status = 1
+            continue
+        board = [0, 0, 0, 0]
+        for r in rows:
+            print("%-18s %s" % (name, row(*r)))
+            board = [board[0] + r[1], board[1] + r[2], board[2] + r[3], max(board[3], r[4])]
+        if board[0]:
+            print("%-18s %s" % (name, row("all", *board)))
+        total = [total[0] + board[0], total[1] + board[1], total[2] + board[2], max(total[3], board[3])]
+    if total[0]:
+        print("%-18s %s" % ("all boards", row("all", *total)))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+Record and verify golden frames of the routines on a board built with
+FRAME_CHECK (see lib/FrameCheck/src/FrameCheck.h), over its serial port.
+
+    framecheck.py record --port /dev/ttyACM0 --board src/headers/Hoop1.h
+    framecheck.py verify --port /dev/ttyACM0 --board src/headers/Hoop1.h
+
+Reset the board before each run: routines keep state in statics, so runs
+only match when made in the same order from a fresh start.
+
+record writes golden/<Board>.txt, one routine per line with the hash of its
+run. verify runs them again and lists every routine whose hash changed, and
+exits 1 if there were any.
+
+A routine that is allowed to come out slightly different (a LUT or
+fixed-point version of a float kernel) gets a tolerance instead of a hash:
+edit its line in the golden file to
+
+    fire2012  ~1
+
+and record again. It is then kept as its frames, in golden/<Board>/fire2012.frames,
+and verify passes it if no channel of any frame is off by more than 1.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+GOLDEN = os.path.join(ROOT, "golden")
+
+
+class CheckError(Exception):
+    pass
+
+
+def command(port, line):
+    """Send a text command; return its output lines, up to the "ok"."""
+    port.reset_input_buffer()
+    port.write((line + "\n").encode("ascii"))
+    lines = []
+    while True:
+        reply = port.readline().decode("ascii", "replace").strip()
+        if not reply:
+            raise CheckError("'%s': no answer" % line)
+        if reply == "ok":
+            return lines
+        if reply == "err":
+            raise CheckError("'%s': rejected; is FRAME_CHECK on?" % line)
+        lines.append(reply)
+
+
+def run_all(port, frames):
+    hashes = {}
+    for line in command(port, "check %d" % frames):
+        name, value = line.split()
+        hashes[name] = value
+    return hashes
+
+
+def run_frames(port, name, frames):
+    lines = command(port, "check %s %d dump" % (name, frames))
+    return [bytes.fromhex(line) for line in lines[:-1]]
+
+
+def read_golden(path):
+    golden = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                fields = line.split("#", 1)[0].split()
+                if len(fields) == 2:
+                    golden[fields[0]] = fields[1]
+    return golden
+
+
+def frames_path(board, name, golden=GOLDEN):
+    return os.path.join(golden, board, name + ".frames")
+
+
+def tolerance(value):
+    m = re.match(r"~(\d+)$", value)
+    return int(m.group(1)) if m else None
+
+
+def max_error(frames, golden):
+    if len(frames) != len(golden) or any(len(a) != len(b) for a, b in zip(frames, golden)):
+        return None
+    return max([abs(a - b) for fa, fb in zip(frames, golden) for a, b in zip(fa, fb)] or [0])
+
+
+def record(port, board, frames):
+    path = os.path.join(GOLDEN, board + ".txt")
+    golden = read_golden(path)
+    hashes = run_all(port, frames)
+    with open(path, "w") as f:
+        f.write("# Made by tools/framecheck.py record, %d frames per routine\n" % frames)
+        for name, value in hashes.items():
+            if tolerance(golden.get(name, "")) is not None:
+                value = golden[name]
+                os.makedirs(os.path.join(GOLDEN, board), exist_ok=True)
+                with open(frames_path(board, name), "w") as ff:
+                    ff.write("\n".join(frame.hex() for frame in run_frames(port, name, frames)) + "\n")
+            f.write("%-14s %s\n" % (name, value))
+    print("%d routines recorded in %s" % (len(hashes), os.path.relpath(path, ROOT)))
+    return 0
+
+
+def verify(port, board, frames):
+    golden = read_golden(os.path.join(GOLDEN, board + ".txt"))
+    if not golden:
+        raise CheckError("no golden file for %s, record one first" % board)
+    hashes = run_all(port, frames)
+    failed = 0
+    for name, value in golden.items():
+        tol = tolerance(value)
+        if name not in hashes:
+            print("%-14s not built" % name)
+            failed += 1
+        elif tol is None:
+            if hashes[name] != value:
+                print("%-14s changed: %s, was %s" % (name, hashes[name], value))
+                failed += 1
+        else:
+            with open(frames_path(board, name)) as f:
+                expected = [bytes.fromhex(line.strip()) for line in f if line.strip()]
+            error = max_error(run_frames(port, name, len(expected)), expected)
+            if error is None or error > tol:
+                print("%-14s off by %s, allowed %d" % (name, "a whole frame" if error is None else error, tol))
+                failed += 1
+    for name in hashes:
+        if name not in golden:
+            print("%-14s new, not checked" % name)
+    print("%d of %d routines match" % (len(golden) - failed, len(golden)))
+    return 1 if failed else 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["record", "verify"])
+    parser.add_argument("--port", required=True)
+    parser.add_argument("--board", required=True, help="board header, e.g. src/headers/Hoop1.h")
+    parser.add_argument("--frames", type=int, default=100, help="frames per routine (default 100)")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args(argv)
+
+    import serial   # only here, so tools/golden.py can use the rest without pyserial
+
+    board = os.path.splitext(os.path.basename(args.board))[0]
+    try:
+        with serial.Serial(args.port, args.baud, timeout=10) as port:
+            if args.command == "record":
+                return record(port, board, args.frames)
+            return verify(port, board, args.frames)
+    except (CheckError, IOError) as e:
+        sys.stderr.write("%s\n" % e)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <FrameCodec.h>
+
+/*
+   Host side of FrameCodec: encodes frames the way a host streaming over
+   SC_CMD_FRAME_CODED would, each against the last one sent.
+
+     frameenc        < frames    one packet per frame, as hex
+     frameenc -s     < frames    per sequence: name, frames, bytes raw and coded,
+                                 largest packet, and how often each format won
+
+   Frames come one per line as hex RGB, as the "check <name> N dump" command and
+   test/golden's harness print them. Any other line (their "name hash") ends a
+   sequence and names it for -s; the next frame starts without a DELTA base, as
+   after a bad packet.
+
+   Every packet is decoded again and compared with its frame, so a codec bug
+   exits with 1 instead of showing up as a good ratio.
+*/
+
+static const char* formats[] = { "raw", "rle", "delta", "palette" } ;
+
+struct Stats
+{
+  unsigned long frames ;
+  unsigned long raw ;
+  unsigned long coded ;
+  unsigned long largest ;
+  unsigned long used[4] ;
+};
+
+static bool stats = false ;
+static Stats seq ;
+
+// Hex line to bytes; false if it isn't a frame
+static bool parseFrame( const char* line, std::vector<uint8_t>& frame ) {
+  size_t len = strlen( line ) ;
+  while ( len && isspace( (unsigned char) line[len - 1] ) ) len-- ;
+  if ( len == 0 || len % 6 != 0 ) return false ;
+  frame.resize( len / 2 ) ;
+  for ( size_t i = 0 ; i < len ; i += 2 ) {
+    if ( ! isxdigit( (unsigned char) line[i] ) || ! isxdigit( (unsigned char) line[i + 1] ) ) return false ;
+    char byte[3] = { line[i], line[i + 1], 0 } ;
+    frame[i / 2] = strtoul( byte, NULL, 16 ) ;
+  }
+  return true ;
+}
+
+static void endSequence( const char* line ) {
+  if ( stats && seq.frames ) {
+    char name[64] = "-" ;
+    sscanf( line, "%63s", name ) ;
+    printf( "%s %lu %lu %lu %lu", name, seq.frames, seq.raw, seq.coded, seq.largest ) ;
+    for ( uint8_t t = 0 ; t < 4 ; t++ ) printf( " %s=%lu", formats[t], seq.used[t] ) ;
+    printf( "\n" ) ;
+  }
+  memset( &seq, 0, sizeof(seq) ) ;
+}
+
+
+int main( int argc, char** argv ) {
+  stats = argc > 1 && strcmp( argv[1], "-s" ) == 0 ;
+
+  std::vector<char> line( 1 << 16 ) ;
+  std::vector<uint8_t> frame, prev, decoded, packet ;
+  bool havePrev = false ;
+  unsigned long lineNo = 0 ;
+
+  while ( fgets( line.data(), line.size(), stdin ) ) {
+    lineNo++ ;
+    if ( ! parseFrame( line.data(), frame ) ) {
+      endSequence( line.data() ) ;
+      havePrev = false ;
+      continue ;
+    }
+    uint16_t numLeds = frame.size() / 3 ;
+    if ( havePrev && prev.size() != frame.size() ) havePrev = false ;
+
+    packet.resize( 1 + frame.size() ) ;     // RAW always fits
+    uint16_t len = FrameCodec::encode( frame.data(), havePrev ? prev.data() : NULL, numLeds, packet.data(), packet.size() ) ;
+
+    decoded = havePrev ? prev : std::vector<uint8_t>( frame.size() ) ;
+    if ( len == 0 || ! FrameCodec::decode( packet.data(), len, decoded.data(), numLeds ) || decoded != frame ) {
+      fprintf( stderr, "frameenc: line %lu doesn't decode back to its frame\n", lineNo ) ;
+      return 1 ;
+    }
+
+    if ( stats ) {
+      seq.frames++ ;
+      seq.raw += frame.size() ;          // as SC_CMD_FRAME would send it
+      seq.coded += len ;
+      if ( len > seq.largest ) seq.largest = len ;
+      if ( packet[0] < 4 ) seq.used[packet[0]]++ ;
+    } else {
+      for ( uint16_t i = 0 ; i < len ; i++ ) printf( "%02x", packet[i] ) ;
+      printf( "\n" ) ;
+    }
+    prev = frame ;
+    havePrev = true ;
+  }
+  endSequence( "-" ) ;
+  return 0 ;
+}
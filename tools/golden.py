@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Golden frames of every routine on every board, on the host: no board, no
+serial port. For each board header the routines are built with the host
+compiler against the stand-ins in test/host, run the way the "check" serial
+command runs them (test/golden/golden.cpp), and their hashes compared with
+golden/host/<Board>.txt.
+
+    golden.py verify                 every header in src/headers
+    golden.py verify --board src/headers/Hoop1.h
+    golden.py record                 after a change that is meant to show
+
+These hashes only vouch for the host build: the stand-ins follow FastLED's
+C code, but floats and libm differ from the boards, so they are not the
+hashes a board prints (that is what tools/framecheck.py is for).
+
+Tolerances work as in framecheck.py: a routine whose line reads "~1" is kept
+as its frames, in golden/host/<Board>/<name>.frames, and passes if no channel
+is off by more than 1.
+
+$CXX picks the compiler, default c++. Objects are kept in $GOLDEN_CACHE
+(default gf-golden in the temp directory), so a second run only compiles
+what changed.
+"""
+
+import argparse
+import glob
+import hashlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
+
+from framecheck import CheckError, frames_path, max_error, read_golden, tolerance
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+GOLDEN = os.path.join(ROOT, "golden", "host")
+HEADERS = os.path.join(ROOT, "src", "headers")
+HARNESS = os.path.join(ROOT, "test", "golden")
+CACHE = os.environ.get("GOLDEN_CACHE", os.path.join(tempfile.gettempdir(), "gf-golden"))
+
+# What LEDRoutines needs, from lib/; the rest are hardware or the sketch's
+LIBS = ["LEDRoutines", "PixelLayout", "FrameQueue", "PowerLimiter", "DitherOutput", "Apa102Hd",
+        "ColorLut", "FrameGovernor", "OscillatorBank", "AudioInput", "PaletteSequencer",
+        "NoiseField", "KeyframeCurve", "ParticlePool", "FrameCheck", "Effects", "easing"]
+
+
+def boards():
+    return sorted(path for path in glob.glob(os.path.join(HEADERS, "*.h"))
+                  if os.path.basename(path) != "RoutineCatalog.h")
+
+
+def board_name(path):
+    return os.path.splitext(os.path.basename(path))[0]
+
+
+def sources():
+    """Include flags and sources: the harness, the stand-ins and LIBS."""
+    includes = ["-I" + HEADERS]
+    files = [os.path.join(HARNESS, "golden.cpp")]
+    for d in sorted(glob.glob(os.path.join(ROOT, "test", "host", "*"))):
+        includes.append("-I" + d)
+        files += sorted(glob.glob(os.path.join(d, "*.cpp")))
+    for lib in LIBS:
+        d = os.path.join(ROOT, "lib", lib, "src")
+        if not os.path.isdir(d):
+            d = os.path.join(ROOT, "lib", lib)
+        includes.append("-I" + d)
+        files += sorted(glob.glob(os.path.join(d, "*.c")) + glob.glob(os.path.join(d, "*.cpp")))
+    return includes, files
+
+
+def file_hash(path):
+    with open(path, "rb") as f:
+        return hashlib.sha1(f.read()).hexdigest()
+
+
+def compile_one(flags, source):
+    """Object for one source, from CACHE when it was built before.
+
+    Objects are named by the hash of their preprocessed text, so the
+    libraries that come out the same for every board are only compiled once.
+    A manifest per board and source lists the files it read, so a later run
+    that finds them all unchanged doesn't preprocess it again."""
+    name = os.path.basename(source)
+    manifest = os.path.join(CACHE, "%s-%s.json" % (name, hashlib.sha1("\0".join(flags + [source]).encode()).hexdigest()))
+    try:
+        with open(manifest) as f:
+            seen = json.load(f)
+        if os.path.exists(seen["object"]) and all(file_hash(path) == h for path, h in seen["files"].items()):
+            return seen["object"]
+    except (IOError, ValueError, KeyError):
+        pass
+
+    deps = "%s.%d.d" % (manifest, threading.get_ident())
+    try:
+        text = subprocess.check_output(flags + ["-E", "-P", "-MD", "-MF", deps, "-x", "c++", source],
+                                       stderr=subprocess.STDOUT)
+    except OSError as e:
+        raise CheckError("%s: %s" % (flags[0], e))
+    except subprocess.CalledProcessError as e:
+        raise CheckError("%s doesn't build:\n%s" % (name, e.output.decode(errors="replace")))
+    with open(deps) as f:
+        files = f.read().replace("\\\n", " ").split(":", 1)[1].split()
+    os.remove(deps)
+
+    key = hashlib.sha1(" ".join(flags).encode() + b"\0" + text).hexdigest()
+    obj = os.path.join(CACHE, "%s-%s.o" % (name, key))
+    if not os.path.exists(obj):
+        tmp = "%s.%d" % (obj, threading.get_ident())
+        try:
+            subprocess.check_output(flags + ["-c", "-x", "c++", source, "-o", tmp],
+                                    stderr=subprocess.STDOUT, universal_newlines=True)
+        except subprocess.CalledProcessError as e:
+            raise CheckError("%s doesn't build:\n%s" % (name, e.output))
+        os.replace(tmp, obj)
+    with open(manifest, "w") as f:
+        json.dump({"object": obj, "files": {path: file_hash(path) for path in files}}, f)
+    return obj
+
+
+def link(flags, files, out, pool):
+    """Compile 'files' through CACHE on 'pool' and link them into 'out'."""
+    os.makedirs(CACHE, exist_ok=True)
+    objects = list(pool.map(lambda source: compile_one(flags, source), files))
+    try:
+        subprocess.check_output([flags[0]] + objects + ["-o", out], stderr=subprocess.STDOUT, universal_newlines=True)
+    except subprocess.CalledProcessError as e:
+        raise CheckError("%s doesn't link:\n%s" % (os.path.basename(out), e.output))
+
+
+def build(board, out, pool):
+    includes, files = sources()
+    flags = [os.environ.get("CXX", "c++"), "-std=gnu++11", "-O0", "-w",
+             "-include", os.path.abspath(board), "-include", os.path.join(HARNESS, "HostBoard.h")] + includes
+    link(flags, files, out, pool)
+
+
+def run(exe, frames, dump=None):
+    """Output lines of the harness: "name hash" per routine, after dump's frames."""
+    cmd = [exe, str(frames)] + ([dump] if dump else [])
+    return subprocess.check_output(cmd, universal_newlines=True).splitlines()
+
+
+def run_all(exe, frames):
+    hashes = {}
+    for line in run(exe, frames):
+        name, value = line.split()
+        hashes[name] = value
+    return hashes
+
+
+def run_frames(exe, name, frames):
+    frames_out = []
+    for line in run(exe, frames, name):
+        if line.startswith(name + " "):
+            return frames_out
+        if len(line.split()) == 1:
+            frames_out.append(bytes.fromhex(line))
+    return frames_out
+
+
+def recorded_frames(path):
+    if os.path.exists(path):
+        with open(path) as f:
+            m = re.search(r"(\d+) frames per routine", f.readline())
+            if m:
+                return int(m.group(1))
+    return None
+
+
+def record(exe, board, frames):
+    path = os.path.join(GOLDEN, board + ".txt")
+    golden = read_golden(path)
+    hashes = run_all(exe, frames)
+    os.makedirs(GOLDEN, exist_ok=True)
+    with open(path, "w") as f:
+        f.write("# Made by tools/golden.py record, %d frames per routine\n" % frames)
+        for name, value in hashes.items():
+            if tolerance(golden.get(name, "")) is not None:
+                value = golden[name]
+                os.makedirs(os.path.join(GOLDEN, board), exist_ok=True)
+                with open(frames_path(board, name, GOLDEN), "w") as ff:
+                    ff.write("\n".join(frame.hex() for frame in run_frames(exe, name, frames)) + "\n")
+            f.write("%-14s %s\n" % (name, value))
+    return ["%d routines recorded" % len(hashes)], 0
+
+
+def verify(exe, board, frames):
+    path = os.path.join(GOLDEN, board + ".txt")
+    golden = read_golden(path)
+    if not golden:
+        raise CheckError("no golden file for %s, record one first" % board)
+    frames = recorded_frames(path) or frames
+    hashes = run_all(exe, frames)
+    lines = []
+    failed = 0
+    for name, value in golden.items():
+        tol = tolerance(value)
+        if name not in hashes:
+            lines.append("%-14s not built" % name)
+            failed += 1
+        elif tol is None:
+            if hashes[name] != value:
+                lines.append("%-14s changed: %s, was %s" % (name, hashes[name], value))
+                failed += 1
+        else:
+            with open(frames_path(board, name, GOLDEN)) as f:
+                expected = [bytes.fromhex(line.strip()) for line in f if line.strip()]
+            error = max_error(run_frames(exe, name, len(expected)), expected)
+            if error is None or error > tol:
+                lines.append("%-14s off by %s, allowed %d" % (name, "a whole frame" if error is None else error, tol))
+                failed += 1
+    for name in hashes:
+        if name not in golden:
+            lines.append("%-14s new, not checked" % name)
+    lines.append("%d of %d routines match" % (len(golden) - failed, len(golden)))
+    return lines, 1 if failed else 0
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["record", "verify"])
+    parser.add_argument("--board", action="append", help="board header, e.g. src/headers/Hoop1.h (default: all)")
+    parser.add_argument("--frames", type=int, default=100, help="frames per routine (default 100)")
+    args = parser.parse_args(argv)
+
+    tmp = tempfile.mkdtemp(prefix="golden")
+
+    def one(board):
+        name = board_name(board)
+        exe = os.path.join(tmp, name)
+        try:
+            build(board, exe, compiler)
+            if args.command == "record":
+                return name, record(exe, name, args.frames)
+            return name, verify(exe, name, args.frames)
+        except (CheckError, IOError, subprocess.CalledProcessError) as e:
+            return name, (["%s" % e], 1)
+
+    # Boards on one pool, their sources on another, so neither waits on the other
+    try:
+        with ThreadPoolExecutor(os.cpu_count() or 4) as compiler, ThreadPoolExecutor(os.cpu_count() or 4) as pool:
+            results = list(pool.map(one, args.board or boards()))
+    finally:
+        shutil.rmtree(tmp)
+
+    status = 0
+    for name, (lines, failed) in results:
+        for line in lines:
+            print("%-18s %s" % (name, line))
+        status |= failed
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+"""
+Compile and check playlists for the firmware (see lib/Playlist/src/Playlist.h).
+
+Text format, one entry per line, '#' starts a comment:
+
+    # routine   seconds   [bpm=120] [palette=ocean] [bright=40] [fade=1.5]
+    p_rb        30        bpm=120
+    p_user      60        palette=lava fade=2
+    twirl2      45        bright=60
+
+Routine names are resolved against src/headers/RoutineCatalog.h, run through
+the C preprocessor with the board header the way the firmware build does
+(-include <board>), so the ids match what that board was built with. The
+header carries a hash of that routine list; the firmware won't play a list
+made for a different one. $CPP picks the preprocessor, default cpp.
+
+    playlist.py compile  Hoop1.txt --board src/headers/Hoop1.h -o src/headers/playlists/Hoop1.h
+    playlist.py compile  Hoop1.txt --board src/headers/Hoop1.h --bin hoop1.bin
+    playlist.py validate Hoop1.txt --board src/headers/Hoop1.h
+    playlist.py validate hoop1.bin --board src/headers/Hoop1.h
+"""
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+
+VERSION = 2
+HEADER_SIZE = 8
+ENTRY_SIZE = 8
+KEEP = 0xFF
+# Same order as PLAYLIST_PALETTE_* in Playlist.h
+PALETTES = ["rainbow", "rainbowstripe", "cloud", "party", "ocean", "lava", "forest", "heat"]
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CATALOG = os.path.join(ROOT, "src", "headers", "RoutineCatalog.h")
+
+
+class PlaylistError(Exception):
+    pass
+
+
+def crc16(data):
+    """CRC-16/CCITT, init 0xFFFF, as SerialCommand::crc16()."""
+    crc = 0xFFFF
+    for c in data:
+        crc ^= c << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+
+def preprocess(board, source, *args):
+    cmd = [os.environ.get("CPP", "cpp"), "-P", "-include", os.path.abspath(board)] + list(args) + [source]
+    try:
+        return subprocess.check_output(cmd, universal_newlines=True)
+    except (OSError, subprocess.CalledProcessError) as e:
+        raise PlaylistError("%s: %s" % (" ".join(cmd), e))
+
+
+def board_defines(board):
+    """Macros the board header leaves defined, #if blocks and all, as the compiler sees them."""
+    defines = {}
+    for line in preprocess(board, os.devnull, "-dM").splitlines():
+        m = re.match(r"#define\s+(\w+)(?:\s+(.*))?", line)
+        if m:
+            defines[m.group(1)] = m.group(2)
+    return defines
+
+
+def board_routines(board, catalog=CATALOG):
+    """The routine table as the board sees it, in order."""
+    text = preprocess(board, catalog, "-DROUTINE(name,...)=@ROUTINE name")
+    routines = re.findall(r'@ROUTINE\s*"([^"]+)"', text)
+    if not routines:
+        raise PlaylistError("no routines found in %s" % catalog)
+    return routines
+
+
+def catalog_hash(routines):
+    """CRC-16 over the names, each with its 0, as catalogHash() in the sketch."""
+    return crc16(b"".join(name.encode() + b"\0" for name in routines))
+
+
+def parse_text(path, routines, defines):
+    max_bright = int(defines.get("MAX_BRIGHTNESS") or 255)
+    entries = []
+    with open(path) as f:
+        for num, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            where = "%s:%d" % (path, num)
+            if len(line) < 2:
+                raise PlaylistError("%s: need at least a routine and a duration" % where)
+
+            name, seconds = line[0], line[1].rstrip("s")
+            if name not in routines:
+                raise PlaylistError("%s: routine '%s' is not built for this board" % (where, name))
+            entry = {"routine": routines.index(name), "duration": number(seconds, where),
+                     "bpm": 0, "palette": KEEP, "brightness": 0, "transition": 0}
+
+            for opt in line[2:]:
+                key, _, value = opt.partition("=")
+                if key == "bpm":
+                    entry["bpm"] = int(round(float(value) * 10))
+                elif key == "palette":
+                    if value not in PALETTES:
+                        raise PlaylistError("%s: unknown palette '%s' (%s)" % (where, value, ", ".join(PALETTES)))
+                    entry["palette"] = PALETTES.index(value)
+                elif key == "bright":
+                    entry["brightness"] = number(value, where)
+                elif key == "fade":
+                    entry["transition"] = int(round(float(value) * 10))
+                else:
+                    raise PlaylistError("%s: unknown option '%s'" % (where, key))
+
+            for problem in check_entry(entry, routines, max_bright):
+                raise PlaylistError("%s: %s" % (where, problem))
+            entries.append(entry)
+    return entries
+
+
+def number(value, where):
+    try:
+        return int(value)
+    except ValueError:
+        raise PlaylistError("%s: '%s' is not a number" % (where, value))
+
+
+def check_entry(entry, routines, max_bright):
+    if not 0 <= entry["routine"] < len(routines):
+        yield "routine id %d out of range (board has %d)" % (entry["routine"], len(routines))
+    if not 1 <= entry["duration"] <= 0xFFFF:
+        yield "duration must be 1..65535 s"
+    if entry["bpm"] and not 200 <= entry["bpm"] <= 3000:
+        yield "bpm must be 20..300"
+    if entry["palette"] != KEEP and entry["palette"] >= len(PALETTES):
+        yield "palette id %d out of range" % entry["palette"]
+    if entry["brightness"] > max_bright:
+        yield "brightness %d is over MAX_BRIGHTNESS (%d)" % (entry["brightness"], max_bright)
+    if entry["transition"] > 255:
+        yield "fade must be 25.5 s or less"
+    if entry["transition"] and entry["transition"] / 10.0 >= entry["duration"]:
+        yield "fade is longer than the entry"
+
+
+def pack(entries, routines):
+    if not 1 <= len(entries) <= 255:
+        raise PlaylistError("a playlist has 1..255 entries, this one has %d" % len(entries))
+    body = b"".join(struct.pack("<BHHBBB", e["routine"], e["duration"], e["bpm"],
+                                e["palette"], e["brightness"], e["transition"]) for e in entries)
+    return b"PL" + struct.pack("<BBHH", VERSION, len(entries), crc16(body), catalog_hash(routines)) + body
+
+
+def unpack(data, routines):
+    if len(data) < HEADER_SIZE or data[:2] != b"PL":
+        raise PlaylistError("not a playlist")
+    version, count, crc, catalog = struct.unpack("<BBHH", data[2:HEADER_SIZE])
+    if version != VERSION:
+        raise PlaylistError("version %d, expected %d" % (version, VERSION))
+    if catalog != catalog_hash(routines):
+        raise PlaylistError("compiled for a different routine catalog; recompile it for this board")
+    body = data[HEADER_SIZE:HEADER_SIZE + count * ENTRY_SIZE]
+    if len(body) != count * ENTRY_SIZE:
+        raise PlaylistError("truncated: %d entries need %d bytes" % (count, count * ENTRY_SIZE))
+    if crc16(body) != crc:
+        raise PlaylistError("crc mismatch")
+    keys = ("routine", "duration", "bpm", "palette", "brightness", "transition")
+    return [dict(zip(keys, struct.unpack_from("<BHHBBB", body, i * ENTRY_SIZE))) for i in range(count)]
+
+
+def write_header(path, data, source, board):
+    rows = [", ".join("0x%02x" % b for b in data[i:i + 12]) for i in range(0, len(data), 12)]
+    with open(path, "w") as f:
+        f.write("// Made by tools/playlist.py from %s for %s. Don't edit, recompile.\n" % (source, board))
+        f.write("const uint8_t PlaylistData[] PROGMEM = {\n  %s\n} ;\n" % ",\n  ".join(rows))
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["compile", "validate"])
+    parser.add_argument("playlist", help="text playlist, or a compiled .bin to validate")
+    parser.add_argument("--board", required=True, help="board header, e.g. src/headers/Hoop1.h")
+    parser.add_argument("-o", "--output", help="C header to write (PROGMEM)")
+    parser.add_argument("--bin", help="raw image to write (EEPROM / SC_CMD_PLAYLIST upload)")
+    args = parser.parse_args(argv)
+
+    try:
+        defines = board_defines(args.board)
+        routines = board_routines(args.board)
+        if args.playlist.endswith(".bin"):
+            with open(args.playlist, "rb") as f:
+                entries = unpack(f.read(), routines)
+            max_bright = int(defines.get("MAX_BRIGHTNESS") or 255)
+            for i, entry in enumerate(entries):
+                for problem in check_entry(entry, routines, max_bright):
+                    raise PlaylistError("entry %d: %s" % (i, problem))
+        else:
+            entries = parse_text(args.playlist, routines, defines)
+        data = pack(entries, routines)
+    except (PlaylistError, IOError) as e:
+        sys.stderr.write("%s\n" % e)
+        return 1
+
+    if args.command == "compile":
+        if args.output:
+            write_header(args.output, data, os.path.basename(args.playlist), os.path.basename(args.board))
+        if args.bin:
+            with open(args.bin, "wb") as f:
+                f.write(data)
+
+    total = sum(e["duration"] for e in entries)
+    print("%d entries, %d:%02d per loop, %d bytes" % (len(entries), total // 60, total % 60, len(data)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
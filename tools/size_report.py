@@ -0,0 +1,119 @@
+"""
+PlatformIO post-build script: after linking, print what the board's firmware
+is made of, and fail the build if it is over the board's budget.
+
+    [env:teensylc_hoop]
+    build_flags = ... -fstack-usage
+    extra_scripts = post:tools/size_report.py
+    custom_flash_budget = 63488
+    custom_ram_budget = 7168
+
+Per routine it lists the code, the tables in flash (const arrays, palettes)
+and the static state in RAM, from the linked .elf. Routines left out of
+RoutineCatalog.h by the board header are dropped by the linker
+(--gc-sections), so only the ones actually built are listed. With
+-fstack-usage the compiler also writes each function's stack frame to a .su
+file next to its object; those are listed as well.
+
+The RAM budget should leave room for the stack: the report only sees what
+the linker placed.
+"""
+
+import os
+import re
+import subprocess
+
+Import("env")
+
+# Global tables and buffers at least this big are listed on their own
+BIG_SYMBOL = 128
+
+
+def tool(name):
+    # Every platform sets SIZETOOL (arm-none-eabi-size, xtensa-lx106-elf-size);
+    # OBJCOPY isn't always objcopy (esptool on the ESP8266)
+    return re.sub(r"size(\.exe)?$", name + r"\1", env.subst("$SIZETOOL"))
+
+
+def run(*args):
+    return subprocess.check_output(args).decode("utf-8", "replace")
+
+
+def totals(elf):
+    """(flash, ram) as berkeley size counts them: .data is in both, its initial values live in flash."""
+    text, data, bss = [int(x) for x in run(tool("size"), "-B", elf).splitlines()[1].split()[:3]]
+    return text + data, data + bss
+
+
+def symbols(elf):
+    for line in run(tool("nm"), "-C", "-S", "--size-sort", elf).splitlines():
+        m = re.match(r"[0-9a-f]+ ([0-9a-f]+) (\w) (.*)", line)
+        if m:
+            yield int(m.group(1), 16), m.group(2).lower(), m.group(3)
+
+
+def stack_frames(build_dir):
+    """Function -> stack frame in bytes, from the .su files of -fstack-usage."""
+    frames = {}
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if not name.endswith(".su"):
+                continue
+            with open(os.path.join(root, name)) as f:
+                for line in f:
+                    fields = line.rstrip("\n").split("\t")
+                    if len(fields) >= 2 and fields[1].isdigit():
+                        m = re.search(r"LEDRoutines::(\w+)\(", fields[0])
+                        if m:
+                            frames[m.group(1)] = max(frames.get(m.group(1), 0), int(fields[1]))
+    return frames
+
+
+def budget(name):
+    value = env.GetProjectOption("custom_%s_budget" % name, "")
+    return int(value, 0) if value else None
+
+
+def size_report(source, target, env):
+    elf = str(source[0])
+    flash, ram = totals(elf)
+
+    # code / flash tables / RAM statics per LEDRoutines method; a function's
+    # local statics show up as LEDRoutines::fire2012()::heat
+    routines = {}
+    others = []
+    for size, kind, name in symbols(elf):
+        m = re.match(r"LEDRoutines::(\w+)\(", name)
+        if m:
+            row = routines.setdefault(m.group(1), [0, 0, 0])
+            if kind in "tw" and "::" not in name.split(")", 1)[1]:
+                row[0] += size
+            elif kind == "r":
+                row[1] += size
+            elif kind in "bdv":
+                row[2] += size
+        elif kind in "rbd" and size >= BIG_SYMBOL:
+            others.append((size, kind, name))
+
+    frames = stack_frames(env.subst("$BUILD_DIR"))
+
+    print("Size report for %s: %d bytes flash, %d bytes RAM" % (env.subst("$PIOENV"), flash, ram))
+    print("  %6s %6s %6s %6s  routine" % ("code", "table", "static", "stack"))
+    for name, (code, table, static) in sorted(routines.items(), key=lambda r: -sum(r[1])):
+        stack = frames.get(name)
+        print("  %6d %6d %6d %6s  %s" % (code, table, static, stack if stack is not None else "-", name))
+    print("  Tables and buffers of %d bytes or more:" % BIG_SYMBOL)
+    for size, kind, name in sorted(others, reverse=True):
+        print("  %6d %-5s  %s" % (size, "flash" if kind == "r" else "RAM", name))
+
+    over = []
+    if budget("flash") is not None and flash > budget("flash"):
+        over.append("flash %d > %d" % (flash, budget("flash")))
+    if budget("ram") is not None and ram > budget("ram"):
+        over.append("RAM %d > %d" % (ram, budget("ram")))
+    if over:
+        print("Error: %s is over budget: %s" % (env.subst("$PIOENV"), ", ".join(over)))
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)